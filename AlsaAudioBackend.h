@@ -0,0 +1,356 @@
+#ifndef ALSAAUDIOBACKEND_H
+#define ALSAAUDIOBACKEND_H
+
+#include <QString>
+
+// Period sizes the ALSA backend accepts: small enough for low latency,
+// large enough that a period outlasts the I/O thread's wakeup
+const int MIN_ALSA_PERIOD_FRAMES = 64;
+const int MAX_ALSA_PERIOD_FRAMES = 256;
+
+// Settings for the direct ALSA backend. Always defined, so the command
+// line accepts them in builds without ALSA too.
+struct AlsaDeviceOptions {
+    QString captureDevice = "plughw:0,0";
+    QString playbackDevice = "plughw:0,0";
+    int periodFrames = 128; // MIN_ALSA_PERIOD_FRAMES..MAX_ALSA_PERIOD_FRAMES
+    int periods = 2;        // Per device buffer
+    bool realtime = true;   // SCHED_FIFO for the I/O thread, when permitted
+};
+
+#ifdef VOICECHANGER_ALSA
+
+#include <QAudioFormat>
+#include <QIODevice>
+
+#include <alsa/asoundlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "AudioBackend.h"
+#include "dsp/CallbackStats.h"
+
+// Capture and playback straight through ALSA in mmap mode.
+//
+// Both streams are opened with small periods (AlsaDeviceOptions), 16-bit
+// interleaved, and linked with snd_pcm_link() so they start and recover
+// together. One I/O thread sleeps on the capture stream; each period it
+// copies the captured frames out of the mmap area into the capture device,
+// pulls the same number of frames from the playback device and copies them
+// into the playback mmap area. The playback buffer is primed with silence,
+// so the round trip through the hardware is one buffer plus one period.
+// Devices with more than one channel are read from their first channel and
+// written to all of them.
+//
+// An xrun (EPIPE) or suspend (ESTRPIPE) drops both streams, re-primes and
+// restarts them; xruns are counted. The interval between wakeups is kept
+// in a CallbackStats, and statusReport() compares it with the nominal
+// period. ALSA's `null` PCM, or a `file` PCM on top of it, runs the whole
+// path without hardware (see the README).
+class AlsaAudioBackend : public AudioBackend {
+public:
+    explicit AlsaAudioBackend(const AlsaDeviceOptions& options)
+        : options(options), rate(0), linked(false), running(false), xruns(0) {}
+
+    ~AlsaAudioBackend() override {
+        stop();
+        closeDevices();
+    }
+
+    const char* name() const override { return "alsa"; }
+
+    // Both streams run in one period loop, so they must agree on rate
+    bool open(const QAudioFormat& requested, QAudioFormat* capture, QAudioFormat* playback) override {
+        closeDevices();
+        rate = static_cast<unsigned int>(requested.sampleRate());
+        if (!openStream(options.captureDevice, SND_PCM_STREAM_CAPTURE, &captureStream, &rate))
+            return false;
+        unsigned int playbackRate = rate;
+        if (!openStream(options.playbackDevice, SND_PCM_STREAM_PLAYBACK, &playbackStream, &playbackRate))
+            return false;
+        if (playbackRate != rate || playbackStream.period != captureStream.period) {
+            error = QString::asprintf("ALSA capture runs at %u Hz / %lu frames but playback at %u Hz / %lu frames",
+                                      rate, static_cast<unsigned long>(captureStream.period), playbackRate,
+                                      static_cast<unsigned long>(playbackStream.period));
+            closeDevices();
+            return false;
+        }
+        // Without a link (e.g. different cards) both are started by hand
+        linked = snd_pcm_link(captureStream.pcm, playbackStream.pcm) == 0;
+        block.resize(captureStream.period);
+
+        QAudioFormat format = requested;
+        format.setSampleRate(static_cast<int>(rate));
+        format.setChannelCount(1);
+        format.setSampleSize(16);
+        format.setSampleType(QAudioFormat::SignedInt);
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        format.setCodec("audio/pcm");
+        *capture = *playback = format;
+        return true;
+    }
+
+    bool start(QIODevice* captureDevice, QIODevice* playbackDevice) override {
+        if (!captureStream.pcm || running.load(std::memory_order_relaxed))
+            return false;
+        capture = captureDevice;
+        playback = playbackDevice;
+        wakeups.reset();
+        xruns.store(0, std::memory_order_relaxed);
+        if (!startStreams())
+            return false;
+        running.store(true, std::memory_order_release);
+        thread = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() override {
+        running.store(false, std::memory_order_release);
+        if (thread.joinable())
+            thread.join();
+    }
+
+    quint64 deviceXruns() const override {
+        return xruns.load(std::memory_order_relaxed);
+    }
+
+    QString statusReport() const override {
+        if (!captureStream.pcm)
+            return QString();
+        CallbackStats::Summary s = wakeups.summary();
+        const double periodMs = captureStream.period * 1000.0 / rate;
+        return QString::asprintf("ALSA %u Hz, %lu-frame periods (%.2f ms) x %lu, %u/%u channels, %s\n"
+                                 "Period wakeups avg %.2f, p99 %.2f, max %.2f ms; %llu xruns",
+                                 rate, static_cast<unsigned long>(captureStream.period), periodMs,
+                                 static_cast<unsigned long>(captureStream.buffer / captureStream.period),
+                                 captureStream.channels, playbackStream.channels,
+                                 linked ? "linked" : "not linked", s.avgUs * 1e-3, s.p99Us * 1e-3,
+                                 s.maxUs * 1e-3, static_cast<unsigned long long>(xruns.load(std::memory_order_relaxed)));
+    }
+
+private:
+    struct Stream {
+        snd_pcm_t* pcm = nullptr;
+        unsigned int channels = 0;
+        snd_pcm_uframes_t period = 0;
+        snd_pcm_uframes_t buffer = 0;
+    };
+
+    bool openStream(const QString& device, snd_pcm_stream_t direction, Stream* stream, unsigned int* streamRate) {
+        const char* what = direction == SND_PCM_STREAM_CAPTURE ? "capture" : "playback";
+        int err = snd_pcm_open(&stream->pcm, device.toStdString().c_str(), direction, 0);
+        if (err < 0) {
+            stream->pcm = nullptr;
+            return fail(what, device, "open", err);
+        }
+
+        snd_pcm_hw_params_t* hw;
+        snd_pcm_hw_params_alloca(&hw);
+        snd_pcm_hw_params_any(stream->pcm, hw);
+        if ((err = snd_pcm_hw_params_set_access(stream->pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0)
+            return fail(what, device, "mmap access", err);
+        if ((err = snd_pcm_hw_params_set_format(stream->pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0)
+            return fail(what, device, "16-bit samples", err);
+        stream->channels = 1;
+        if ((err = snd_pcm_hw_params_set_channels_near(stream->pcm, hw, &stream->channels)) < 0)
+            return fail(what, device, "channel count", err);
+        if ((err = snd_pcm_hw_params_set_rate_near(stream->pcm, hw, streamRate, nullptr)) < 0)
+            return fail(what, device, "sample rate", err);
+        stream->period = static_cast<snd_pcm_uframes_t>(options.periodFrames);
+        if ((err = snd_pcm_hw_params_set_period_size_near(stream->pcm, hw, &stream->period, nullptr)) < 0)
+            return fail(what, device, "period size", err);
+        unsigned int periods = static_cast<unsigned int>(options.periods);
+        if ((err = snd_pcm_hw_params_set_periods_near(stream->pcm, hw, &periods, nullptr)) < 0)
+            return fail(what, device, "period count", err);
+        if ((err = snd_pcm_hw_params(stream->pcm, hw)) < 0)
+            return fail(what, device, "hardware parameters", err);
+        snd_pcm_hw_params_get_period_size(hw, &stream->period, nullptr);
+        snd_pcm_hw_params_get_buffer_size(hw, &stream->buffer);
+
+        // Wake once per period; the streams are only ever started by hand
+        snd_pcm_sw_params_t* sw;
+        snd_pcm_sw_params_alloca(&sw);
+        snd_pcm_sw_params_current(stream->pcm, sw);
+        snd_pcm_uframes_t boundary = 0;
+        snd_pcm_sw_params_get_boundary(sw, &boundary);
+        snd_pcm_sw_params_set_avail_min(stream->pcm, sw, stream->period);
+        snd_pcm_sw_params_set_start_threshold(stream->pcm, sw, boundary);
+        if ((err = snd_pcm_sw_params(stream->pcm, sw)) < 0)
+            return fail(what, device, "software parameters", err);
+        return true;
+    }
+
+    bool fail(const char* what, const QString& device, const char* step, int err) {
+        error = QString::asprintf("ALSA %s device '%s': %s failed: %s", what, device.toStdString().c_str(),
+                                  step, snd_strerror(err));
+        closeDevices();
+        return false;
+    }
+
+    void closeDevices() {
+        for (Stream* stream : { &captureStream, &playbackStream }) {
+            if (stream->pcm)
+                snd_pcm_close(stream->pcm);
+            *stream = Stream();
+        }
+        linked = false;
+    }
+
+    // Prepares both streams, fills the playback buffer with silence and
+    // starts them together
+    bool startStreams() {
+        int err;
+        if ((err = snd_pcm_prepare(captureStream.pcm)) < 0 || (err = snd_pcm_prepare(playbackStream.pcm)) < 0) {
+            error = QString::asprintf("ALSA prepare failed: %s", snd_strerror(err));
+            return false;
+        }
+        snd_pcm_uframes_t primed = 0;
+        while (primed < playbackStream.buffer) {
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset, frames = playbackStream.buffer - primed;
+            if (snd_pcm_mmap_begin(playbackStream.pcm, &areas, &offset, &frames) < 0 || frames == 0)
+                break;
+            snd_pcm_areas_silence(areas, offset, playbackStream.channels, frames, SND_PCM_FORMAT_S16_LE);
+            if (snd_pcm_mmap_commit(playbackStream.pcm, offset, frames) < 0)
+                break;
+            primed += frames;
+        }
+        if ((err = snd_pcm_start(captureStream.pcm)) < 0
+            || (!linked && (err = snd_pcm_start(playbackStream.pcm)) < 0)) {
+            error = QString::asprintf("ALSA start failed: %s", snd_strerror(err));
+            return false;
+        }
+        return true;
+    }
+
+    // After an xrun or a suspend: drop both, re-prime and restart
+    void recover(int err) {
+        xruns.fetch_add(1, std::memory_order_relaxed);
+        if (err == -ESTRPIPE) {
+            for (snd_pcm_t* pcm : { captureStream.pcm, playbackStream.pcm }) {
+                while (snd_pcm_resume(pcm) == -EAGAIN)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        snd_pcm_drop(captureStream.pcm);
+        if (!linked)
+            snd_pcm_drop(playbackStream.pcm);
+        startStreams();
+    }
+
+    void run() {
+        if (options.realtime) {
+            sched_param param;
+            param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+            pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        }
+
+        const snd_pcm_uframes_t period = captureStream.period;
+        std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+        bool first = true;
+        while (running.load(std::memory_order_acquire)) {
+            int ready = snd_pcm_wait(captureStream.pcm, 100);
+            if (ready < 0) {
+                recover(ready);
+                first = true;
+                continue;
+            }
+            if (ready == 0)
+                continue;
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (!first)
+                wakeups.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count()));
+            last = now;
+            first = false;
+
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(captureStream.pcm);
+            if (avail < 0) {
+                recover(static_cast<int>(avail));
+                first = true;
+                continue;
+            }
+            for (; avail >= static_cast<snd_pcm_sframes_t>(period); avail -= period) {
+                int err = transfer(captureStream, period, true);
+                if (err >= 0) {
+                    capture->write(reinterpret_cast<const char*>(block.data()), static_cast<qint64>(period) * 2);
+                    playback->read(reinterpret_cast<char*>(block.data()), static_cast<qint64>(period) * 2);
+                    err = transfer(playbackStream, period, false);
+                }
+                if (err < 0) {
+                    recover(err);
+                    first = true;
+                    break;
+                }
+            }
+        }
+        snd_pcm_drop(captureStream.pcm);
+        if (!linked)
+            snd_pcm_drop(playbackStream.pcm);
+    }
+
+    // Moves `count` frames between `block` and the stream's mmap area:
+    // channel 0 on capture, every channel on playback
+    int transfer(const Stream& stream, snd_pcm_uframes_t count, bool input) {
+        if (!input) {
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(stream.pcm);
+            if (avail < 0)
+                return static_cast<int>(avail);
+            // Playback fell behind capture; drop what does not fit
+            count = std::min(count, static_cast<snd_pcm_uframes_t>(avail));
+        }
+        snd_pcm_uframes_t done = 0;
+        while (done < count) {
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset, frames = count - done;
+            int err = snd_pcm_mmap_begin(stream.pcm, &areas, &offset, &frames);
+            if (err < 0)
+                return err;
+            if (frames == 0)
+                return -EPIPE;
+            const size_t stride = areas[0].step / 16;
+            int16_t* base = reinterpret_cast<int16_t*>(static_cast<char*>(areas[0].addr) + areas[0].first / 8)
+                          + offset * stride;
+            for (snd_pcm_uframes_t i = 0; i < frames; ++i) {
+                if (input) {
+                    block[done + i] = base[i * stride];
+                } else {
+                    for (unsigned int c = 0; c < stream.channels; ++c)
+                        base[i * stride + c] = block[done + i];
+                }
+            }
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(stream.pcm, offset, frames);
+            if (committed < 0)
+                return static_cast<int>(committed);
+            if (committed != static_cast<snd_pcm_sframes_t>(frames))
+                return -EPIPE;
+            done += frames;
+        }
+        return 0;
+    }
+
+    AlsaDeviceOptions options;
+    unsigned int rate;
+    Stream captureStream;
+    Stream playbackStream;
+    bool linked;
+    QIODevice* capture = nullptr;
+    QIODevice* playback = nullptr;
+    std::vector<qint16> block;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<quint64> xruns;
+    CallbackStats wakeups; // Interval between period wakeups
+};
+
+#endif // VOICECHANGER_ALSA
+
+#endif // ALSAAUDIOBACKEND_H
@@ -0,0 +1,104 @@
+#ifndef AUDIOBACKEND_H
+#define AUDIOBACKEND_H
+
+#include <QAudioDeviceInfo>
+#include <QAudioFormat>
+#include <QAudioInput>
+#include <QAudioOutput>
+#include <QIODevice>
+#include <QString>
+#include <QDebug>
+
+// Where live audio comes from and goes to.
+//
+// open() negotiates a format close to the requested one for each stream;
+// the two may differ, in rate or otherwise, and the engine bridges them.
+// start()
+// then drives the two devices the engine hands over: captured audio is
+// written into `capture` and playback audio is read from `playback`, in
+// whatever callback sizes and on whatever clock the backend has. The
+// engine owns both devices, and calls every method on its audio thread.
+class AudioBackend {
+public:
+    virtual ~AudioBackend() {}
+
+    virtual const char* name() const = 0;
+
+    // Fills `capture` and `playback` with the formats the streams will run at
+    virtual bool open(const QAudioFormat& requested, QAudioFormat* capture, QAudioFormat* playback) = 0;
+    virtual bool start(QIODevice* capture, QIODevice* playback) = 0;
+    virtual void stop() = 0;
+
+    virtual QString errorString() const { return error; }
+
+    // Device-side timing and error counters, for logs; may be empty
+    virtual QString statusReport() const { return QString(); }
+
+    // Dropouts the device saw since start(); 0 if it cannot tell
+    virtual quint64 deviceXruns() const { return 0; }
+
+protected:
+    QString error;
+};
+
+// The default devices through Qt Multimedia. Qt calls the capture device
+// as input arrives and pulls playback as its buffer drains; both buffers
+// are `bufferBytes` deep.
+class QtAudioBackend : public AudioBackend {
+public:
+    explicit QtAudioBackend(int bufferBytes = 4096)
+        : bufferBytes(bufferBytes), audioInput(nullptr), audioOutput(nullptr) {}
+
+    ~QtAudioBackend() override {
+        stop();
+        delete audioInput;
+        delete audioOutput;
+    }
+
+    const char* name() const override { return "qt"; }
+
+    // Each device gets its own nearest format; neither is bent to the other's
+    bool open(const QAudioFormat& requested, QAudioFormat* capture, QAudioFormat* playback) override {
+        inputInfo = QAudioDeviceInfo::defaultInputDevice();
+        *capture = requested;
+        if (!inputInfo.isFormatSupported(requested)) {
+            qWarning() << "Default format not supported by the input, trying to use the nearest.";
+            *capture = inputInfo.nearestFormat(requested);
+        }
+
+        outputInfo = QAudioDeviceInfo::defaultOutputDevice();
+        *playback = requested;
+        if (!outputInfo.isFormatSupported(requested)) {
+            qWarning() << "Default format not supported by the output, trying to use the nearest.";
+            *playback = outputInfo.nearestFormat(requested);
+        }
+
+        audioInput = new QAudioInput(inputInfo, *capture);
+        audioInput->setBufferSize(bufferBytes);
+        audioOutput = new QAudioOutput(outputInfo, *playback);
+        audioOutput->setBufferSize(bufferBytes);
+        return true;
+    }
+
+    bool start(QIODevice* capture, QIODevice* playback) override {
+        audioOutput->start(playback);
+        audioInput->start(capture);
+        return true;
+    }
+
+    void stop() override {
+        if (audioInput)
+            audioInput->stop();
+        if (audioOutput)
+            audioOutput->stop();
+    }
+
+private:
+    int bufferBytes;
+    QAudioDeviceInfo inputInfo;
+    QAudioDeviceInfo outputInfo;
+    QAudioInput* audioInput;
+    QAudioOutput* audioOutput;
+};
+
+#endif // AUDIOBACKEND_H
@@ -0,0 +1,77 @@
+#ifndef AUDIODEVICES_H
+#define AUDIODEVICES_H
+
+#include <QIODevice>
+#include <QtGlobal>
+
+#include "AudioProcessor.h"
+#include "dsp/LivePath.h"
+
+// Write-only device QAudioInput pushes captured audio into. The work is
+// CaptureCallback's (dsp/LivePath.h): queue the samples in the jitter
+// buffer, converted and bridged to the playback rate as needed.
+class CaptureSink : public QIODevice {
+    Q_OBJECT
+public:
+    CaptureSink(SampleJitterBuffer* buffer, CallbackMonitor* monitor, const FormatConverter& converter,
+                PolyphaseResampler* bridge = nullptr, QObject* parent = nullptr)
+        : QIODevice(parent), callback(buffer, monitor, converter, bridge) {}
+
+    bool isSequential() const override {
+        return true;
+    }
+
+protected:
+    qint64 readData(char*, qint64) override {
+        return -1;
+    }
+
+    qint64 writeData(const char* data, qint64 len) override {
+        callback.process(data, static_cast<size_t>(len) / callback.bytesPerFrame());
+        return len;
+    }
+
+private:
+    CaptureCallback callback;
+};
+
+// Read-only device QAudioOutput pulls playback audio from. The work is
+// PlaybackCallback's (dsp/LivePath.h), which always fills the full request,
+// so the output never stalls into the idle state.
+class PlaybackSource : public QIODevice {
+    Q_OBJECT
+public:
+    PlaybackSource(LiveChain* chain, SampleJitterBuffer* buffer,
+                   DriftCompensator* compensator, AudioParameters* parameters,
+                   CallbackMonitor* monitor, int sampleRate, const FormatConverter& converter,
+                   QObject* parent = nullptr)
+        : QIODevice(parent),
+          callback(chain, buffer, compensator, parameters, monitor, sampleRate, converter) {}
+
+    bool isSequential() const override {
+        return true;
+    }
+
+    // Applies the current settings snapshot; call on the audio thread
+    // before the output starts
+    void syncParameters() {
+        callback.syncParameters();
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override {
+        const size_t bytesPerFrame = callback.bytesPerFrame();
+        const size_t frames = static_cast<size_t>(maxlen) / bytesPerFrame;
+        callback.process(data, frames);
+        return static_cast<qint64>(frames * bytesPerFrame);
+    }
+
+    qint64 writeData(const char*, qint64) override {
+        return -1;
+    }
+
+private:
+    PlaybackCallback callback;
+};
+
+#endif // AUDIODEVICES_H
@@ -0,0 +1,373 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QAudioFormat>
+#include <QMetaObject>
+#include <QObject>
+#include <QThread>
+#include <QDebug>
+
+#if defined(Q_OS_UNIX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "AlsaAudioBackend.h"
+#include "AudioBackend.h"
+#include "AudioDevices.h"
+#include "AudioProcessor.h"
+#include "VirtualAudioBackend.h"
+
+// Which device the engine runs on
+struct AudioBackendOptions {
+    QString name = "qt";                // qt, virtual or alsa
+    VirtualDeviceOptions virtualDevice; // Used by "virtual"
+    AlsaDeviceOptions alsaDevice;       // Used by "alsa"
+};
+
+// Whether createAudioBackend() knows `name` in this build
+inline bool audioBackendAvailable(const QString& name)
+{
+#ifdef VOICECHANGER_ALSA
+    if (name == "alsa")
+        return true;
+#endif
+    return name == "qt" || name == "virtual";
+}
+
+// Null for an unknown name
+inline AudioBackend* createAudioBackend(const AudioBackendOptions& options)
+{
+    if (options.name == "qt")
+        return new QtAudioBackend;
+    if (options.name == "virtual")
+        return new VirtualAudioBackend(options.virtualDevice);
+#ifdef VOICECHANGER_ALSA
+    if (options.name == "alsa")
+        return new AlsaAudioBackend(options.alsaDevice);
+#endif
+    return nullptr;
+}
+
+// Owns the capture -> jitter buffer -> DSP -> playback path. Lives on the
+// audio thread: the backend and its devices are created there on the
+// first start(), so their notifications and the processor callbacks run on
+// that thread's event loop and never wait behind GUI repaints.
+class AudioWorker : public QObject {
+    Q_OBJECT
+public:
+    AudioWorker(const QString& chainSpec, AudioParameters* parameters,
+                SampleJitterBuffer* jitter, DriftCompensator* compensator,
+                CallbackMonitors* monitors, bool realtimeScheduling,
+                const AudioBackendOptions& backendOptions = AudioBackendOptions())
+        : chainSpec(chainSpec), parameters(parameters), jitter(jitter), compensator(compensator), monitors(monitors),
+          realtime(realtimeScheduling), backendOptions(backendOptions),
+          prioritySet(false), streamRate(SAMPLE_RATE), inputRate(SAMPLE_RATE), backend(nullptr),
+          processor(nullptr), capture(nullptr), playback(nullptr), bridge(nullptr) {}
+
+    // Negotiated playback rate, which the chain runs at; safe to read from any thread
+    int sampleRate() const { return streamRate.load(std::memory_order_relaxed); }
+
+    // Negotiated capture rate; differs from sampleRate() if the devices disagree
+    int captureRate() const { return inputRate.load(std::memory_order_relaxed); }
+
+    // Delay of the capture resampler, in playback frames; 0 without one
+    double bridgeLatency() const { return bridgeDelay.load(std::memory_order_relaxed); }
+
+    // Algorithmic delay of the chain, in samples
+    qint64 chainLatency() const { return chainDelay.load(std::memory_order_relaxed); }
+
+    // Null until the first start(); audio thread only
+    AudioBackend* audioBackend() const { return backend; }
+
+public slots:
+    void start() {
+        if (!prioritySet) {
+            raisePriority();
+            prioritySet = true;
+        }
+        if (!processor && !createDevices())
+            return;
+
+        // Devices are stopped, so neither side of the jitter buffer is running
+        jitter->reset();
+        compensator->reset();
+        if (bridge)
+            bridge->reset();
+        monitors->capture.reset();
+        monitors->playback.reset();
+        playback->syncParameters();
+        capture->open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+        playback->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+        if (!backend->start(capture, playback)) {
+            qWarning() << "Cannot start the" << backend->name() << "audio backend:" << backend->errorString();
+            return;
+        }
+        qDebug() << "Voice Changer Started.";
+    }
+
+    void stop() {
+        if (!processor)
+            return;
+        backend->stop();
+        capture->close();
+        playback->close();
+        // The callbacks only count heap violations; say so now they are done
+        monitors->capture.reportViolations(stderr);
+        monitors->playback.reportViolations(stderr);
+        qDebug() << "Voice Changer Stopped.";
+    }
+
+    QString backendReport() const {
+        return backend ? backend->statusReport() : QString();
+    }
+
+    quint64 deviceXruns() const {
+        return backend ? backend->deviceXruns() : 0;
+    }
+
+    // Stops and destroys the devices on the thread that created them
+    void shutdown() {
+        stop();
+        delete backend;
+        delete capture;
+        delete playback;
+        delete processor;
+        delete bridge;
+        backend = nullptr;
+        capture = nullptr;
+        playback = nullptr;
+        processor = nullptr;
+        bridge = nullptr;
+    }
+
+private:
+    bool createDevices() {
+        // Setup Audio Format
+        QAudioFormat format;
+        format.setSampleRate(SAMPLE_RATE);
+        format.setChannelCount(CHANNELS);
+        format.setSampleSize(SAMPLE_SIZE);
+        format.setCodec("audio/pcm");
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        format.setSampleType(QAudioFormat::SignedInt);
+
+        // The backend settles on the nearest format each device supports
+        backend = createAudioBackend(backendOptions);
+        if (!backend) {
+            qWarning() << "Unknown audio backend" << backendOptions.name << "- using qt";
+            backend = new QtAudioBackend;
+        }
+        QAudioFormat captureFormat, playbackFormat;
+        if (!backend->open(format, &captureFormat, &playbackFormat)) {
+            qWarning() << "Cannot open the" << backend->name() << "audio backend:" << backend->errorString();
+            delete backend;
+            backend = nullptr;
+            return false;
+        }
+
+        // Frames convert to and from the path's mono samples in whatever
+        // layout was negotiated; the converters are fixed for the stream
+        FormatConverter captureConverter, playbackConverter;
+        if (!selectConverter(captureFormat, "input", &captureConverter)
+            || !selectConverter(playbackFormat, "output", &playbackConverter)) {
+            delete backend;
+            backend = nullptr;
+            return false;
+        }
+
+        // Everything after the jitter buffer runs at the playback rate; a
+        // capture device on another rate is resampled on the way in
+        if (captureFormat.sampleRate() != playbackFormat.sampleRate()) {
+            bridge = new PolyphaseResampler;
+            if (!bridge->configure(captureFormat.sampleRate(), playbackFormat.sampleRate())) {
+                qWarning() << "Cannot convert" << captureFormat.sampleRate() << "Hz capture to"
+                           << playbackFormat.sampleRate() << "Hz playback";
+                delete bridge;
+                delete backend;
+                bridge = nullptr;
+                backend = nullptr;
+                return false;
+            }
+            qDebug() << "Resampling capture from" << bridge->inRate() << "to" << bridge->outRate() << "Hz,"
+                     << bridge->phases() << "phases of" << bridge->tapsPerPhase() << "taps";
+        }
+        bridgeDelay.store(bridge ? bridge->latency() : 0.0, std::memory_order_relaxed);
+        inputRate.store(captureFormat.sampleRate(), std::memory_order_relaxed);
+
+        // Initialize Audio Processor
+        processor = new AudioProcessor(playbackFormat);
+        if (!processor->setChain(chainSpec)) {
+            qWarning() << "Invalid effect chain:" << processor->chainError() << "- using the default";
+            processor->setChain(DEFAULT_CHAIN_SPEC);
+        }
+        chainDelay.store(processor->latency(), std::memory_order_relaxed);
+        streamRate.store(playbackFormat.sampleRate(), std::memory_order_relaxed);
+        compensator->setSampleRate(playbackFormat.sampleRate());
+
+        // Capture and playback meet in the jitter buffer, not in one device
+        capture = new CaptureSink(jitter, &monitors->capture, captureConverter, bridge);
+        playback = new PlaybackSource(processor, jitter, compensator, parameters,
+                                      &monitors->playback, playbackFormat.sampleRate(), playbackConverter);
+        return true;
+    }
+
+    bool selectConverter(const QAudioFormat& format, const char* side, FormatConverter* converter) {
+        if (!deviceFormatConverter(format, converter)) {
+            qWarning() << "The" << backend->name() << side << "settled on an unsupported format:"
+                       << format.sampleType() << format.sampleSize() << "bits," << format.channelCount()
+                       << "channels";
+            return false;
+        }
+        qDebug() << "Audio" << side << "runs" << sampleFormatName(converter->format).c_str() << "at"
+                 << format.sampleRate() << "Hz, converting with" << simdLevelName(converter->level);
+        return true;
+    }
+
+    // Optionally moves this thread to SCHED_FIFO; needs CAP_SYS_NICE or
+    // an rtprio limit, and silently keeps the Qt priority otherwise.
+    void raisePriority() {
+#if defined(Q_OS_UNIX)
+        if (!realtime)
+            return;
+        sched_param param;
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+            qDebug() << "Audio thread running with SCHED_FIFO priority" << param.sched_priority;
+        else
+            qDebug() << "SCHED_FIFO not permitted, using time-critical thread priority";
+#endif
+    }
+
+    QString chainSpec;
+    AudioParameters* parameters;
+    SampleJitterBuffer* jitter;
+    DriftCompensator* compensator;
+    CallbackMonitors* monitors;
+    bool realtime;
+    AudioBackendOptions backendOptions;
+    bool prioritySet;
+    std::atomic<int> streamRate;
+    std::atomic<int> inputRate;
+    std::atomic<qint64> chainDelay{0};
+    std::atomic<double> bridgeDelay{0.0};
+    AudioBackend* backend;
+    AudioProcessor* processor;
+    CaptureSink* capture;
+    PlaybackSource* playback;
+    PolyphaseResampler* bridge;
+};
+
+// Snapshot of the live latency budget and jitter buffer health
+struct LatencyStats {
+    double bufferedMs;   // Currently queued between capture and playback
+    double targetMs;
+    double chainMs;      // Algorithmic delay of the DSP chain
+    double bridgeMs;     // Capture resampling delay, if the device rates differ
+    double driftPpm;     // Playback resampling correction for clock drift
+    quint64 underruns;
+    quint64 overruns;
+    quint64 corrections; // Backlog trimmed back to the target
+    quint64 paddedFrames;
+    quint64 droppedFrames;
+};
+
+// Snapshot of the callback instrumentation since the last start()
+struct CallbackReport {
+    CallbackStats::Summary capture;
+    CallbackStats::Summary playback;
+    quint64 heapViolations; // Steady-state callbacks that touched the heap
+};
+
+// GUI-side handle to the audio thread.
+//
+// start()/stop() are queued onto the audio thread; live settings go as
+// whole snapshots through setParameters(), which is lock-free, and
+// latencyStats() and callbackReport() only read atomics. The GUI never
+// touches the devices or the processor directly.
+class AudioEngine : public QObject {
+    Q_OBJECT
+public:
+    explicit AudioEngine(const QString& chainSpec = DEFAULT_CHAIN_SPEC,
+                         bool realtimeScheduling = true,
+                         const AudioBackendOptions& backend = AudioBackendOptions(),
+                         QObject* parent = nullptr)
+        : QObject(parent), jitter(JITTER_BUFFER_FRAMES, 0), compensator(&jitter, SAMPLE_RATE),
+          worker(new AudioWorker(chainSpec, &params, &jitter, &compensator, &monitors,
+                                 realtimeScheduling, backend))
+    {
+        audioThread.setObjectName("audio");
+        worker->moveToThread(&audioThread);
+        audioThread.start(QThread::TimeCriticalPriority);
+    }
+
+    ~AudioEngine() {
+        QMetaObject::invokeMethod(worker, "shutdown", Qt::BlockingQueuedConnection);
+        audioThread.quit();
+        audioThread.wait();
+        delete worker;
+    }
+
+    void start() {
+        QMetaObject::invokeMethod(worker, "start", Qt::QueuedConnection);
+    }
+
+    void stop() {
+        QMetaObject::invokeMethod(worker, "stop", Qt::QueuedConnection);
+    }
+
+    // Publishes a new settings snapshot to the audio thread; GUI thread only
+    void setParameters(const ParameterSnapshot& snapshot) { params.write(snapshot); }
+
+    LatencyStats latencyStats() const {
+        SampleJitterBuffer::Stats s = jitter.stats();
+        double msPerFrame = 1000.0 / worker->sampleRate();
+        LatencyStats stats;
+        stats.bufferedMs = s.fillFrames * msPerFrame;
+        stats.targetMs = s.targetFrames * msPerFrame;
+        stats.chainMs = worker->chainLatency() * msPerFrame;
+        stats.bridgeMs = worker->bridgeLatency() * msPerFrame;
+        stats.driftPpm = compensator.correctionPpm();
+        stats.underruns = s.underruns;
+        stats.overruns = s.overruns;
+        stats.corrections = s.corrections;
+        stats.paddedFrames = s.paddedFrames;
+        stats.droppedFrames = s.droppedFrames;
+        return stats;
+    }
+
+    // The backend's own timing and error counters; blocks on the audio thread
+    QString backendReport() const {
+        QString report;
+        QMetaObject::invokeMethod(worker, "backendReport", Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(QString, report));
+        return report;
+    }
+
+    // Dropouts the backend saw since start(); blocks on the audio thread
+    quint64 deviceXruns() const {
+        quint64 xruns = 0;
+        QMetaObject::invokeMethod(worker, "deviceXruns", Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(quint64, xruns));
+        return xruns;
+    }
+
+    CallbackReport callbackReport() const {
+        CallbackReport report;
+        report.capture = monitors.capture.summary();
+        report.playback = monitors.playback.summary();
+        report.heapViolations = monitors.capture.violations() + monitors.playback.violations();
+        return report;
+    }
+
+private:
+    AudioParameters params;
+    SampleJitterBuffer jitter;
+    DriftCompensator compensator;
+    CallbackMonitors monitors;
+    QThread audioThread;
+    AudioWorker* worker;
+};
+
+#endif // AUDIOENGINE_H
@@ -0,0 +1,90 @@
+#ifndef AUDIOPROCESSOR_H
+#define AUDIOPROCESSOR_H
+
+#include <QAudioFormat>
+#include <QDebug>
+#include <QObject>
+#include <QString>
+#include <QtGlobal>
+
+#include "dsp/FormatConvert.h"
+#include "dsp/LivePath.h"
+#include "dsp/SampleConvert.h"
+
+// Constants for pitch shifting
+const int SAMPLE_RATE = 44100; // 44.1 kHz
+const int CHANNELS = 1;        // Mono
+const int SAMPLE_SIZE = 16;    // 16 bits per sample
+
+// Picks the device <-> mono converter for a negotiated stream format, with
+// this machine's best kernels. False for anything but linear PCM in one of
+// the layouts FormatConvert.h knows.
+inline bool deviceFormatConverter(const QAudioFormat& format, FormatConverter* converter) {
+    if (format.codec() != "audio/pcm")
+        return false;
+    SampleFormat sampleFormat;
+    switch (format.sampleType()) {
+    case QAudioFormat::SignedInt: sampleFormat.encoding = SampleEncoding::Signed; break;
+    case QAudioFormat::UnSignedInt: sampleFormat.encoding = SampleEncoding::Unsigned; break;
+    case QAudioFormat::Float: sampleFormat.encoding = SampleEncoding::Float; break;
+    default: return false;
+    }
+    sampleFormat.bits = format.sampleSize();
+    sampleFormat.bigEndian = format.byteOrder() == QAudioFormat::BigEndian;
+    sampleFormat.channels = format.channelCount();
+    return formatConverter(sampleFormat, detectSimdLevel(), converter);
+}
+
+// The effect chain and its live controls (LiveChain) for a Qt stream.
+// The playback source renders through it in place on float blocks
+// (render()); the offline renderer hands it 16-bit mono blocks
+// (process()). It holds no queue of its own: whatever goes in comes out
+// in the same call.
+//
+// The stages come from an EffectChain built from a text description (see
+// parseChainSpec) by setChain(); until then the chain is empty and audio
+// passes through unchanged, so an IR is only loaded for the chain in use.
+class AudioProcessor : public QObject, public LiveChain {
+    Q_OBJECT
+public:
+    AudioProcessor(QAudioFormat format, QObject* parent = nullptr)
+        : QObject(parent), format(format),
+          converter(defaultSampleConverter()) {}
+
+    // Rebuilds the chain for the stream's rate; only while no audio is
+    // flowing. On failure the previous chain stays and chainError() says why.
+    bool setChain(const QString& spec) {
+        return build(spec.toStdString(), format.sampleRate());
+    }
+
+    QString chainError() const {
+        return QString::fromStdString(chainErrorString());
+    }
+
+    // Algorithmic delay of the chain, in samples
+    qint64 latency() const {
+        return static_cast<qint64>(chainLatency());
+    }
+
+    // Runs the chain on `count` 16-bit mono samples
+    void process(const qint16* in, qint16* out, int count) {
+        float block[PROCESS_CHUNK];
+        for (int offset = 0; offset < count; offset += PROCESS_CHUNK) {
+            int n = qMin(PROCESS_CHUNK, count - offset);
+
+            // Convert to float
+            converter.toFloat(in + offset, block, n);
+
+            render(block, n);
+
+            // Convert back to 16-bit, saturating at full scale
+            converter.toInt16(block, out + offset, n);
+        }
+    }
+
+private:
+    QAudioFormat format;
+    SampleConverter converter;
+};
+
+#endif // AUDIOPROCESSOR_H
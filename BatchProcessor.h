@@ -0,0 +1,239 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "OfflineRenderer.h"
+
+// Per-worker job deques. A worker pops its own jobs from the back and,
+// once it runs dry, steals from the front of the other workers' deques,
+// so a few long files cannot leave the rest of the pool idle.
+class WorkStealingQueues {
+public:
+    explicit WorkStealingQueues(int workers) {
+        for (int i = 0; i < workers; ++i)
+            queues.emplace_back(new Queue);
+    }
+
+    void push(int worker, size_t job) {
+        Queue& queue = *queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+
+    // Next job for `worker`; false once every deque is empty.
+    bool pop(int worker, size_t* job) {
+        {
+            Queue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                *job = own.jobs.back();
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+        const int count = static_cast<int>(queues.size());
+        for (int i = 1; i < count; ++i) {
+            Queue& victim = *queues[(worker + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                *job = victim.jobs.front();
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> jobs;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+// One file to render and where it goes, relative to the output directory
+struct BatchInput {
+    QString path;
+    QString outputName;
+};
+
+struct BatchResult {
+    QString input;
+    QString output;
+    bool ok = false;
+    QString error;
+    double audioSeconds = 0.0;
+    double processSeconds = 0.0;
+};
+
+// Renders many files in parallel. Every worker thread owns its own
+// OfflineRenderer, so no DSP state is shared between threads, and each
+// file is streamed in fixed-size blocks.
+class BatchProcessor {
+public:
+    BatchProcessor(const OfflineOptions& options, int threads)
+        : options(options), threads(std::max(1, threads)), wallSeconds(0.0) {}
+
+    // Expands directories (recursively, *.wav) and list files into inputs.
+    // Files found under a directory keep their path below it in the output
+    // directory; files named directly or in the list go to its top level.
+    static std::vector<BatchInput> collectInputs(const QStringList& paths, const QString& listFile) {
+        std::vector<BatchInput> inputs;
+        if (!listFile.isEmpty()) {
+            QFile list(listFile);
+            if (list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                QTextStream stream(&list);
+                while (!stream.atEnd()) {
+                    QString line = stream.readLine().trimmed();
+                    if (!line.isEmpty() && !line.startsWith("#"))
+                        inputs.push_back({ line, outputName(QFileInfo(line).fileName()) });
+                }
+            } else {
+                qWarning() << "Cannot read file list" << listFile;
+            }
+        }
+        for (const QString& path : paths) {
+            if (QFileInfo(path).isDir()) {
+                QDir root(path);
+                QDirIterator it(path, QStringList() << "*.wav" << "*.WAV",
+                                QDir::Files, QDirIterator::Subdirectories);
+                while (it.hasNext()) {
+                    QString file = it.next();
+                    inputs.push_back({ file, outputName(root.relativeFilePath(file)) });
+                }
+            } else {
+                inputs.push_back({ path, outputName(QFileInfo(path).fileName()) });
+            }
+        }
+        return inputs;
+    }
+
+    // Renders every input to its own output file. Inputs that would write
+    // the same file (compared without case, as on the filesystems that fold
+    // it) are all failed up front instead of racing for it, and so is any
+    // input whose output is itself or another input: opening the output
+    // truncates it while it is still to be read.
+    std::vector<BatchResult> run(const std::vector<BatchInput>& inputs, const QString& outputDir) {
+        std::vector<BatchResult> results(inputs.size());
+        QDir outDir(outputDir);
+        QHash<QString, size_t> claimed;
+        QHash<QString, size_t> sources;
+        std::vector<bool> rejected(inputs.size(), false);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            QString source = QFileInfo(inputs[i].path).canonicalFilePath();
+            if (!source.isEmpty())
+                sources.insert(source.toLower(), i);
+        }
+        for (size_t i = 0; i < results.size(); ++i) {
+            results[i].input = inputs[i].path;
+            results[i].output = QDir::cleanPath(outDir.absoluteFilePath(inputs[i].outputName));
+            QString existing = QFileInfo(results[i].output).canonicalFilePath().toLower();
+            if (!existing.isEmpty() && sources.contains(existing)) {
+                rejected[i] = true;
+                results[i].error = "output " + results[i].output + " would overwrite input "
+                                 + inputs[sources.value(existing)].path;
+            }
+            QString key = results[i].output.toLower();
+            if (!claimed.contains(key)) {
+                claimed.insert(key, i);
+                continue;
+            }
+            size_t first = claimed.value(key);
+            rejected[i] = rejected[first] = true;
+            results[i].error = "output " + results[i].output + " is also the output of " + results[first].input;
+            results[first].error = "output " + results[first].output + " is also the output of " + results[i].input;
+        }
+
+        std::vector<size_t> jobs;
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (!rejected[i]) {
+                outDir.mkpath(QFileInfo(results[i].output).path());
+                jobs.push_back(i);
+            }
+        }
+        const int workers = std::min<int>(threads, std::max<int>(1, static_cast<int>(jobs.size())));
+        WorkStealingQueues queues(workers);
+        for (size_t j = 0; j < jobs.size(); ++j)
+            queues.push(static_cast<int>(j % workers), jobs[j]);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int w = 0; w < workers; ++w) {
+            pool.emplace_back([this, w, &queues, &results] {
+                OfflineRenderer renderer(options);
+                size_t job;
+                while (queues.pop(w, &job))
+                    renderOne(renderer, &results[job]);
+            });
+        }
+        for (std::thread& worker : pool)
+            worker.join();
+        wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return results;
+    }
+
+    // Wall-clock time of the last run()
+    double elapsedSeconds() const { return wallSeconds; }
+
+    // Per-file timings followed by the aggregate speed; returns failures.
+    int printReport(const std::vector<BatchResult>& results, QTextStream& out) const {
+        double audio = 0.0;
+        int failures = 0;
+        for (const BatchResult& r : results) {
+            if (!r.ok) {
+                out << "FAILED " << r.input << ": " << r.error << "\n";
+                ++failures;
+                continue;
+            }
+            audio += r.audioSeconds;
+            out << QString::asprintf("%8.2f s audio %8.3f s %8.1fx  ", r.audioSeconds,
+                                     r.processSeconds, r.audioSeconds / std::max(r.processSeconds, 1e-9))
+                << r.input << "\n";
+        }
+        out << QString::asprintf("%d files, %d failed, %.2f s audio in %.3f s on %d threads: %.1fx realtime\n",
+                                 static_cast<int>(results.size()), failures, audio, wallSeconds, threads,
+                                 audio / std::max(wallSeconds, 1e-9));
+        out.flush();
+        return failures;
+    }
+
+private:
+    // `relativePath` with its extension replaced by .wav
+    static QString outputName(const QString& relativePath) {
+        QFileInfo file(relativePath);
+        return QDir::cleanPath(file.path() + "/" + file.completeBaseName() + ".wav");
+    }
+
+    static void renderOne(OfflineRenderer& renderer, BatchResult* result) {
+        auto start = std::chrono::steady_clock::now();
+        result->ok = renderer.render(result->input, result->output);
+        result->processSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (result->ok)
+            result->audioSeconds = static_cast<double>(renderer.framesRendered()) / renderer.sampleRate();
+        else
+            result->error = renderer.errorString();
+    }
+
+    OfflineOptions options;
+    int threads;
+    double wallSeconds;
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,222 @@
+#ifndef LATENCYMETER_H
+#define LATENCYMETER_H
+
+#include <QAudioFormat>
+#include <QString>
+#include <QTextStream>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <vector>
+
+#include "AudioDevices.h"
+#include "AudioProcessor.h"
+#include "VirtualAudioBackend.h"
+#include "dsp/LatencyProbe.h"
+
+// Settings for a round-trip measurement
+struct LatencyMeterOptions {
+    QString chain = DEFAULT_CHAIN_SPEC;
+    int sampleRate = SAMPLE_RATE;
+    int periodFrames = 1024;       // Frames per capture/playback callback
+    int inputBufferFrames = 2048;  // setBufferSize(4096) at 16-bit mono
+    int outputBufferFrames = 2048;
+    int targetLatencyMs = 40;      // Jitter buffer depth
+};
+
+// One chain stage: what it reports and what the probe saw
+struct StageLatency {
+    QString name;
+    qint64 reportedFrames;
+    DelayEstimate measured;
+};
+
+// Where the round trip goes, in frames. The device buffers are the
+// configured sizes, and a captured block reaches the engine only once its
+// whole period is recorded; the jitter buffer's share is what was queued
+// ahead of each captured block when playback pulled it.
+struct LatencyReport {
+    int sampleRate;
+    int periodFrames;
+    qint64 inputBufferFrames;
+    qint64 outputBufferFrames;
+    double jitterFrames;
+    qint64 resamplerFrames;
+    qint64 chainReportedFrames;
+    DelayEstimate transport; // The loop with an empty chain
+    DelayEstimate total;     // The loop with the configured chain
+    std::vector<StageLatency> stages;
+};
+
+// Measures end-to-end latency without sound hardware.
+//
+// A probe (see makeLatencyProbe) is fed as microphone input through the
+// live path - CaptureSink, the jitter buffer, the drift compensator, the
+// AudioProcessor chain and PlaybackSource - on a VirtualAudioBackend whose
+// capture and playback run on the same clock without jitter, so the device
+// buffers act as delays of their configured size. The played-back stream is
+// cross-correlated with the probe. The loop runs once with an empty chain,
+// which measures the transport exactly, and once with the real chain; each
+// chain stage is also measured alone against its reported latency().
+class LatencyMeter {
+public:
+    bool measure(const LatencyMeterOptions& options, LatencyReport* report) {
+        report->sampleRate = options.sampleRate;
+        report->periodFrames = options.periodFrames;
+        report->inputBufferFrames = options.inputBufferFrames;
+        report->outputBufferFrames = options.outputBufferFrames;
+        report->resamplerFrames = 2; // DriftResampler lookahead
+        report->stages.clear();
+
+        EffectChain chain;
+        if (!chain.build(options.chain.toStdString(), options.sampleRate)) {
+            error = QString::fromStdString(chain.errorString());
+            return false;
+        }
+        report->chainReportedFrames = static_cast<qint64>(chain.latency());
+        const size_t maxStageDelay = static_cast<size_t>(options.sampleRate);
+        for (size_t i = 0; i < chain.size(); ++i) {
+            StageLatency stage;
+            stage.name = QString::fromStdString(chain.stageName(i));
+            stage.reportedFrames = static_cast<qint64>(chain.stage(i)->latency());
+            stage.measured = measureStageDelay(*chain.stage(i), options.sampleRate, maxStageDelay);
+            report->stages.push_back(stage);
+        }
+
+        return runLoop(QString(), options, &report->transport, &report->jitterFrames)
+            && runLoop(options.chain, options, &report->total, nullptr);
+    }
+
+    QString errorString() const { return error; }
+
+    static void print(const LatencyReport& report, QTextStream& out) {
+        const double msPerFrame = 1000.0 / report.sampleRate;
+        auto line = [&](const char* name, double frames) {
+            out << QString::asprintf("  %-28s %8.0f frames %8.1f ms\n", name, frames, frames * msPerFrame);
+        };
+        auto measured = [&](const char* name, const DelayEstimate& estimate) {
+            out << QString::asprintf("  %-28s %8zu frames %8.1f ms  (%s, confidence %.2f)\n", name,
+                                     estimate.samples, estimate.samples * msPerFrame,
+                                     estimate.envelope ? "envelope" : "waveform", estimate.confidence);
+        };
+
+        out << QString::asprintf("Round trip at %d Hz, %d-frame callbacks, simulated loopback\n\n",
+                                 report.sampleRate, report.periodFrames);
+        line("Capture device buffer", report.inputBufferFrames);
+        line("Capture period", report.periodFrames);
+        line("Jitter buffer (queued)", report.jitterFrames);
+        line("Drift resampler", report.resamplerFrames);
+        line("Playback device buffer", report.outputBufferFrames);
+        double transport = report.inputBufferFrames + report.periodFrames + report.jitterFrames
+                         + report.resamplerFrames + report.outputBufferFrames;
+        line("Transport, expected", transport);
+        measured("Transport, measured", report.transport);
+
+        out << QString::asprintf("\n  %-28s %8s %15s\n", "DSP stage", "reports", "measured");
+        for (const StageLatency& stage : report.stages) {
+            out << QString::asprintf("    %-26s %8lld %8zu frames  (%s, confidence %.2f)\n",
+                                     qPrintable(stage.name), static_cast<long long>(stage.reportedFrames),
+                                     stage.measured.samples,
+                                     stage.measured.envelope ? "envelope" : "waveform",
+                                     stage.measured.confidence);
+        }
+        line("Chain, reported", report.chainReportedFrames);
+
+        out << "\n";
+        line("Total, expected", report.transport.samples + report.chainReportedFrames);
+        measured("Total, measured", report.total);
+        out << "\nFilters add their group delay to the measured figures. Pitch-shifted\n"
+               "paths are matched by envelope, to within a few ms.\n";
+    }
+
+private:
+    // One pass of the probe around the loop with `chainSpec`; optionally
+    // returns the average jitter buffer lead
+    bool runLoop(const QString& chainSpec, const LatencyMeterOptions& options,
+                 DelayEstimate* estimate, double* jitterFrames) {
+        const int rate = options.sampleRate;
+        const size_t period = static_cast<size_t>(options.periodFrames);
+
+        QAudioFormat format;
+        format.setSampleRate(rate);
+        format.setChannelCount(1);
+        format.setSampleSize(16);
+        format.setCodec("audio/pcm");
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        format.setSampleType(QAudioFormat::SignedInt);
+
+        // Microphone: the probe, then silence while it comes back around
+        std::vector<float> probe = makeLatencyProbe(rate);
+        VirtualDeviceOptions device;
+        device.capture.periodFrames = period;
+        device.playback.periodFrames = period;
+        device.inputBufferFrames = options.inputBufferFrames;
+        device.outputBufferFrames = options.outputBufferFrames;
+        device.loopInput = false;
+        device.record = true;
+        device.realtime = false;
+        for (float sample : probe)
+            device.input.push_back(floatToInt16Sample(sample));
+        VirtualAudioBackend backend(device);
+        QAudioFormat playbackFormat;
+        if (!backend.open(format, &format, &playbackFormat)) {
+            error = backend.errorString();
+            return false;
+        }
+
+        FormatConverter converter;
+        deviceFormatConverter(format, &converter); // The virtual device is always 16-bit mono
+        AudioProcessor processor(format);
+        if (!processor.setChain(chainSpec)) {
+            error = processor.chainError();
+            return false;
+        }
+        SampleJitterBuffer jitter(JITTER_BUFFER_FRAMES, 0);
+        DriftCompensator compensator(&jitter, rate);
+        AudioParameters parameters;
+        ParameterSnapshot snapshot;
+        snapshot.targetLatencyMs = options.targetLatencyMs;
+        parameters.write(snapshot);
+        CallbackMonitors monitors;
+        CaptureSink capture(&jitter, &monitors.capture, converter);
+        PlaybackSource playback(&processor, &jitter, &compensator, &parameters, &monitors.playback, rate,
+                                converter);
+        playback.syncParameters();
+        capture.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+        playback.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        backend.start(&capture, &playback);
+
+        const size_t maxDelay = options.inputBufferFrames + options.outputBufferFrames + period
+                              + 2 * jitter.targetFrames() + 2 * processor.latency() + rate;
+        const size_t frames = options.outputBufferFrames + probe.size() + maxDelay;
+        double leadSum = 0.0;
+        size_t leadCount = 0;
+        while (backend.recording().size() < frames) {
+            // The newest block starts behind everything queued before it
+            bool pull = backend.peek().side == VirtualClock::Side::Playback;
+            double lead = static_cast<double>(jitter.fillFrames()) - static_cast<double>(period);
+            backend.step();
+            if (pull && !jitter.isPriming()) {
+                leadSum += lead;
+                ++leadCount;
+            }
+        }
+        backend.stop();
+        monitors.capture.reportViolations(stderr);
+        monitors.playback.reportViolations(stderr);
+        if (jitterFrames)
+            *jitterFrames = leadCount ? std::max(0.0, leadSum / leadCount) : 0.0;
+
+        std::vector<float> speaker;
+        for (qint16 sample : backend.recording())
+            speaker.push_back(sample * (1.0f / 32768.0f));
+        *estimate = estimateDelay(probe, speaker, maxDelay, rate);
+        if (estimate->confidence < 0.5)
+            *estimate = estimateDelay(probe, speaker, maxDelay, rate, true);
+        return true;
+    }
+
+    QString error;
+};
+
+#endif // LATENCYMETER_H
@@ -0,0 +1,133 @@
+#ifndef OFFLINERENDERER_H
+#define OFFLINERENDERER_H
+
+#include <QAudioFormat>
+#include <QString>
+#include <QtGlobal>
+#include <QDebug>
+
+#include <algorithm>
+#include <vector>
+
+#include "AudioProcessor.h"
+#include "WavFile.h"
+
+// Processing settings shared by the file-based modes
+struct OfflineOptions {
+    QString chain = DEFAULT_CHAIN_SPEC;
+    AudioProcessor::PitchEngine engine = AudioProcessor::ConfiguredPitch;
+    bool formants = false;
+    double formantShift = 1.0;
+    int blockFrames = 4096;
+};
+
+// Streams a WAV file through the same AudioProcessor the live path uses
+// and writes the result as 16-bit mono WAV.
+//
+// Input is read, processed and written one block at a time, so memory use
+// does not depend on the file length. The chain's algorithmic latency is
+// compensated: the first latency() output samples are dropped and the
+// chain is flushed with as many samples of silence after the input ends,
+// so output lines up with input and has the same length. A file that ends
+// before its header says fails; a streamed one (no length in the header)
+// is read to its end. No QApplication or audio device is involved.
+class OfflineRenderer {
+public:
+    explicit OfflineRenderer(const OfflineOptions& options = OfflineOptions())
+        : options(options), frames(0), rate(0) {}
+
+    bool render(const QString& inputPath, const QString& outputPath) {
+        frames = 0;
+        WavReader reader;
+        if (!reader.open(inputPath.toStdString()))
+            return fail(QString::fromStdString(reader.errorString()));
+        rate = reader.sampleRate(); // The chain is built for the file's own rate
+        if (reader.channels() > 1)
+            qWarning() << inputPath << "has" << reader.channels() << "channels, mixing down to mono";
+
+        QAudioFormat format;
+        format.setSampleRate(rate);
+        format.setChannelCount(1);
+        format.setSampleSize(16);
+        format.setCodec("audio/pcm");
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        format.setSampleType(QAudioFormat::SignedInt);
+
+        AudioProcessor processor(format);
+        if (!processor.setChain(options.chain))
+            return fail(processor.chainError());
+        processor.setPitchEngine(options.engine);
+        if (options.formants)
+            processor.setFormantPreservation(true, options.formantShift);
+
+        WavWriter writer;
+        if (!writer.open(outputPath.toStdString(), rate, 1))
+            return fail(QString::fromStdString(writer.errorString()));
+
+        const int block = options.blockFrames;
+        std::vector<qint16> input(block, 0);
+        std::vector<qint16> output(block);
+        qint64 skip = processor.latency();
+        qint64 tail = processor.latency();
+        qint64 read = 0;
+        bool ended = false;
+
+        while (true) {
+            size_t count = ended ? 0 : reader.readMono(input.data(), block);
+            if (count == 0) {
+                if (!ended) {
+                    ended = true;
+                    if (reader.lengthKnown() && static_cast<quint64>(read) < reader.frameCount())
+                        return fail(inputPath + QString::asprintf(
+                            " is truncated: %lld of %llu frames", static_cast<long long>(read),
+                            static_cast<unsigned long long>(reader.frameCount())));
+                }
+                if (tail == 0)
+                    break;
+                // Past the end of the file: flush the chain's delay with silence
+                count = static_cast<size_t>(qMin<qint64>(tail, block));
+                std::fill(input.begin(), input.begin() + count, 0);
+                tail -= count;
+            } else {
+                read += count;
+            }
+            processor.process(input.data(), output.data(), static_cast<int>(count));
+
+            qint64 got = static_cast<qint64>(count);
+            qint64 dropped = qMin(skip, got);
+            skip -= dropped;
+            if (!writer.write(output.data() + dropped, static_cast<size_t>(got - dropped)))
+                return writeFailed(writer, outputPath);
+            frames += got - dropped;
+        }
+
+        if (!writer.close())
+            return writeFailed(writer, outputPath);
+        return true;
+    }
+
+    QString errorString() const { return error; }
+
+    // Frames written by the last render() and the file's sample rate
+    qint64 framesRendered() const { return frames; }
+    int sampleRate() const { return rate; }
+
+private:
+    bool fail(const QString& message) {
+        error = message;
+        return false;
+    }
+
+    bool writeFailed(const WavWriter& writer, const QString& path) {
+        if (writer.errorString().empty())
+            return fail("write error on " + path);
+        return fail(path + ": " + QString::fromStdString(writer.errorString()));
+    }
+
+    OfflineOptions options;
+    QString error;
+    qint64 frames;
+    int rate;
+};
+
+#endif // OFFLINERENDERER_H
@@ -0,0 +1,219 @@
+#ifndef VIRTUALAUDIOBACKEND_H
+#define VIRTUALAUDIOBACKEND_H
+
+#include <QAudioFormat>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QObject>
+#include <QTimer>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <vector>
+
+#include "AudioBackend.h"
+#include "AudioProcessor.h"
+#include "dsp/VirtualClock.h"
+
+// Settings for the simulated device
+struct VirtualDeviceOptions {
+    VirtualStream capture;
+    VirtualStream playback;
+    int inputBufferFrames = 2048;  // Device buffers; the same as the Qt
+    int outputBufferFrames = 2048; // backend's 4096 bytes at 16-bit mono
+    quint32 seed = 1;              // Scheduling jitter sequence
+    std::vector<qint16> input;     // Microphone signal; silence when empty
+    bool loopInput = true;         // Else silence after the input ends
+    bool record = false;           // Keep what the speaker plays
+    bool realtime = true;          // Paced by a wall-clock timer; else by run()/step()
+};
+
+// A sound card that exists only in software.
+//
+// Callbacks come from a VirtualClock, so their sizes, the two sides'
+// sample rates and clock errors and the scheduling jitter are all
+// configurable, and a run with the same settings and seed is the same run
+// every time. The microphone plays `input` at the capture rate, and the
+// device buffers act as plain delays of their configured size: captured
+// audio is written to the engine `inputBufferFrames` late, and recorded
+// speaker output starts with `outputBufferFrames` of silence.
+// A callback later than its device buffer can absorb is counted as a
+// device overrun (capture) or underrun (playback); the audio itself is not
+// altered, so the engine's own counters show what the path did with it.
+//
+// With `realtime` a 1 ms timer keeps simulated time in step with the wall
+// clock, so the GUI can run without hardware. A callback then counts as
+// late by however long the thread took to get to it, so a stalled audio
+// thread shows up as device overruns and underruns, as it would on a sound
+// card. Otherwise nothing happens on its own: run() and step() advance
+// simulated time as fast as the CPU allows, which makes underrun and
+// headroom tests independent of the machine they run on.
+class VirtualAudioBackend : public QObject, public AudioBackend {
+    Q_OBJECT
+public:
+    struct Stats {
+        double seconds;            // Simulated time so far
+        quint64 captureCallbacks;
+        quint64 playbackCallbacks;
+        quint64 deviceOverruns;    // Capture callbacks later than the buffer
+        quint64 deviceUnderruns;   // Playback callbacks later than the buffer
+        double maxLatenessMs;
+    };
+
+    explicit VirtualAudioBackend(const VirtualDeviceOptions& options, QObject* parent = nullptr)
+        : QObject(parent), options(options), clock(SAMPLE_RATE, options.capture, options.playback, options.seed),
+          capture(nullptr), playback(nullptr), running(false)
+    {
+        timer.setTimerType(Qt::PreciseTimer);
+        connect(&timer, &QTimer::timeout, this, &VirtualAudioBackend::tick);
+    }
+
+    const char* name() const override { return "virtual"; }
+
+    // Any rate, per side if the streams set their own; samples are always
+    // 16-bit mono, which is what the path uses
+    bool open(const QAudioFormat& requested, QAudioFormat* captureFormat, QAudioFormat* playbackFormat) override {
+        if (options.capture.periodFrames == 0 || options.playback.periodFrames == 0) {
+            error = "Virtual device periods must be at least one frame";
+            return false;
+        }
+        QAudioFormat format = requested;
+        format.setChannelCount(1);
+        format.setSampleSize(16);
+        format.setSampleType(QAudioFormat::SignedInt);
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        format.setCodec("audio/pcm");
+        clock = VirtualClock(format.sampleRate(), options.capture, options.playback, options.seed);
+        captureRate = options.capture.sampleRate > 0.0 ? options.capture.sampleRate : format.sampleRate();
+        playbackRate = options.playback.sampleRate > 0.0 ? options.playback.sampleRate : format.sampleRate();
+        block.resize(std::max(options.capture.periodFrames, options.playback.periodFrames));
+        *captureFormat = *playbackFormat = format;
+        captureFormat->setSampleRate(static_cast<int>(captureRate));
+        playbackFormat->setSampleRate(static_cast<int>(playbackRate));
+        return true;
+    }
+
+    bool start(QIODevice* captureDevice, QIODevice* playbackDevice) override {
+        capture = captureDevice;
+        playback = playbackDevice;
+        clock.reset();
+        now = 0.0;
+        captured = 0;
+        stats = Stats{ 0.0, 0, 0, 0, 0, 0.0 };
+        speaker.assign(options.record ? options.outputBufferFrames : 0, 0);
+        running = true;
+        if (options.realtime) {
+            wallTime = 0.0;
+            wallClock.start();
+            timer.start(1);
+        }
+        return true;
+    }
+
+    void stop() override {
+        timer.stop();
+        running = false;
+    }
+
+    // Runs every callback due in the next `seconds` of simulated time
+    void run(double seconds) {
+        const double end = now + seconds;
+        while (running && clock.peek().time <= end)
+            step();
+        now = std::max(now, end);
+        stats.seconds = now;
+    }
+
+    // Runs the next callback and returns it
+    VirtualClock::Callback step() {
+        VirtualClock::Callback callback = clock.next();
+        if (options.realtime)
+            callback.lateness = std::max(callback.lateness, wallTime - (callback.time - callback.lateness));
+        now = callback.time;
+        stats.seconds = now;
+        stats.maxLatenessMs = std::max(stats.maxLatenessMs, callback.lateness * 1000.0);
+        if (callback.side == VirtualClock::Side::Capture)
+            captureCallback(callback);
+        else
+            playbackCallback(callback);
+        return callback;
+    }
+
+    // The callback step() would run next
+    const VirtualClock::Callback& peek() const { return clock.peek(); }
+
+    Stats statistics() const { return stats; }
+
+    quint64 deviceXruns() const override {
+        return stats.deviceOverruns + stats.deviceUnderruns;
+    }
+
+    QString statusReport() const override {
+        return QString::asprintf("Virtual device: %.1f s, %llu capture and %llu playback callbacks, "
+                                 "latest %.1f ms late; %llu overruns, %llu underruns",
+                                 stats.seconds, static_cast<unsigned long long>(stats.captureCallbacks),
+                                 static_cast<unsigned long long>(stats.playbackCallbacks), stats.maxLatenessMs,
+                                 static_cast<unsigned long long>(stats.deviceOverruns),
+                                 static_cast<unsigned long long>(stats.deviceUnderruns));
+    }
+
+    // Speaker output with `record`, as heard: the output buffer's delay first
+    const std::vector<qint16>& recording() const { return speaker; }
+
+private slots:
+    void tick() {
+        wallTime = wallClock.nsecsElapsed() * 1e-9;
+        run(wallTime - now);
+    }
+
+private:
+    void captureCallback(const VirtualClock::Callback& callback) {
+        const size_t frames = callback.frames;
+        if (callback.lateness * captureRate > options.inputBufferFrames - static_cast<double>(frames))
+            ++stats.deviceOverruns;
+        ++stats.captureCallbacks;
+
+        const std::vector<qint16>& input = options.input;
+        for (size_t i = 0; i < frames; ++i, ++captured) {
+            qint64 position = captured - options.inputBufferFrames;
+            if (position < 0 || input.empty())
+                block[i] = 0;
+            else if (options.loopInput)
+                block[i] = input[static_cast<size_t>(position) % input.size()];
+            else
+                block[i] = static_cast<size_t>(position) < input.size() ? input[position] : 0;
+        }
+        if (capture)
+            capture->write(reinterpret_cast<const char*>(block.data()), static_cast<qint64>(frames) * 2);
+    }
+
+    void playbackCallback(const VirtualClock::Callback& callback) {
+        const size_t frames = callback.frames;
+        if (callback.lateness * playbackRate > options.outputBufferFrames - static_cast<double>(frames))
+            ++stats.deviceUnderruns;
+        ++stats.playbackCallbacks;
+
+        if (playback)
+            playback->read(reinterpret_cast<char*>(block.data()), static_cast<qint64>(frames) * 2);
+        if (options.record)
+            speaker.insert(speaker.end(), block.begin(), block.begin() + frames);
+    }
+
+    VirtualDeviceOptions options;
+    double captureRate = SAMPLE_RATE;
+    double playbackRate = SAMPLE_RATE;
+    VirtualClock clock;
+    QIODevice* capture;
+    QIODevice* playback;
+    bool running;
+    double now = 0.0;
+    double wallTime = 0.0; // When the running tick() began, with `realtime`
+    qint64 captured = 0;
+    Stats stats = Stats{ 0.0, 0, 0, 0, 0, 0.0 };
+    std::vector<qint16> block;
+    std::vector<qint16> speaker;
+    QTimer timer;
+    QElapsedTimer wallClock;
+};
+
+#endif // VIRTUALAUDIOBACKEND_H
@@ -0,0 +1,267 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dsp/SampleConvert.h"
+
+// Minimal streaming RIFF/WAVE reader.
+//
+// Accepts integer PCM (8/16/24/32-bit), IEEE float (32/64-bit) and
+// WAVE_FORMAT_EXTENSIBLE wrappers of either, with any channel count.
+// readMono() decodes the next frames and mixes them down to the 16-bit
+// mono stream the processing chain works on; only one block of raw bytes
+// is held in memory at a time.
+class WavReader {
+public:
+    WavReader() : file(nullptr), rate(0), channelCount(0), bits(0), floatData(false), streamed(false),
+                  totalFrames(0), framesLeft(0) {}
+    ~WavReader() { close(); }
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return fail("cannot open " + path);
+
+        unsigned char header[12];
+        if (std::fread(header, 1, 12, file) != 12 || std::memcmp(header, "RIFF", 4) != 0
+            || std::memcmp(header + 8, "WAVE", 4) != 0)
+            return fail(path + " is not a RIFF/WAVE file");
+
+        bool haveFormat = false;
+        unsigned char chunk[8];
+        while (std::fread(chunk, 1, 8, file) == 8) {
+            uint32_t size = le32(chunk + 4);
+            if (std::memcmp(chunk, "fmt ", 4) == 0) {
+                std::vector<unsigned char> fmt(size);
+                if (size < 16 || std::fread(fmt.data(), 1, size, file) != size)
+                    return fail("truncated fmt chunk");
+                uint16_t tag = le16(&fmt[0]);
+                if (tag == 0xFFFE && size >= 26)
+                    tag = le16(&fmt[24]); // Sub-format GUID starts with the real tag
+                channelCount = le16(&fmt[2]);
+                rate = static_cast<int>(le32(&fmt[4]));
+                bits = le16(&fmt[14]);
+                floatData = tag == 3;
+                if ((tag != 1 && tag != 3) || channelCount < 1
+                    || (floatData && bits != 32 && bits != 64)
+                    || (!floatData && bits != 8 && bits != 16 && bits != 24 && bits != 32))
+                    return fail("unsupported WAV encoding");
+                haveFormat = true;
+                if (size & 1)
+                    std::fseek(file, 1, SEEK_CUR);
+            } else if (std::memcmp(chunk, "data", 4) == 0) {
+                if (!haveFormat)
+                    return fail("data chunk before fmt chunk");
+                // Writers that cannot seek back (ffmpeg into a pipe) leave
+                // the size at its maximum; such data runs to the end of file
+                streamed = size == 0xFFFFFFFFu;
+                totalFrames = streamed ? UINT64_MAX : size / frameBytes();
+                framesLeft = totalFrames;
+                return true;
+            } else {
+                std::fseek(file, static_cast<long>(size + (size & 1)), SEEK_CUR);
+            }
+        }
+        return fail("no data chunk");
+    }
+
+    void close() {
+        if (file)
+            std::fclose(file);
+        file = nullptr;
+    }
+
+    const std::string& errorString() const { return error; }
+    int sampleRate() const { return rate; }
+    int channels() const { return channelCount; }
+    // Frames the header declares; UINT64_MAX for a streamed file, whose
+    // length is only known once readMono() returns 0
+    uint64_t frameCount() const { return totalFrames; }
+    bool lengthKnown() const { return !streamed; }
+
+    // Decodes up to maxFrames frames as mono int16; returns frames read.
+    size_t readMono(int16_t* out, size_t maxFrames) {
+        size_t frames = fetch(maxFrames);
+        const unsigned char* p = raw.data();
+        for (size_t f = 0; f < frames; ++f)
+            out[f] = floatToInt16Sample(mixFrame(p));
+        return frames;
+    }
+
+    // As readMono(), at full float precision (e.g. for impulse responses)
+    size_t readMono(float* out, size_t maxFrames) {
+        size_t frames = fetch(maxFrames);
+        const unsigned char* p = raw.data();
+        for (size_t f = 0; f < frames; ++f)
+            out[f] = mixFrame(p);
+        return frames;
+    }
+
+private:
+    // Reads up to maxFrames raw frames into `raw`; returns frames read
+    size_t fetch(size_t maxFrames) {
+        size_t frames = static_cast<size_t>(std::min<uint64_t>(maxFrames, framesLeft));
+        if (!file || frames == 0)
+            return 0;
+        raw.resize(frames * frameBytes());
+        frames = std::fread(raw.data(), frameBytes(), frames, file);
+        framesLeft -= frames;
+        return frames;
+    }
+
+    // Mixes the frame at `p` down to mono and advances past it
+    float mixFrame(const unsigned char*& p) const {
+        const size_t sampleBytes = bits / 8;
+        float sum = 0.0f;
+        for (int c = 0; c < channelCount; ++c, p += sampleBytes)
+            sum += decode(p);
+        return sum / channelCount;
+    }
+
+    bool fail(const std::string& message) {
+        error = message;
+        close();
+        return false;
+    }
+
+    size_t frameBytes() const { return static_cast<size_t>(channelCount) * (bits / 8); }
+
+    float decode(const unsigned char* p) const {
+        if (floatData) {
+            if (bits == 32) {
+                uint32_t u = le32(p);
+                float v;
+                std::memcpy(&v, &u, 4);
+                return v;
+            }
+            uint64_t u = le32(p) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+            double v;
+            std::memcpy(&v, &u, 8);
+            return static_cast<float>(v);
+        }
+        switch (bits) {
+        case 8: return (p[0] - 128) / 128.0f;
+        case 16: return static_cast<int16_t>(le16(p)) / 32768.0f;
+        case 24: {
+            int32_t v = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24));
+            return (v >> 8) / 8388608.0f;
+        }
+        default: return static_cast<int32_t>(le32(p)) / 2147483648.0f;
+        }
+    }
+
+    static uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    static uint32_t le32(const unsigned char* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    std::FILE* file;
+    std::string error;
+    int rate;
+    int channelCount;
+    int bits;
+    bool floatData;
+    bool streamed;
+    uint64_t totalFrames;
+    uint64_t framesLeft;
+    std::vector<unsigned char> raw;
+};
+
+// Streaming 16-bit PCM WAV writer; the header sizes are patched in close().
+class WavWriter {
+public:
+    WavWriter() : file(nullptr), channelCount(1), dataBytes(0) {}
+    ~WavWriter() { close(); }
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool open(const std::string& path, int sampleRate, int channels) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            error = "cannot create " + path;
+            return false;
+        }
+        channelCount = channels;
+        dataBytes = 0;
+
+        unsigned char header[44] = {};
+        std::memcpy(header, "RIFF", 4);
+        std::memcpy(header + 8, "WAVEfmt ", 8);
+        put32(header + 16, 16);
+        put16(header + 20, 1);
+        put16(header + 22, static_cast<uint16_t>(channels));
+        put32(header + 24, static_cast<uint32_t>(sampleRate));
+        put32(header + 28, static_cast<uint32_t>(sampleRate * channels * 2));
+        put16(header + 32, static_cast<uint16_t>(channels * 2));
+        put16(header + 34, 16);
+        std::memcpy(header + 36, "data", 4);
+        return std::fwrite(header, 1, 44, file) == 44;
+    }
+
+    // Writes interleaved frames; returns false on an I/O error or once the
+    // data would no longer fit the header's 32-bit sizes.
+    bool write(const int16_t* samples, size_t frames) {
+        if (!file)
+            return false;
+        size_t count = frames * channelCount;
+        if (dataBytes + count * 2 > MaxDataBytes) {
+            error = "WAV data exceeds 4 GiB";
+            return false;
+        }
+        bytes.resize(count * 2);
+        for (size_t i = 0; i < count; ++i)
+            put16(&bytes[i * 2], static_cast<uint16_t>(samples[i]));
+        size_t written = std::fwrite(bytes.data(), 1, bytes.size(), file);
+        dataBytes += written;
+        return written == bytes.size();
+    }
+
+    bool close() {
+        if (!file)
+            return true;
+        unsigned char size[4];
+        bool ok = std::fseek(file, 4, SEEK_SET) == 0;
+        put32(size, static_cast<uint32_t>(36 + dataBytes));
+        ok = ok && std::fwrite(size, 1, 4, file) == 4;
+        ok = ok && std::fseek(file, 40, SEEK_SET) == 0;
+        put32(size, static_cast<uint32_t>(dataBytes));
+        ok = ok && std::fwrite(size, 1, 4, file) == 4;
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    const std::string& errorString() const { return error; }
+
+private:
+    static const uint64_t MaxDataBytes = 0xFFFFFFFFu - 36; // RIFF size = 36 + data
+
+    static void put16(unsigned char* p, uint16_t v) {
+        p[0] = static_cast<unsigned char>(v);
+        p[1] = static_cast<unsigned char>(v >> 8);
+    }
+    static void put32(unsigned char* p, uint32_t v) {
+        put16(p, static_cast<uint16_t>(v));
+        put16(p + 2, static_cast<uint16_t>(v >> 16));
+    }
+
+    std::FILE* file;
+    std::string error;
+    int channelCount;
+    uint64_t dataBytes;
+    std::vector<unsigned char> bytes;
+};
+
+#endif // WAVFILE_H
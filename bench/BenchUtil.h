@@ -0,0 +1,111 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../WavFile.h"
+#include "../dsp/DspMath.h"
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs body() `repetitions` times and returns the fastest run in nanoseconds.
+template <typename Body>
+double bestOfNs(int repetitions, Body body) {
+    double best = 0.0;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        if (r == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+// Deterministic voice-band test signal: a few harmonics plus a little noise.
+inline std::vector<double> makeTestSignal(size_t count, double sampleRate) {
+    std::vector<double> signal(count);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        double t = i / sampleRate;
+        seed = seed * 1664525u + 1013904223u;
+        double noise = ((seed >> 9) / 8388608.0 - 1.0) * 0.01;
+        signal[i] = 0.4 * std::sin(2 * PI * 140.0 * t)
+                  + 0.2 * std::sin(2 * PI * 280.0 * t)
+                  + 0.1 * std::sin(2 * PI * 420.0 * t) + noise;
+    }
+    return signal;
+}
+
+// Room-like impulse response: noise under an exponential decay that
+// reaches -60 dB at the end
+inline std::vector<float> makeImpulseResponse(size_t length, unsigned seed) {
+    std::vector<float> ir(length);
+    for (size_t i = 0; i < length; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = (seed >> 9) / 8388608.0 - 1.0;
+        ir[i] = static_cast<float>(0.1 * noise * std::pow(10.0, -3.0 * i / length));
+    }
+    return ir;
+}
+
+// Writes `samples` as a 16-bit mono WAV, for stages that load files
+inline bool writeTestWav(const std::string& path, const std::vector<float>& samples, int sampleRate) {
+    std::vector<int16_t> pcm(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i)
+        pcm[i] = floatToInt16Sample(samples[i]);
+    WavWriter writer;
+    return writer.open(path, sampleRate, 1) && writer.write(pcm.data(), pcm.size()) && writer.close();
+}
+
+// One timing, as written out by --json and --csv
+struct BenchRecord {
+    std::string benchmark; // Suite entry that produced it
+    std::string name;
+    double sampleRate;     // 0 where no rate applies
+    size_t block;          // Frames per call, 0 where it does not apply
+    size_t samples;
+    double ns;
+};
+
+inline std::vector<BenchRecord>& benchRecords() {
+    static std::vector<BenchRecord> records;
+    return records;
+}
+
+// Name of the suite entry now running; set by main()
+inline std::string& currentBenchmark() {
+    static std::string name;
+    return name;
+}
+
+inline void recordResult(const std::string& name, double sampleRate, size_t block, size_t samples,
+                         double ns) {
+    benchRecords().push_back(BenchRecord{ currentBenchmark(), name, sampleRate, block, samples, ns });
+}
+
+// Prints one timing and records it; `block` is the frames per process
+// call where the benchmark sweeps it
+inline void printResult(const char* name, double sampleRate, size_t samples, double ns,
+                        size_t block = 0) {
+    recordResult(name, sampleRate, block, samples, ns);
+    double nsPerSample = ns / samples;
+    double realtime = (samples / sampleRate) / (ns * 1e-9);
+    std::string label = name;
+    if (block)
+        label += " / " + std::to_string(block);
+    std::printf("%-32s %7.0f Hz %12.2f ns/sample %12.1fx realtime\n",
+                label.c_str(), sampleRate, nsPerSample, realtime);
+}
+
+#endif // BENCHUTIL_H
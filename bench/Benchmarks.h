@@ -0,0 +1,22 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+// Each runs one suite entry and returns how many of its checks failed (0
+// for entries that only time).
+int benchCallback();
+int benchChain();
+int benchConvert();
+int benchConvolver();
+int benchDrift();
+int benchFilter();
+int benchFormat();
+int benchLatency();
+int benchPhaseVocoder();
+int benchPitchShifter();
+int benchResampler();
+int benchRingBuffer();
+int benchStages();
+int benchVader();
+int benchWsola();
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,30 @@
+TARGET = voiceBench
+TEMPLATE = app
+
+CONFIG += console c++17 thread
+CONFIG -= qt app_bundle
+
+# Guard the heap in the callback benchmark's simulated callbacks
+DEFINES += VOICECHANGER_COUNT_ALLOCATIONS
+
+SOURCES += main.cpp \
+           bench_callback.cpp \
+           bench_chain.cpp \
+           bench_convert.cpp \
+           bench_convolver.cpp \
+           bench_drift.cpp \
+           bench_filter.cpp \
+           bench_format.cpp \
+           bench_latency.cpp \
+           bench_phasevocoder.cpp \
+           bench_pitchshifter.cpp \
+           bench_resampler.cpp \
+           bench_ringbuffer.cpp \
+           bench_stages.cpp \
+           bench_vader.cpp \
+           bench_wsola.cpp
+
+HEADERS += BenchUtil.h \
+           Benchmarks.h
+
+INCLUDEPATH += ..
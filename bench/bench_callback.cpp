@@ -0,0 +1,109 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/LivePath.h"
+
+namespace {
+
+const double Rate = 44100.0;
+
+// The live path as the devices run it: CaptureCallback and PlaybackCallback
+// are the bodies of CaptureSink::writeData and PlaybackSource::readData,
+// each under its CallbackMonitor, which times it and guards the heap. The
+// chain is a real LiveChain built from `spec`, fed through the jitter
+// buffer and drift compensator in the device's s16 mono format. With
+// `sweep` set, a new settings snapshot is published before every callback
+// and picked up inside it, as when a slider is dragged; every 50th also
+// toggles the pitch engine, as the formants checkbox does.
+bool runCallbacks(const std::vector<int16_t>& input, const char* spec, size_t deviceFrames, bool sweep,
+                  CallbackMonitors& monitors, double* ns) {
+    LiveChain chain;
+    if (!chain.build(spec, Rate)) {
+        std::printf("%s: %s\n", spec, chain.chainErrorString().c_str());
+        return false;
+    }
+    FormatConverter converter;
+    formatConverter(SampleFormat{ SampleEncoding::Signed, 16, false, 1 }, detectSimdLevel(), &converter);
+    SampleJitterBuffer buffer(JITTER_BUFFER_FRAMES, PlaybackCallback::targetFrames(20, static_cast<int>(Rate)));
+    DriftCompensator compensator(&buffer, Rate);
+    AudioParameters parameters{ ParameterSnapshot() };
+    CaptureCallback capture(&buffer, &monitors.capture, converter);
+    PlaybackCallback playback(&chain, &buffer, &compensator, &parameters, &monitors.playback,
+                              static_cast<int>(Rate), converter);
+    playback.syncParameters();
+    std::vector<int16_t> device(deviceFrames);
+
+    *ns = bestOfNs(1, [&] {
+        size_t callbacks = 0;
+        for (size_t offset = 0; offset + deviceFrames <= input.size(); offset += deviceFrames, ++callbacks) {
+            capture.process(reinterpret_cast<const char*>(input.data() + offset), deviceFrames);
+            if (sweep) {
+                float t = static_cast<float>(offset / Rate);
+                ParameterSnapshot snapshot;
+                snapshot.pitchEngine = callbacks / 50 % 2 ? LiveChain::PhaseVocoderPitch : LiveChain::GranularPitch;
+                snapshot.formants = snapshot.pitchEngine == LiveChain::PhaseVocoderPitch;
+                snapshot.pitchFactor = 0.9f + 0.3f * std::sin(t * 1.3f);
+                snapshot.cutoffHz = 1000.0f + 800.0f * std::sin(t * 0.7f);
+                snapshot.targetLatencyMs = 20 + static_cast<int>(callbacks / 100 % 3) * 10;
+                parameters.write(snapshot);
+            }
+            playback.process(reinterpret_cast<char*>(device.data()), deviceFrames);
+        }
+        doNotOptimize(device.back());
+    });
+    return true;
+}
+
+void printCallbackSummary(const char* name, const CallbackMonitor& monitor) {
+    CallbackStats::Summary s = monitor.summary();
+    std::printf("    %-9s %7llu calls  min %7.1f  avg %7.1f  p99 %7.1f  max %7.1f us"
+                "  heap violations %llu\n",
+                name, static_cast<unsigned long long>(s.count), s.minUs, s.avgUs, s.p99Us, s.maxUs,
+                static_cast<unsigned long long>(monitor.violations()));
+}
+
+} // namespace
+
+int benchCallback()
+{
+#ifndef VOICECHANGER_COUNT_ALLOCATIONS
+    std::printf("(built without VOICECHANGER_COUNT_ALLOCATIONS; the heap is not guarded)\n");
+#endif
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(Rate * 10), Rate);
+    std::vector<int16_t> input(signal.size());
+    for (size_t i = 0; i < signal.size(); ++i)
+        input[i] = static_cast<int16_t>(signal[i] * 32767.0);
+
+    struct Setting { const char* name; const char* spec; bool sweep; };
+    const Setting settings[] = {
+        { "Callbacks granular", DEFAULT_CHAIN_SPEC, false },
+        { "Callbacks vocoder+formants", "pitch factor=0.8 engine=vocoder formants=1; lowpass cutoff=3400", false },
+        { "Callbacks vader", findChainPreset("vader")->spec, false },
+        { "Callbacks swept", DEFAULT_CHAIN_SPEC, true },
+    };
+    const size_t deviceSizes[] = { 128, 2048 };
+
+    int failures = 0;
+    for (const Setting& setting : settings) {
+        for (size_t frames : deviceSizes) {
+            CallbackMonitors monitors;
+            double ns = 0.0;
+            if (!runCallbacks(input, setting.spec, frames, setting.sweep, monitors, &ns)) {
+                ++failures;
+                continue;
+            }
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s %zu", setting.name, frames);
+            printResult(name, Rate, input.size(), ns);
+            printCallbackSummary("writeData", monitors.capture);
+            printCallbackSummary("readData", monitors.playback);
+            failures += monitors.capture.violations() || monitors.playback.violations() ? 1 : 0;
+        }
+    }
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/EffectChain.h"
+#include "../dsp/LowPassFilter.h"
+#include "../dsp/PitchShifter.h"
+
+// The AudioProcessor chain (PitchShifter -> LowPassFilter at 300 Hz), run
+// once per sample the way writeData used to, and once per block.
+int benchChain()
+{
+    const double rate = 44100.0;
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(rate * 5), rate);
+    std::vector<float> input(signal.begin(), signal.end());
+    std::vector<float> output(input.size());
+
+    double perSample = bestOfNs(3, [&] {
+        PitchShifter shifter(0.8, rate);
+        LowPassFilter filter(300.0, rate);
+        for (size_t i = 0; i < input.size(); ++i)
+            output[i] = static_cast<float>(filter.processSample(shifter.processSample(input[i])));
+        doNotOptimize(output.back());
+    });
+    printResult("Chain per-sample", rate, input.size(), perSample);
+
+    const size_t blockSizes[] = { 64, 256, 1024 };
+    for (size_t block : blockSizes) {
+        double ns = bestOfNs(3, [&] {
+            PitchShifter shifter(0.8, rate);
+            LowPassFilter filter(300.0, rate);
+            for (size_t offset = 0; offset < input.size(); offset += block) {
+                size_t count = std::min(block, input.size() - offset);
+                shifter.process(input.data() + offset, output.data() + offset, count);
+                filter.process(output.data() + offset, output.data() + offset, count);
+            }
+            doNotOptimize(output.back());
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "Chain block %zu", block);
+        printResult(name, rate, input.size(), ns);
+    }
+
+    // The same chain and a longer one built from descriptions, the way
+    // AudioProcessor builds them, at the live 256-frame chunk size
+    struct Spec { const char* name; const char* spec; };
+    const Spec specs[] = {
+        { "EffectChain default", DEFAULT_CHAIN_SPEC },
+        { "EffectChain full", "gain db=3; pitch factor=0.8; distortion drive=9 mix=0.5; "
+                              "lowpass cutoff=3000; reverb room=0.6 mix=0.2" },
+    };
+    for (const Spec& spec : specs) {
+        EffectChain chain(256);
+        if (!chain.build(spec.spec, rate)) {
+            std::printf("%s: %s\n", spec.name, chain.errorString().c_str());
+            continue;
+        }
+        double ns = bestOfNs(3, [&] {
+            for (size_t offset = 0; offset < input.size(); offset += 256) {
+                size_t count = std::min<size_t>(256, input.size() - offset);
+                chain.process(input.data() + offset, output.data() + offset, count);
+            }
+            doNotOptimize(output.back());
+        });
+        printResult(spec.name, rate, input.size(), ns);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/SampleConvert.h"
+
+namespace {
+
+struct ExpectedSample {
+    const char* name;
+    float input;
+    int16_t output;
+    int16_t tieAway; // 32-bit ARM NEON rounds exact .5 away from zero
+};
+
+// float -> int16 at and past full scale, on rounding ties and on values
+// that are not numbers, per kernel. Each input fills a whole buffer whose
+// length leaves a scalar tail, so every vector lane and the tail see it.
+// Then every int16 code must survive int16 -> float -> int16, and each
+// SIMD kernel must match scalar bit for bit at every length up to 64 on
+// input that clips but has no exact ties.
+int checkConversions() {
+    const float inf = std::numeric_limits<float>::infinity();
+    const ExpectedSample expected[] = {
+        { "+1.0", 1.0f, 32767, 32767 },
+        { "-1.0", -1.0f, -32768, -32768 },
+        { "+2.0", 2.0f, 32767, 32767 },
+        { "-2.0", -2.0f, -32768, -32768 },
+        { "+1e9", 1e9f, 32767, 32767 },
+        { "-1e9", -1e9f, -32768, -32768 },
+        { "NaN", std::numeric_limits<float>::quiet_NaN(), 0, 0 },
+        { "+inf", inf, 32767, 32767 },
+        { "-inf", -inf, -32768, -32768 },
+        { "-32768/32768", -32768.0f / 32768.0f, -32768, -32768 },
+        { "32767/32768", 32767.0f / 32768.0f, 32767, 32767 },
+        { "32767.5/32768", 32767.5f / 32768.0f, 32767, 32767 },
+        { "0.5/32768", 0.5f / 32768.0f, 0, 1 },
+        { "1.5/32768", 1.5f / 32768.0f, 2, 2 },
+        { "-2.5/32768", -2.5f / 32768.0f, -2, -3 },
+        { "0", 0.0f, 0, 0 },
+    };
+    const size_t length = 37;
+    int failures = 0;
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        SampleConverter converter = sampleConverter(level);
+#if defined(DSP_HAVE_NEON) && !defined(__aarch64__)
+        const bool tiesAway = level == SimdLevel::Neon;
+#else
+        const bool tiesAway = false;
+#endif
+        int wrong = 0;
+        for (const ExpectedSample& e : expected) {
+            std::vector<float> in(length, e.input);
+            std::vector<int16_t> out(length, 12345);
+            converter.toInt16(in.data(), out.data(), length);
+            // The last length % 8 samples go through the scalar tail
+            for (size_t i = 0; i < length; ++i) {
+                int16_t want = tiesAway && i < length - length % 8 ? e.tieAway : e.output;
+                if (out[i] != want) {
+                    std::printf("  %-6s %-14s -> %6d at %zu, expected %6d FAIL\n", simdLevelName(level), e.name,
+                                out[i], i, want);
+                    ++wrong;
+                    break;
+                }
+            }
+        }
+
+        std::vector<int16_t> codes(65536), back(65536);
+        std::vector<float> floats(65536);
+        for (size_t i = 0; i < codes.size(); ++i)
+            codes[i] = static_cast<int16_t>(static_cast<int>(i) - 32768);
+        converter.toFloat(codes.data(), floats.data(), codes.size());
+        converter.toInt16(floats.data(), back.data(), codes.size());
+        bool exact = floats.front() == -1.0f && floats.back() == 32767.0f / 32768.0f && back == codes;
+        if (!exact) {
+            std::printf("  %-6s int16 -> float -> int16 changed codes FAIL\n", simdLevelName(level));
+            ++wrong;
+        }
+        std::printf("  %-6s %zu saturation/rounding cases and every int16 code %s\n", simdLevelName(level),
+                    sizeof(expected) / sizeof(expected[0]), wrong ? "FAIL" : "ok");
+        failures += wrong;
+    }
+
+    std::vector<float> mixed(64);
+    std::vector<int16_t> pcm(64);
+    unsigned seed = 99;
+    for (size_t i = 0; i < mixed.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        // Up to twice full scale, a quarter step off the nearest tie
+        float code = static_cast<float>(static_cast<int>(seed >> 15) - 65536);
+        mixed[i] = (code + ((seed & 1) ? 0.25f : 0.75f)) / 32768.0f;
+        pcm[i] = static_cast<int16_t>(seed >> 16);
+    }
+    mixed[5] = expected[6].input;
+    mixed[17] = inf;
+    mixed[40] = -inf;
+    pcm[3] = -32768;
+    pcm[33] = 32767;
+    for (SimdLevel level : levels) {
+        if (level == SimdLevel::Scalar || !simdLevelSupported(level))
+            continue;
+        SampleConverter scalar = sampleConverter(SimdLevel::Scalar);
+        SampleConverter simd = sampleConverter(level);
+        bool ok = true;
+        for (size_t n = 0; n <= mixed.size(); ++n) {
+            std::vector<int16_t> a(n + 1, 7), b(n + 1, 7);
+            std::vector<float> x(n + 1, 7.0f), y(n + 1, 7.0f);
+            scalar.toInt16(mixed.data(), a.data(), n);
+            simd.toInt16(mixed.data(), b.data(), n);
+            scalar.toFloat(pcm.data(), x.data(), n);
+            simd.toFloat(pcm.data(), y.data(), n);
+            // The extra element catches writes past n
+            ok = ok && a == b && std::memcmp(x.data(), y.data(), x.size() * sizeof(float)) == 0;
+        }
+        std::printf("  %-6s matches scalar at lengths 0..%zu %s\n", simdLevelName(level), mixed.size(),
+                    ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    }
+    return failures;
+}
+
+} // namespace
+
+// int16 <-> float conversion as done at both ends of writeData: exactness
+// checks, then throughput per kernel and per block size (the same total
+// work at every size).
+int benchConvert()
+{
+    int failures = checkConversions();
+    std::printf("%d check(s) failed\n", failures);
+
+    const size_t maxBlock = 4096;
+    const size_t total = maxBlock * 2000;
+    std::vector<double> signal = makeTestSignal(maxBlock, 44100.0);
+    std::vector<int16_t> pcm(maxBlock);
+    std::vector<float> samples(maxBlock);
+    for (size_t i = 0; i < maxBlock; ++i) {
+        // Drive past full scale so the saturating path is exercised too
+        samples[i] = static_cast<float>(signal[i] * 2.5);
+        pcm[i] = static_cast<int16_t>(signal[i] * 32767.0);
+    }
+    std::vector<float> floatOut(maxBlock);
+    std::vector<int16_t> pcmOut(maxBlock);
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        SampleConverter converter = sampleConverter(level);
+
+        for (size_t block = 32; block <= maxBlock; block *= 2) {
+            const size_t passes = total / block;
+            double toFloat = bestOfNs(5, [&] {
+                for (size_t p = 0; p < passes; ++p)
+                    converter.toFloat(pcm.data(), floatOut.data(), block);
+                doNotOptimize(floatOut[block - 1]);
+            });
+            double toInt16 = bestOfNs(5, [&] {
+                for (size_t p = 0; p < passes; ++p)
+                    converter.toInt16(samples.data(), pcmOut.data(), block);
+                doNotOptimize(pcmOut[block - 1]);
+            });
+
+            std::string suffix = std::string(" (") + simdLevelName(level) + ")";
+            recordResult("int16->float" + suffix, 0.0, block, total, toFloat);
+            recordResult("float->int16" + suffix, 0.0, block, total, toInt16);
+            std::printf("%-32s %12.1f Msamples/sec\n",
+                        ("int16->float" + suffix + " / " + std::to_string(block)).c_str(),
+                        total / toFloat * 1e3);
+            std::printf("%-32s %12.1f Msamples/sec\n",
+                        ("float->int16" + suffix + " / " + std::to_string(block)).c_str(),
+                        total / toInt16 * 1e3);
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/AllocationCounter.h"
+#include "../dsp/Convolver.h"
+#include "../dsp/EffectChain.h"
+
+namespace {
+
+const double Rate = 48000.0;
+const size_t Block = 128;
+
+// Largest difference between `stage` fed in uneven chunks and a direct
+// double-precision convolution delayed by the stage's latency
+double maxError(Convolver& stage, const std::vector<float>& ir, const std::vector<float>& input) {
+    std::vector<float> output(input.size());
+    stage.reset();
+    size_t chunks[] = { 1, 77, 128, 300, 5 };
+    for (size_t offset = 0, c = 0; offset < input.size(); ++c) {
+        size_t n = std::min(chunks[c % 5], input.size() - offset);
+        stage.process(input.data() + offset, output.data() + offset, n);
+        offset += n;
+    }
+    double worst = 0.0;
+    for (size_t i = stage.latency(); i < input.size(); ++i) {
+        size_t t = i - stage.latency();
+        double expected = 0.0;
+        for (size_t k = 0; k < ir.size() && k <= t; ++k)
+            expected += static_cast<double>(ir[k]) * input[t - k];
+        worst = std::max(worst, std::fabs(output[i] - expected));
+    }
+    return worst;
+}
+
+void run(const char* name, Convolver& stage, const std::vector<float>& input) {
+    std::vector<float> output(input.size());
+    uint64_t before = allocationCount();
+    double ns = bestOfNs(3, [&] {
+        for (size_t offset = 0; offset < input.size(); offset += Block)
+            stage.process(input.data() + offset, output.data() + offset, Block);
+        doNotOptimize(output.back());
+    });
+    uint64_t allocations = allocationCount() - before;
+    recordResult(name, Rate, Block, input.size(), ns);
+    double core = ns * 1e-9 / (input.size() / Rate) * 100.0;
+    std::printf("%-40s %9.2f ns/sample %7.2f%% of a core  latency %4zu  heap calls %llu\n",
+                name, ns / input.size(), core, stage.latency(),
+                static_cast<unsigned long long>(allocations));
+}
+
+} // namespace
+
+// Partitioned convolution at 48 kHz in 128-frame blocks. First the output
+// is checked against a direct convolution for both the zero-latency and
+// the plain FFT layout, with chunk sizes that straddle partitions; then
+// 0.5 s and 2 s room responses are timed per kernel, and a chain loads one
+// from a WAV file the way --chain does.
+int benchConvolver()
+{
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(Rate * 4), Rate);
+    std::vector<float> input(signal.begin(), signal.end());
+
+    std::vector<float> shortIr = makeImpulseResponse(1000, 7);
+    std::vector<float> probe(input.begin(), input.begin() + 6000);
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    int failures = 0;
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        for (int direct = 1; direct >= 0; --direct) {
+            Convolver stage(shortIr, 64, direct != 0, 1.0, complexMacKernel(level));
+            double error = maxError(stage, shortIr, probe);
+            bool ok = error < 1e-5;
+            failures += ok ? 0 : 1;
+            std::printf("  1000-tap IR, 64-sample partitions, %-6s direct=%d: max error %.2e %s\n",
+                        simdLevelName(level), direct, error, ok ? "ok" : "FAIL");
+        }
+    }
+
+    const double seconds[] = { 0.5, 2.0 };
+    for (double length : seconds) {
+        std::vector<float> ir = makeImpulseResponse(static_cast<size_t>(length * Rate), 11);
+        for (SimdLevel level : levels) {
+            if (!simdLevelSupported(level))
+                continue;
+            for (int direct = 1; direct >= 0; --direct) {
+                Convolver stage(ir, Block, direct != 0, 1.0, complexMacKernel(level));
+                char name[64];
+                std::snprintf(name, sizeof name, "%.1f s IR, %zu partitions, %s%s", length,
+                              stage.partitionCount(), simdLevelName(level), direct ? ", direct" : "");
+                run(name, stage, input);
+            }
+        }
+    }
+
+    // Through the registry, from a file
+    const std::string path = "voiceBench-ir.wav";
+    std::vector<float> ir = makeImpulseResponse(static_cast<size_t>(0.5 * Rate), 11);
+    writeTestWav(path, ir, static_cast<int>(Rate));
+
+    EffectChain chain(Block);
+    if (chain.build("convolver ir=" + path + " normalize=1", Rate)) {
+        std::vector<float> output(input.size());
+        double ns = bestOfNs(3, [&] {
+            for (size_t offset = 0; offset < input.size(); offset += Block)
+                chain.process(input.data() + offset, output.data() + offset, Block);
+            doNotOptimize(output.back());
+        });
+        printResult("Chain 'convolver ir=<0.5 s wav>'", Rate, input.size(), ns, Block);
+    } else {
+        ++failures;
+        std::printf("  chain from %s: %s FAIL\n", path.c_str(), chain.errorString().c_str());
+    }
+    std::remove(path.c_str());
+
+    bool kept = !chain.build("gain; convolver ir=missing.wav", Rate) && chain.size() == 1;
+    failures += kept ? 0 : 1;
+    std::printf("  missing IR file: \"%s\", previous chain kept %s\n", chain.errorString().c_str(),
+                kept ? "ok" : "FAIL");
+
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/DriftCompensator.h"
+
+namespace {
+
+struct DriftRun {
+    size_t minFill;    // After the settling period
+    size_t maxFill;
+    uint64_t underruns;
+    uint64_t corrections;
+    float finalPpm;
+};
+
+// Simulates an hour of capture and playback on two virtual clocks: the
+// producer pushes 10 ms blocks at rate * (1 + ppm), the consumer pulls
+// 512-frame blocks at the nominal rate. Events are processed in time
+// order, like two device callbacks would interleave.
+DriftRun simulateDrift(double ppm, bool compensate, double seconds) {
+    const double rate = 48000.0;
+    const size_t captureBlock = 480;
+    const size_t playbackBlock = 512;
+    const double settleSeconds = 120.0;
+
+    JitterBuffer<int16_t> buffer(1 << 15, static_cast<size_t>(rate * 0.040));
+    DriftCompensator compensator(&buffer, rate);
+
+    std::vector<int16_t> capture(captureBlock);
+    std::vector<int16_t> playbackRaw(playbackBlock);
+    std::vector<float> playback(playbackBlock);
+    for (size_t i = 0; i < captureBlock; ++i)
+        capture[i] = static_cast<int16_t>((i * 97) % 2000 - 1000);
+
+    const double capturePeriod = captureBlock / (rate * (1.0 + ppm * 1e-6));
+    const double playbackPeriod = playbackBlock / rate;
+    double captureTime = 0.0;
+    double playbackTime = playbackPeriod * 0.5;
+
+    DriftRun run = { SIZE_MAX, 0, 0, 0, 0.0f };
+    while (playbackTime < seconds) {
+        if (captureTime <= playbackTime) {
+            buffer.push(capture.data(), captureBlock);
+            captureTime += capturePeriod;
+            continue;
+        }
+
+        if (compensate) {
+            compensator.render(playback.data(), playbackBlock);
+        } else {
+            buffer.pull(playbackRaw.data(), playbackBlock);
+        }
+        playbackTime += playbackPeriod;
+
+        if (playbackTime > settleSeconds) {
+            size_t fill = buffer.fillFrames();
+            run.minFill = std::min(run.minFill, fill);
+            run.maxFill = std::max(run.maxFill, fill);
+        }
+    }
+
+    JitterBuffer<int16_t>::Stats stats = buffer.stats();
+    run.underruns = stats.underruns;
+    run.corrections = stats.corrections;
+    run.finalPpm = compensator.correctionPpm();
+    return run;
+}
+
+} // namespace
+
+int benchDrift()
+{
+    const double seconds = 3600.0;
+    const double offsets[] = { -200.0, 200.0 };
+    int failures = 0;
+
+    for (double ppm : offsets) {
+        for (bool compensate : { false, true }) {
+            DriftRun run;
+            double ns = bestOfNs(1, [&] { run = simulateDrift(ppm, compensate, seconds); });
+            std::printf("%+5.0f ppm %-13s fill %5zu..%-5zu frames  underruns %4llu  trims %4llu"
+                        "  correction %+7.1f ppm  (%.1f s)\n",
+                        ppm, compensate ? "compensated" : "uncompensated",
+                        run.minFill, run.maxFill,
+                        static_cast<unsigned long long>(run.underruns),
+                        static_cast<unsigned long long>(run.corrections),
+                        run.finalPpm, ns * 1e-9);
+            if (!compensate)
+                continue;
+            // Compensated: never empty, never trimmed, and the estimate
+            // tracks the offset it is given
+            bool ok = run.underruns == 0 && run.corrections == 0 && run.minFill > 0
+                   && std::fabs(run.finalPpm - ppm) <= 0.25 * std::fabs(ppm);
+            std::printf("%+5.0f ppm compensated   %s\n", ppm, ok ? "ok" : "FAIL");
+            failures += ok ? 0 : 1;
+        }
+    }
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/Biquad.h"
+#include "../dsp/FilterStage.h"
+#include "../dsp/LowPassFilter.h"
+#include "../dsp/StateVariableFilter.h"
+
+namespace {
+
+const double Rate = 48000.0;
+
+int failures = 0;
+
+void check(const char* what, double value, double expected, double tolerance) {
+    bool ok = std::fabs(value - expected) <= tolerance;
+    if (!ok)
+        ++failures;
+    std::printf("  %-50s %10.4g (expect %8.3f +- %.4g) %s\n", what, value, expected, tolerance,
+                ok ? "ok" : "FAIL");
+}
+
+// Magnitude in dB at `frequency` of what `stage` does to an impulse, from
+// a DFT of the first 8192 samples of its response (all designs here have
+// decayed well below float resolution by then)
+double measuredDb(DspStage& stage, double frequency) {
+    const size_t length = 8192;
+    std::vector<float> impulse(length, 0.0f);
+    impulse[0] = 1.0f;
+    stage.reset();
+    // Odd block sizes make the SIMD kernels cross block edges mid-pipeline
+    for (size_t offset = 0; offset < length; offset += 77) {
+        size_t n = std::min<size_t>(77, length - offset);
+        stage.process(impulse.data() + offset, impulse.data() + offset, n);
+    }
+    std::complex<double> sum = 0.0;
+    for (size_t i = 0; i < length; ++i)
+        sum += static_cast<double>(impulse[i]) * std::polar(1.0, -2.0 * PI * frequency * i / Rate);
+    return 20.0 * std::log10(std::abs(sum) + 1e-30);
+}
+
+struct Design {
+    const char* name;
+    BiquadType type;
+    double q;
+    double gainDb;
+};
+
+const Design designs[] = {
+    { "lowpass", BiquadType::LowPass, 0.7071, 0.0 },
+    { "highpass", BiquadType::HighPass, 0.7071, 0.0 },
+    { "bandpass", BiquadType::BandPass, 2.0, 0.0 },
+    { "notch", BiquadType::Notch, 2.0, 0.0 },
+    { "allpass", BiquadType::AllPass, 0.7071, 0.0 },
+    { "peak", BiquadType::Peaking, 1.5, 6.0 },
+    { "lowshelf", BiquadType::LowShelf, 0.7071, -9.0 },
+    { "highshelf", BiquadType::HighShelf, 0.7071, 9.0 },
+};
+
+// Each design against the textbook values at and far from its 1 kHz
+// corner, then the filters that run it against the coefficients' own
+// response: a one-section cascade, the SIMD pipelines with the design in
+// every section, and the state-variable filter. Probes where the expected
+// response is below -90 dB are skipped: a float impulse response cannot
+// resolve them.
+void checkResponses() {
+    std::printf("Frequency response checks (%.0f Hz, 1 kHz designs):\n", Rate);
+    const double corner = 1000.0;
+    const double probes[] = { 50.0, 300.0, 1000.0, 3000.0, 12000.0 };
+
+    for (const Design& d : designs) {
+        BiquadCoefficients c = BiquadCoefficients::design(d.type, corner, d.q, Rate, d.gainDb);
+        std::string label = std::string(d.name) + " ";
+        switch (d.type) {
+        case BiquadType::LowPass:
+            check((label + "@ corner dB").c_str(), c.magnitudeDb(corner, Rate), -3.01, 0.05);
+            // Bilinear warping adds to the analog prototype's -40 dB here
+            check((label + "@ 10 kHz dB").c_str(), c.magnitudeDb(10000.0, Rate), -42.7, 0.1);
+            break;
+        case BiquadType::HighPass:
+            check((label + "@ corner dB").c_str(), c.magnitudeDb(corner, Rate), -3.01, 0.05);
+            check((label + "@ 100 Hz dB").c_str(), c.magnitudeDb(100.0, Rate), -40.0, 1.0);
+            break;
+        case BiquadType::BandPass:
+        case BiquadType::Peaking:
+            check((label + "@ center dB").c_str(), c.magnitudeDb(corner, Rate), d.gainDb, 0.05);
+            break;
+        case BiquadType::Notch:
+            check((label + "@ 0 Hz dB").c_str(), c.magnitudeDb(0.0, Rate), 0.0, 0.01);
+            check((label + "@ center below -60 dB").c_str(),
+                  std::max(c.magnitudeDb(corner, Rate), -60.0), -60.0, 0.0);
+            break;
+        case BiquadType::AllPass:
+            check((label + "@ 3 kHz dB").c_str(), c.magnitudeDb(3000.0, Rate), 0.0, 0.01);
+            check((label + "|phase| @ corner deg").c_str(),
+                  std::fabs(std::arg(c.response(corner, Rate))) * 180.0 / PI, 180.0, 0.5);
+            break;
+        case BiquadType::LowShelf:
+            check((label + "@ 20 Hz dB").c_str(), c.magnitudeDb(20.0, Rate), d.gainDb, 0.1);
+            check((label + "@ corner dB").c_str(), c.magnitudeDb(corner, Rate), d.gainDb / 2, 0.05);
+            break;
+        case BiquadType::HighShelf:
+            check((label + "@ 20 kHz dB").c_str(), c.magnitudeDb(20000.0, Rate), d.gainDb, 0.2);
+            check((label + "@ corner dB").c_str(), c.magnitudeDb(corner, Rate), d.gainDb / 2, 0.05);
+            break;
+        }
+
+        double biquadErr = 0.0, cascadeErr = 0.0, svfErr = 0.0;
+        BiquadCascade single(biquadKernels(SimdLevel::Scalar));
+        single.setSection(0, c);
+        BiquadCascade pipelined;
+        for (size_t s = 0; s < 8; ++s)
+            pipelined.setSection(s, c);
+        StateVariableFilter svf(d.type, corner, d.q, Rate, d.gainDb);
+        for (double f : probes) {
+            double expected = c.magnitudeDb(f, Rate);
+            if (expected > -90.0) {
+                biquadErr = std::max(biquadErr, std::fabs(measuredDb(single, f) - expected));
+                svfErr = std::max(svfErr, std::fabs(measuredDb(svf, f) - expected));
+            }
+            if (8 * expected > -90.0)
+                cascadeErr = std::max(cascadeErr, std::fabs(measuredDb(pipelined, f) - 8 * expected));
+        }
+        check((label + "biquad vs design, max dB error").c_str(), biquadErr, 0.0, 0.01);
+        check((label + "8-section cascade, max dB error").c_str(), cascadeErr, 0.0, 0.2);
+        check((label + "svf vs biquad design, max dB error").c_str(), svfErr, 0.0, 0.05);
+    }
+
+    // Butterworth: -3 dB at the corner whatever the order, 6 dB/octave per pole
+    const int orders[] = { 2, 4, 8, 16 };
+    for (int order : orders) {
+        FilterStage stage(BiquadType::LowPass, corner, 0.7071, Rate, order);
+        char what[64];
+        std::snprintf(what, sizeof(what), "butterworth order %d @ corner dB", order);
+        check(what, measuredDb(stage, corner), -3.01, 0.05);
+        std::snprintf(what, sizeof(what), "butterworth order %d @ 4 kHz dB", order);
+        check(what, stage.magnitudeDb(4000.0), -6.02 * 2 * order, 0.5 * order);
+    }
+}
+
+// Every SIMD level against the scalar kernels on the same noisy input,
+// with block sizes that start and end the pipeline in every phase
+void checkKernels() {
+    std::printf("SIMD kernels against scalar:\n");
+    std::vector<double> signal = makeTestSignal(48000, Rate);
+    std::vector<float> input(signal.begin(), signal.end());
+    const size_t blocks[] = { 1, 2, 3, 5, 7, 8, 9, 31, 64, 255 };
+    const SimdLevel levels[] = { SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        const size_t sizes[] = { 2, 4, 5, 8 };
+        for (size_t sections : sizes) {
+            BiquadCascade reference(biquadKernels(SimdLevel::Scalar));
+            BiquadCascade vector(biquadKernels(level));
+            for (size_t s = 0; s < sections; ++s) {
+                BiquadCoefficients c = BiquadCoefficients::design(
+                    BiquadType::Peaking, 200.0 * (s + 1), 2.0, Rate, s % 2 ? -4.0 : 5.0);
+                reference.setSection(s, c);
+                vector.setSection(s, c);
+            }
+            std::vector<float> a(input.size()), b(input.size());
+            size_t offset = 0;
+            for (size_t i = 0; offset < input.size(); ++i) {
+                size_t n = std::min(blocks[i % 10], input.size() - offset);
+                reference.process(input.data() + offset, a.data() + offset, n);
+                vector.process(input.data() + offset, b.data() + offset, n);
+                offset += n;
+            }
+            double err = 0.0;
+            for (size_t i = 0; i < a.size(); ++i)
+                err = std::max(err, static_cast<double>(std::fabs(a[i] - b[i])));
+            char what[64];
+            std::snprintf(what, sizeof(what), "cascade %zu sections (%s), max abs error",
+                          sections, simdLevelName(level));
+            check(what, err, 0.0, 1e-4);
+        }
+
+        const size_t channelCounts[] = { 3, 4, 6, 8 };
+        for (size_t channels : channelCounts) {
+            BiquadBank reference(channels, biquadKernels(SimdLevel::Scalar));
+            BiquadBank vector(channels, biquadKernels(level));
+            for (size_t ch = 0; ch < channels; ++ch) {
+                for (size_t s = 0; s < 2; ++s) {
+                    BiquadCoefficients c = BiquadCoefficients::design(
+                        s ? BiquadType::HighPass : BiquadType::LowPass, 300.0 * (ch + 1) * (s + 1),
+                        0.7071, Rate);
+                    reference.setSection(ch, s, c);
+                    vector.setSection(ch, s, c);
+                }
+            }
+            size_t frames = input.size() / channels;
+            std::vector<float> a(frames * channels), b(frames * channels);
+            reference.process(input.data(), a.data(), frames);
+            vector.process(input.data(), b.data(), frames);
+            double err = 0.0;
+            for (size_t i = 0; i < a.size(); ++i)
+                err = std::max(err, static_cast<double>(std::fabs(a[i] - b[i])));
+            char what[64];
+            std::snprintf(what, sizeof(what), "bank %zu channels (%s), max abs error",
+                          channels, simdLevelName(level));
+            check(what, err, 0.0, 1e-4);
+        }
+    }
+}
+
+} // namespace
+
+// Response and kernel checks, then throughput of each filter against the
+// original one-pole LowPassFilter at the live 256-sample chunk size.
+int benchFilter()
+{
+    failures = 0;
+    checkResponses();
+    checkKernels();
+    std::printf("%d check(s) failed\n", failures);
+
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(Rate * 5), Rate);
+    std::vector<float> input(signal.begin(), signal.end());
+    std::vector<float> output(input.size());
+    const size_t chunk = 256;
+
+    auto runStage = [&](const char* name, DspStage& stage) {
+        double ns = bestOfNs(5, [&] {
+            for (size_t offset = 0; offset < input.size(); offset += chunk) {
+                size_t n = std::min(chunk, input.size() - offset);
+                stage.process(input.data() + offset, output.data() + offset, n);
+            }
+            doNotOptimize(output.back());
+        });
+        printResult(name, Rate, input.size(), ns);
+    };
+
+    LowPassFilter onePole(3400.0, Rate);
+    runStage("LowPassFilter one-pole", onePole);
+    StateVariableFilter svf(BiquadType::LowPass, 3400.0, 0.7071, Rate);
+    runStage("StateVariableFilter", svf);
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    const size_t sectionCounts[] = { 1, 4, 8 };
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        for (size_t sections : sectionCounts) {
+            BiquadCascade cascade(biquadKernels(level));
+            for (size_t s = 0; s < sections; ++s)
+                cascade.setSection(s, BiquadCoefficients::design(
+                    BiquadType::LowPass, 3400.0, butterworthQ(sections, s), Rate));
+            char name[64];
+            std::snprintf(name, sizeof(name), "Biquad x%zu (%s)", sections, simdLevelName(level));
+            runStage(name, cascade);
+        }
+    }
+
+    // Banks: `frames` interleaved frames, reported per channel-sample
+    const size_t channelCounts[] = { 4, 8 };
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        for (size_t channels : channelCounts) {
+            BiquadBank bank(channels, biquadKernels(level));
+            for (size_t ch = 0; ch < channels; ++ch)
+                bank.setSection(ch, 0, BiquadCoefficients::design(
+                    BiquadType::BandPass, 200.0 * (ch + 1), 4.0, Rate));
+            size_t frames = input.size() / channels;
+            double ns = bestOfNs(5, [&] {
+                for (size_t offset = 0; offset < frames; offset += chunk) {
+                    size_t n = std::min(chunk, frames - offset);
+                    bank.process(input.data() + offset * channels, output.data() + offset * channels, n);
+                }
+                doNotOptimize(output[frames * channels - 1]);
+            });
+            char name[64];
+            std::snprintf(name, sizeof(name), "Bank %zu ch (%s)", channels, simdLevelName(level));
+            printResult(name, Rate, frames * channels, ns);
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,206 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/FormatConvert.h"
+
+// Every encoding, size and byte order the device converters handle
+static std::vector<SampleFormat> sampleTypes()
+{
+    std::vector<SampleFormat> types;
+    const SampleEncoding integers[] = { SampleEncoding::Signed, SampleEncoding::Unsigned };
+    for (SampleEncoding encoding : integers) {
+        types.push_back({ encoding, 8, false, 1 });
+        for (int bits = 16; bits <= 32; bits += 8) {
+            types.push_back({ encoding, bits, false, 1 });
+            types.push_back({ encoding, bits, true, 1 });
+        }
+    }
+    types.push_back({ SampleEncoding::Float, 32, false, 1 });
+    types.push_back({ SampleEncoding::Float, 32, true, 1 });
+    return types;
+}
+
+// Encode then decode stays within half a step (float rounding for the
+// wide formats), and for formats float holds exactly, decoding any code
+// and encoding it again gives the same bytes back.
+static int checkRoundTrips(const std::vector<float>& signal)
+{
+    int failures = 0;
+    const size_t frames = signal.size();
+    for (SampleFormat format : sampleTypes()) {
+        for (format.channels = 1; format.channels <= MAX_FORMAT_CHANNELS; ++format.channels) {
+            FormatConverter converter;
+            if (!formatConverter(format, SimdLevel::Scalar, &converter)) {
+                std::printf("  %-12s unsupported FAIL\n", sampleFormatName(format).c_str());
+                ++failures;
+                continue;
+            }
+            std::vector<uint8_t> bytes(frames * frameBytes(format));
+            std::vector<float> decoded(frames);
+            converter.fromFloat(signal.data(), bytes.data(), frames);
+            converter.toFloat(bytes.data(), decoded.data(), frames);
+            double worst = 0.0;
+            for (size_t i = 0; i < frames; ++i)
+                worst = std::max(worst, std::fabs(static_cast<double>(decoded[i]) - signal[i]));
+            const double step = format.encoding == SampleEncoding::Float ? 0.0 : std::ldexp(1.0, 1 - format.bits);
+            bool ok = worst <= 0.5 * step + 1.2e-7;
+
+            // Identical channels, so the mixdown is the channel itself
+            bool exact = true;
+            if (format.encoding != SampleEncoding::Float && format.bits <= 24) {
+                const size_t sampleBytes = format.bits / 8;
+                uint32_t seed = 12345;
+                for (size_t i = 0; i < frames; ++i) {
+                    uint8_t* frame = bytes.data() + i * frameBytes(format);
+                    for (size_t b = 0; b < sampleBytes; ++b) {
+                        seed = seed * 1664525u + 1013904223u;
+                        frame[b] = static_cast<uint8_t>(seed >> 24);
+                    }
+                    for (int c = 1; c < format.channels; ++c)
+                        std::memcpy(frame + c * sampleBytes, frame, sampleBytes);
+                }
+                std::vector<uint8_t> again(bytes.size());
+                converter.toFloat(bytes.data(), decoded.data(), frames);
+                converter.fromFloat(decoded.data(), again.data(), frames);
+                exact = again == bytes;
+            }
+            if (!ok || !exact) {
+                std::printf("  %-12s round trip error %.3g (step %.3g)%s FAIL\n", sampleFormatName(format).c_str(),
+                            worst, step, exact ? "" : ", codes changed");
+                ++failures;
+            }
+        }
+    }
+    std::printf("  round trips of %zu formats x %d channel counts checked\n", sampleTypes().size(),
+                MAX_FORMAT_CHANNELS);
+    return failures;
+}
+
+// SIMD kernels against the scalar ones, bit for bit, on a length with a
+// tail and on input that clips, has NaNs and odd halves to round.
+static int checkSimdKernels(const std::vector<float>& signal)
+{
+    int failures = 0;
+    std::vector<float> input(signal);
+    input[3] = std::numeric_limits<float>::quiet_NaN();
+    input[10] = 4.0f;
+    input[11] = -4.0f;
+    for (size_t i = 0; i < input.size(); i += 7)
+        input[i] *= 1.5f;
+
+    const SimdLevel levels[] = { SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    const SampleFormat formats[] = {
+        { SampleEncoding::Signed, 16, false, 1 }, { SampleEncoding::Signed, 16, false, 2 },
+        { SampleEncoding::Float, 32, false, 1 }, { SampleEncoding::Float, 32, false, 2 },
+    };
+    const size_t frames = input.size();
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        for (const SampleFormat& format : formats) {
+            FormatConverter scalar, simd;
+            formatConverter(format, SimdLevel::Scalar, &scalar);
+            formatConverter(format, level, &simd);
+
+            std::vector<uint8_t> bytes(frames * frameBytes(format)), simdBytes(bytes.size());
+            scalar.fromFloat(input.data(), bytes.data(), frames);
+            simd.fromFloat(input.data(), simdBytes.data(), frames);
+            bool ok = bytes == simdBytes;
+
+            // Raw device input: every code, including the int16 extremes
+            // and an odd sum in each stereo pair
+            if (format.encoding == SampleEncoding::Signed) {
+                int16_t* codes = reinterpret_cast<int16_t*>(bytes.data());
+                for (size_t i = 0; i < frames * format.channels; ++i)
+                    codes[i] = static_cast<int16_t>(i * 2654435761u >> 7);
+                codes[0] = codes[1] = -32768;
+                codes[2] = codes[3] = 32767;
+            }
+            std::vector<float> floats(frames), simdFloats(frames);
+            std::vector<int16_t> pcm(frames), simdPcm(frames);
+            scalar.toFloat(bytes.data(), floats.data(), frames);
+            simd.toFloat(bytes.data(), simdFloats.data(), frames);
+            scalar.toInt16(bytes.data(), pcm.data(), frames);
+            simd.toInt16(bytes.data(), simdPcm.data(), frames);
+            ok = ok && std::memcmp(floats.data(), simdFloats.data(), frames * sizeof(float)) == 0 && pcm == simdPcm;
+
+            std::printf("  %-12s %-6s matches scalar %s\n", sampleFormatName(format).c_str(),
+                        simdLevelName(simd.level), ok ? "ok" : "FAIL");
+            failures += ok ? 0 : 1;
+        }
+    }
+    return failures;
+}
+
+// Device format conversion at both ends of the live path: capture into
+// the int16 jitter buffer, playback from the float chain output, and the
+// float decode the offline path uses. One 256-frame block at a time, per
+// format and kernel set; the interleaved formats move `channels` times the
+// bytes of mono for the same frames.
+int benchFormat()
+{
+    const size_t block = 256;
+    const size_t passes = 20000;
+    const size_t total = block * passes;
+    std::vector<double> test = makeTestSignal(block, 44100.0);
+    std::vector<float> signal(block);
+    for (size_t i = 0; i < block; ++i)
+        signal[i] = static_cast<float>(test[i] * 0.9);
+
+    std::vector<uint8_t> bytes(block * 4 * 2);
+    std::vector<float> floatOut(block);
+    std::vector<int16_t> pcmOut(block);
+    const SimdLevel best = detectSimdLevel();
+    for (SampleFormat format : sampleTypes()) {
+        for (format.channels = 1; format.channels <= 2; ++format.channels) {
+            const bool hasSimd = !format.bigEndian && format.bits >= 16
+                && (format.encoding == SampleEncoding::Float || (format.encoding == SampleEncoding::Signed
+                                                                 && format.bits == 16));
+            const SimdLevel levels[] = { SimdLevel::Scalar, best };
+            for (int l = 0; l < (hasSimd && best != SimdLevel::Scalar ? 2 : 1); ++l) {
+                FormatConverter converter;
+                formatConverter(format, levels[l], &converter);
+                converter.fromFloat(signal.data(), bytes.data(), block);
+
+                double toInt16 = bestOfNs(5, [&] {
+                    for (size_t p = 0; p < passes; ++p)
+                        converter.toInt16(bytes.data(), pcmOut.data(), block);
+                    doNotOptimize(pcmOut[block - 1]);
+                });
+                double toFloat = bestOfNs(5, [&] {
+                    for (size_t p = 0; p < passes; ++p)
+                        converter.toFloat(bytes.data(), floatOut.data(), block);
+                    doNotOptimize(floatOut[block - 1]);
+                });
+                double fromFloat = bestOfNs(5, [&] {
+                    for (size_t p = 0; p < passes; ++p)
+                        converter.fromFloat(signal.data(), bytes.data(), block);
+                    doNotOptimize(bytes[0]);
+                });
+
+                std::string name = sampleFormatName(format) + " (" + simdLevelName(converter.level) + ")";
+                recordResult(name + " ->int16", 0.0, block, total, toInt16);
+                recordResult(name + " ->float", 0.0, block, total, toFloat);
+                recordResult(name + " <-float", 0.0, block, total, fromFloat);
+                std::printf("%-22s %9.1f ->int16 %9.1f ->float %9.1f <-float Mframes/sec\n", name.c_str(),
+                            total / toInt16 * 1e3, total / toFloat * 1e3, total / fromFloat * 1e3);
+            }
+        }
+    }
+
+    std::vector<double> sweep = makeTestSignal(1027, 44100.0);
+    std::vector<float> checkSignal(sweep.size());
+    for (size_t i = 0; i < sweep.size(); ++i)
+        checkSignal[i] = static_cast<float>(sweep[i] * 0.99);
+    int failures = checkRoundTrips(checkSignal);
+    failures += checkSimdKernels(checkSignal);
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/EffectChain.h"
+#include "../dsp/LatencyProbe.h"
+
+// Every stage's reported latency() against the delay the probe measures,
+// so compensation (offline alignment, the latency readout) stays honest.
+// Waveform matches may exceed the report by a filter's group delay;
+// envelope matches (pitch shifters) are good to a few ms.
+int benchLatency()
+{
+    const double rate = 48000.0;
+    const std::string irPath = "voiceBench-latency-ir.wav";
+    // A room with a clear direct sound; a bare noise IR has no delay to find
+    std::vector<float> ir = makeImpulseResponse(static_cast<size_t>(rate / 4), 3);
+    for (float& x : ir)
+        x *= 0.3f;
+    ir[0] = 0.9f;
+    writeTestWav(irPath, ir, static_cast<int>(rate));
+
+    std::vector<std::string> specs;
+    for (const StageType& type : StageRegistry::instance().types())
+        specs.push_back(type.name);
+    specs.push_back("pitch factor=1");
+    specs.push_back("pitch engine=vocoder");
+    specs.push_back("pitch engine=vocoder factor=1");
+    specs.push_back("convolver direct=0");
+
+    int failures = 0;
+    for (std::string spec : specs) {
+        if (spec.compare(0, 9, "convolver") == 0)
+            spec += " ir=" + irPath;
+        EffectChain chain(256);
+        if (!chain.build(spec, rate)) {
+            std::printf("%s: %s\n", spec.c_str(), chain.errorString().c_str());
+            ++failures;
+            continue;
+        }
+        DelayEstimate estimate = measureStageDelay(chain, rate, static_cast<size_t>(rate));
+        double difference = static_cast<double>(estimate.samples) - static_cast<double>(chain.latency());
+        double tolerance = estimate.envelope ? 0.005 * rate : 16.0;
+        // Early reflections can pull a waveform peak a sample or two early
+        bool ok = difference >= (estimate.envelope ? -tolerance : -2.0) && difference <= tolerance;
+        failures += ok ? 0 : 1;
+        std::printf("  %-40.40s reports %5zu, measured %5zu (%s %.2f) %s\n", spec.c_str(), chain.latency(),
+                    estimate.samples, estimate.envelope ? "envelope" : "waveform", estimate.confidence,
+                    ok ? "ok" : "FAIL");
+    }
+    std::remove(irPath.c_str());
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/PhaseVocoder.h"
+
+namespace {
+
+double runVocoder(const std::vector<float>& input, double rate, size_t fftSize,
+                  PhaseVocoder::FormantMode mode, size_t* frames) {
+    PhaseVocoder vocoder(0.7, rate, fftSize);
+    vocoder.setFormantMode(mode);
+    *frames = input.size() / vocoder.hopSize();
+    std::vector<float> output(input.size());
+    return bestOfNs(3, [&] {
+        vocoder.reset();
+        for (size_t offset = 0; offset < input.size(); offset += 256) {
+            size_t count = std::min<size_t>(256, input.size() - offset);
+            vocoder.process(input.data() + offset, output.data() + offset, count);
+        }
+        doNotOptimize(output.back());
+    });
+}
+
+} // namespace
+
+int benchPhaseVocoder()
+{
+    const double rate = 44100.0;
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(rate * 5), rate);
+    std::vector<float> input(signal.begin(), signal.end());
+    const size_t sizes[] = { 512, 1024, 2048, 4096 };
+
+    for (int formants = 0; formants < 2; ++formants) {
+        PhaseVocoder::FormantMode mode = formants ? PhaseVocoder::FormantMode::Preserve
+                                                  : PhaseVocoder::FormantMode::Off;
+        for (size_t fftSize : sizes) {
+            size_t frames = 0;
+            double ns = runVocoder(input, rate, fftSize, mode, &frames);
+            char name[64];
+            std::snprintf(name, sizeof(name), "PhaseVocoder %zu%s", fftSize,
+                          formants ? " formant" : "");
+            printResult(name, rate, input.size(), ns);
+            std::printf("%-32s %12.0f frames/sec (hop %zu)\n", "",
+                        frames / (ns * 1e-9), fftSize / 4);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/PitchShifter.h"
+
+namespace {
+
+// The original vector-backed implementation, kept here as the baseline.
+class LegacyPitchShifter {
+public:
+    LegacyPitchShifter(double pitchFactor, double sampleRate)
+        : factor(pitchFactor), sampleRate(sampleRate) {}
+
+    double processSample(double input) {
+        buffer.push_back(input);
+        if (buffer.size() > static_cast<size_t>(1.0 / factor * sampleRate)) {
+            double output = buffer.front();
+            buffer.erase(buffer.begin());
+            return output;
+        }
+        return 0.0;
+    }
+
+private:
+    double factor;
+    double sampleRate;
+    std::vector<double> buffer;
+};
+
+template <typename Shifter>
+double runShifter(const std::vector<double>& input, double sampleRate) {
+    return bestOfNs(3, [&] {
+        Shifter shifter(0.8, sampleRate);
+        double sum = 0.0;
+        for (double sample : input)
+            sum += shifter.processSample(sample);
+        doNotOptimize(sum);
+    });
+}
+
+// Frequency of the strongest spectral peak between lo and hi (Goertzel scan).
+double peakFrequency(const std::vector<double>& signal, size_t skip, double sampleRate,
+                     double lo, double hi) {
+    double bestFrequency = lo, bestPower = -1.0;
+    for (double f = lo; f <= hi; f += 0.5) {
+        double coeff = 2.0 * std::cos(2 * PI * f / sampleRate);
+        double s1 = 0.0, s2 = 0.0;
+        for (size_t i = skip; i < signal.size(); ++i) {
+            double s0 = signal[i] + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+        if (power > bestPower) {
+            bestPower = power;
+            bestFrequency = f;
+        }
+    }
+    return bestFrequency;
+}
+
+// Offline sanity check: a pure tone must come out at ratio * frequency,
+// within 1%.
+bool checkPitchRatio(double ratio, double sampleRate) {
+    const double frequency = 220.0;
+    std::vector<double> output(static_cast<size_t>(sampleRate * 2));
+    PitchShifter shifter(ratio, sampleRate);
+    for (size_t i = 0; i < output.size(); ++i)
+        output[i] = shifter.processSample(0.5 * std::sin(2 * PI * frequency * i / sampleRate));
+
+    double measured = peakFrequency(output, static_cast<size_t>(sampleRate * 0.1), sampleRate,
+                                    frequency * 0.25, frequency * 2.0);
+    bool ok = std::fabs(measured / (ratio * frequency) - 1.0) <= 0.01;
+    std::printf("%-32s %7.0f Hz   ratio %.3f -> measured %.3f (%.1f Hz) %s\n",
+                "PitchShifter accuracy", sampleRate, ratio, measured / frequency, measured,
+                ok ? "ok" : "FAIL");
+    return ok;
+}
+
+} // namespace
+
+int benchPitchShifter()
+{
+    const double rates[] = { 44100.0, 48000.0 };
+    for (double rate : rates) {
+        // Two seconds so the legacy buffer is full for most of the run
+        std::vector<double> input = makeTestSignal(static_cast<size_t>(rate * 2), rate);
+        printResult("PitchShifter (vector erase)", rate, input.size(),
+                    runShifter<LegacyPitchShifter>(input, rate));
+        printResult("PitchShifter (granular)", rate, input.size(),
+                    runShifter<PitchShifter>(input, rate));
+    }
+
+    int failures = 0;
+    const double ratios[] = { 0.5, 0.8, 1.25, 1.5 };
+    for (double ratio : ratios)
+        failures += checkPitchRatio(ratio, 44100.0) ? 0 : 1;
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
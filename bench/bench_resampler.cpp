@@ -0,0 +1,187 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/PolyphaseResampler.h"
+
+// Runs `input` through a fresh resampler in uneven chunks, as capture
+// callbacks would deliver it
+static std::vector<float> resampleAll(PolyphaseResampler& resampler, const std::vector<float>& input,
+                                      bool* withinBound)
+{
+    resampler.reset();
+    std::vector<float> output(resampler.maxOutput(input.size()) + 64);
+    size_t produced = 0;
+    *withinBound = true;
+    const size_t chunks[] = { 256, 1, 441, 37, 1024, 480 };
+    for (size_t offset = 0, c = 0; offset < input.size(); offset += chunks[c % 6], ++c) {
+        size_t count = std::min(chunks[c % 6], input.size() - offset);
+        size_t got = resampler.process(input.data() + offset, count, output.data() + produced);
+        *withinBound = *withinBound && got <= resampler.maxOutput(count);
+        produced += got;
+    }
+    output.resize(produced);
+    return output;
+}
+
+struct ToneFit {
+    double gainDb;     // Of the tone against `amplitude`
+    double residualDb; // Everything else, against the tone's power
+};
+
+// Least-squares fit of a sine at `frequency` to `signal` from `start` on
+static ToneFit fitTone(const std::vector<float>& signal, size_t start, double frequency, double rate,
+                       double amplitude)
+{
+    double cc = 0.0, ss = 0.0, cs = 0.0, yc = 0.0, ys = 0.0, yy = 0.0;
+    for (size_t i = start; i < signal.size(); ++i) {
+        double c = std::cos(2.0 * PI * frequency * i / rate);
+        double s = std::sin(2.0 * PI * frequency * i / rate);
+        double y = signal[i];
+        cc += c * c;
+        ss += s * s;
+        cs += c * s;
+        yc += y * c;
+        ys += y * s;
+        yy += y * y;
+    }
+    double det = cc * ss - cs * cs;
+    double a = (yc * ss - ys * cs) / det;
+    double b = (ys * cc - yc * cs) / det;
+    double tone = a * a * cc + 2.0 * a * b * cs + b * b * ss;
+    ToneFit fit;
+    fit.gainDb = 20.0 * std::log10(std::sqrt(a * a + b * b) / amplitude);
+    fit.residualDb = 10.0 * std::log10(std::max(yy - tone, 1e-30) / tone);
+    return fit;
+}
+
+static std::vector<float> makeTone(double frequency, double rate, size_t frames, double amplitude)
+{
+    std::vector<float> tone(frames);
+    for (size_t i = 0; i < frames; ++i)
+        tone[i] = static_cast<float>(amplitude * std::sin(2.0 * PI * frequency * i / rate));
+    return tone;
+}
+
+// 44.1 <-> 48 kHz, the pair real devices disagree on: the passband is
+// flat and clean (images of upsampling would show up as residual), tones
+// above the lower Nyquist frequency do not alias back in, the output
+// length follows the ratio, and every SIMD kernel agrees with scalar.
+static int checkResampler(int inRate, int outRate)
+{
+    const double amplitude = 0.5;
+    const double lower = std::min(inRate, outRate);
+    int failures = 0;
+
+    PolyphaseResampler resampler(dotProductKernel(detectSimdLevel()));
+    resampler.configure(inRate, outRate);
+    const size_t frames = static_cast<size_t>(inRate / 2);
+    const size_t settle = static_cast<size_t>(2.0 * resampler.latency()) + 64;
+    std::printf("  %d -> %d Hz: %d phases x %zu taps, %.1f frames delay\n", inRate, outRate, resampler.phases(),
+                resampler.tapsPerPhase(), resampler.latency());
+
+    const double passband[] = { 100.0, 1000.0, 5000.0, 10000.0, 15000.0, 0.43 * lower };
+    double worstGain = 0.0, worstResidual = -1000.0;
+    bool bounded = true;
+    for (double frequency : passband) {
+        bool withinBound;
+        std::vector<float> out = resampleAll(resampler, makeTone(frequency, inRate, frames, amplitude),
+                                             &withinBound);
+        bounded = bounded && withinBound;
+        double expected = frames * static_cast<double>(outRate) / inRate;
+        if (std::fabs(static_cast<double>(out.size()) - expected) > 2.0) {
+            std::printf("    %zu frames out for %.1f expected FAIL\n", out.size(), expected);
+            ++failures;
+        }
+        ToneFit fit = fitTone(out, settle, frequency, outRate, amplitude);
+        worstGain = std::max(worstGain, std::fabs(fit.gainDb));
+        worstResidual = std::max(worstResidual, fit.residualDb);
+    }
+    bool ok = worstGain < 0.01 && worstResidual < -85.0 && bounded;
+    std::printf("    passband to %.0f Hz: gain within %.4f dB, residual %.1f dB %s\n", 0.43 * lower, worstGain,
+                worstResidual, ok ? "ok" : "FAIL");
+    failures += ok ? 0 : 1;
+
+    if (inRate > outRate) {
+        const double stopband[] = { 0.505 * outRate, 0.52 * outRate, 0.49 * inRate };
+        double worst = -1000.0;
+        for (double frequency : stopband) {
+            bool withinBound;
+            std::vector<float> out = resampleAll(resampler, makeTone(frequency, inRate, frames, amplitude),
+                                                 &withinBound);
+            double energy = 0.0;
+            for (size_t i = settle; i < out.size(); ++i)
+                energy += static_cast<double>(out[i]) * out[i];
+            double level = 10.0 * std::log10(std::max(energy / (out.size() - settle), 1e-30)
+                                             / (amplitude * amplitude / 2.0));
+            worst = std::max(worst, level);
+        }
+        ok = worst < -85.0;
+        std::printf("    aliasing of %.0f-%.0f Hz: %.1f dB %s\n", 0.505 * outRate, 0.49 * inRate, worst,
+                    ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    }
+
+    std::vector<double> test = makeTestSignal(frames, inRate);
+    std::vector<float> signal(test.begin(), test.end());
+    PolyphaseResampler scalar(dotProductScalar);
+    scalar.configure(inRate, outRate);
+    bool withinBound;
+    std::vector<float> reference = resampleAll(scalar, signal, &withinBound);
+    const SimdLevel levels[] = { SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    for (SimdLevel level : levels) {
+        if (!simdLevelSupported(level))
+            continue;
+        PolyphaseResampler simd(dotProductKernel(level));
+        simd.configure(inRate, outRate);
+        std::vector<float> out = resampleAll(simd, signal, &withinBound);
+        double worst = out.size() == reference.size() ? 0.0 : 1.0;
+        for (size_t i = 0; i < std::min(out.size(), reference.size()); ++i)
+            worst = std::max(worst, static_cast<double>(std::fabs(out[i] - reference[i])));
+        ok = worst < 1e-5;
+        std::printf("    %-6s against scalar: max difference %.2g %s\n", simdLevelName(level), worst,
+                    ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    }
+    return failures;
+}
+
+// The capture-side rate bridge: input frames per second converted, per
+// rate pair and kernel, in 256-frame blocks like a capture callback.
+int benchResampler()
+{
+    const int pairs[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 16000, 48000 }, { 48000, 16000 } };
+    const size_t block = 256;
+    const size_t total = block * 4000;
+    std::vector<double> test = makeTestSignal(block, 48000.0);
+    std::vector<float> input(test.begin(), test.end());
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+    for (const int* pair : pairs) {
+        for (SimdLevel level : levels) {
+            if (!simdLevelSupported(level))
+                continue;
+            PolyphaseResampler resampler(dotProductKernel(level));
+            resampler.configure(pair[0], pair[1]);
+            std::vector<float> output(resampler.maxOutput(block));
+            double ns = bestOfNs(5, [&] {
+                for (size_t p = 0; p < total / block; ++p)
+                    resampler.process(input.data(), block, output.data());
+                doNotOptimize(output[0]);
+            });
+            std::string name = std::to_string(pair[0]) + "->" + std::to_string(pair[1]) + " ("
+                             + simdLevelName(level) + ")";
+            recordResult(name, pair[0], block, total, ns);
+            std::printf("%-26s %9.1f Msamples/sec, %5.1fx real time per core\n", name.c_str(),
+                        total / ns * 1e3, total / ns * 1e9 / pair[0]);
+        }
+    }
+
+    int failures = checkResampler(44100, 48000);
+    failures += checkResampler(48000, 44100);
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/SpscRingBuffer.h"
+
+namespace {
+
+struct StressRun {
+    uint64_t mismatches; // Values that were not the next in the sequence
+    uint64_t received;
+    uint64_t discarded;
+    uint64_t wrapped;    // Reads that crossed the end of the storage
+    bool overfilled;     // availableToRead() ever above capacity()
+};
+
+// A producer thread writes a counting sequence in chunks of 1..maxChunk
+// elements and a consumer thread reads it back in chunks of a different
+// size pattern, checking every value; with `discard` set the consumer
+// also drops a few elements now and then and skips ahead by as many.
+// Both sides yield at random points as well as on a full or empty ring:
+// on one core, a side that only yielded when blocked would always hand
+// over a full or empty ring and no chunk would ever straddle the wrap.
+StressRun stressRing(size_t capacity, size_t maxChunk, uint64_t total, bool discard) {
+    SpscRingBuffer<uint32_t> ring(capacity);
+    StressRun run = { 0, 0, 0, 0, false };
+
+    std::thread producer([&] {
+        std::vector<uint32_t> chunk(maxChunk);
+        uint32_t seed = 1;
+        uint64_t next = 0;
+        while (next < total) {
+            seed = seed * 1664525u + 1013904223u;
+            size_t count = std::min<uint64_t>(1 + (seed >> 8) % maxChunk, total - next);
+            for (size_t i = 0; i < count; ++i)
+                chunk[i] = static_cast<uint32_t>(next + i);
+            size_t written = 0;
+            while (written < count) {
+                written += ring.write(chunk.data() + written, count - written);
+                if (written < count)
+                    std::this_thread::yield();
+            }
+            next += count;
+            if ((seed >> 24) % 8 == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    std::vector<uint32_t> chunk(maxChunk);
+    uint32_t seed = 7;
+    uint64_t expected = 0;
+    while (expected < total) {
+        seed = seed * 22695477u + 1u;
+        if (ring.availableToRead() > ring.capacity())
+            run.overfilled = true;
+        if (discard && (seed >> 16) % 97 == 0) {
+            size_t dropped = ring.discard(1 + (seed >> 8) % 5);
+            expected += dropped;
+            run.discarded += dropped;
+            continue;
+        }
+        size_t got = ring.read(chunk.data(), 1 + (seed >> 8) % maxChunk);
+        if (got == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < got; ++i) {
+            if (chunk[i] != static_cast<uint32_t>(expected + i))
+                ++run.mismatches;
+        }
+        if ((expected & (ring.capacity() - 1)) + got > ring.capacity())
+            ++run.wrapped;
+        expected += got;
+        run.received += got;
+        if ((seed >> 24) % 8 == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+    if (ring.availableToRead() != 0)
+        ++run.mismatches; // Elements past the end of the sequence
+    return run;
+}
+
+} // namespace
+
+// SPSC ring buffer across two real threads: ordering and loss checks over
+// ring sizes from one that wraps every few chunks to the live output size,
+// reported as elements per second through the ring.
+int benchRingBuffer()
+{
+    struct Setting { size_t capacity; size_t maxChunk; bool discard; };
+    const Setting settings[] = {
+        { 16, 7, false },
+        { 1000, 300, false },
+        { 4096, 4096, false },
+        { 1000, 300, true },
+    };
+    const uint64_t total = 20000000;
+
+    int failures = 0;
+    for (const Setting& setting : settings) {
+        StressRun run;
+        double ns = bestOfNs(1, [&] {
+            run = stressRing(setting.capacity, setting.maxChunk, total, setting.discard);
+        });
+        bool ok = run.mismatches == 0 && run.received + run.discarded == total && !run.overfilled
+               && run.wrapped > 0;
+        char name[64];
+        std::snprintf(name, sizeof(name), "SpscRingBuffer %zu / %zu%s", nextPowerOfTwo(setting.capacity),
+                      setting.maxChunk, setting.discard ? " +discard" : "");
+        recordResult(name, 0.0, setting.maxChunk, total, ns);
+        std::printf("%-36s %9.1f Melements/sec  received %llu  discarded %llu  wrapped reads %llu"
+                    "  mismatches %llu %s\n", name, total / ns * 1e3,
+                    static_cast<unsigned long long>(run.received), static_cast<unsigned long long>(run.discarded),
+                    static_cast<unsigned long long>(run.wrapped), static_cast<unsigned long long>(run.mismatches),
+                    ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    }
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
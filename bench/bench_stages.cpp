@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/EffectChain.h"
+
+// Every registered stage with its default settings, alone, at each
+// power-of-two block size from 32 to 4096 frames and at the common device
+// rates; one second of audio per point. Stages registered later are picked
+// up without changes here. The convolver gets a 0.5 s synthetic IR.
+int benchStages()
+{
+    const std::string irPath = "voiceBench-stages-ir.wav";
+    const double rates[] = { 44100.0, 48000.0, 96000.0 };
+
+    // Defaults plus settings that switch to a different algorithm
+    std::vector<std::string> specs;
+    for (const StageType& type : StageRegistry::instance().types())
+        specs.push_back(type.name);
+    specs.push_back("pitch engine=vocoder");
+    specs.push_back("pitch engine=vocoder formants=1");
+
+    for (const std::string& name : specs) {
+        for (double rate : rates) {
+            std::string spec = name;
+            if (spec == "convolver") {
+                writeTestWav(irPath, makeImpulseResponse(static_cast<size_t>(rate / 2), 11),
+                             static_cast<int>(rate));
+                spec += " ir=" + irPath;
+            }
+            std::vector<double> signal = makeTestSignal(static_cast<size_t>(rate), rate);
+            std::vector<float> input(signal.begin(), signal.end());
+            std::vector<float> output(input.size());
+
+            for (size_t block = 32; block <= 4096; block *= 2) {
+                EffectChain chain(block);
+                if (!chain.build(spec, rate)) {
+                    std::printf("%s: %s\n", name.c_str(), chain.errorString().c_str());
+                    break;
+                }
+                double ns = bestOfNs(3, [&] {
+                    chain.reset();
+                    for (size_t offset = 0; offset < input.size(); offset += block) {
+                        size_t count = std::min(block, input.size() - offset);
+                        chain.process(input.data() + offset, output.data() + offset, count);
+                    }
+                    doNotOptimize(output.back());
+                });
+                printResult(name.c_str(), rate, input.size(), ns, block);
+            }
+        }
+    }
+    std::remove(irPath.c_str());
+    return 0;
+}
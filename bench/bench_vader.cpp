@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/AllocationCounter.h"
+#include "../dsp/EffectChain.h"
+
+namespace {
+
+const double Rate = 48000.0;
+const size_t Chunk = 256;
+
+// Runs `chain` over `input` in live-sized chunks; returns the best time
+// and reports the heap calls made across all the runs
+double runChain(EffectChain& chain, const std::vector<float>& input, std::vector<float>& output,
+                uint64_t* allocations) {
+    uint64_t before = allocationCount();
+    double ns = bestOfNs(5, [&] {
+        for (size_t offset = 0; offset < input.size(); offset += Chunk) {
+            size_t n = std::min(Chunk, input.size() - offset);
+            chain.process(input.data() + offset, output.data() + offset, n);
+        }
+        doNotOptimize(output.back());
+    });
+    *allocations = allocationCount() - before;
+    return ns;
+}
+
+void printCost(const char* name, size_t samples, double ns, uint64_t allocations) {
+    recordResult(name, Rate, Chunk, samples, ns);
+    double seconds = samples / Rate;
+    double core = ns * 1e-9 / seconds * 100.0;
+    std::printf("%-32s %7.0f Hz %12.2f ns/sample %8.3f%% of a core  heap calls %llu\n",
+                name, Rate, ns / samples, core, static_cast<unsigned long long>(allocations));
+}
+
+double rms(const float* x, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+        sum += static_cast<double>(x[i]) * x[i];
+    return std::sqrt(sum / n);
+}
+
+} // namespace
+
+// The character presets at 48 kHz in 256-frame chunks, as the live
+// callback runs them, against the 5%-of-one-core budget, then each of
+// their stages alone. Finally the breath generator's level on silence and
+// under speech, to show the ducking.
+int benchVader()
+{
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(Rate * 10), Rate);
+    std::vector<float> input(signal.begin(), signal.end());
+    std::vector<float> output(input.size());
+
+    int failures = 0;
+    for (const ChainPreset& preset : CHAIN_PRESETS) {
+        EffectChain chain(Chunk);
+        if (!chain.build(preset.spec, Rate)) {
+            std::printf("%s: %s FAIL\n", preset.name, chain.errorString().c_str());
+            ++failures;
+            continue;
+        }
+        uint64_t allocations = 0;
+        double ns = runChain(chain, input, output, &allocations);
+        std::string name = std::string("Preset ") + preset.name;
+        printCost(name.c_str(), input.size(), ns, allocations);
+        bool finite = std::all_of(output.begin(), output.end(), [](float x) { return std::isfinite(x); });
+        float peak = 0.0f;
+        for (float x : output)
+            peak = std::max(peak, std::fabs(x));
+        std::printf("    %s, peak %.2f, budget %s\n", finite ? "finite" : "NOT FINITE", peak,
+                    ns * 1e-9 / (input.size() / Rate) < 0.05 ? "met" : "EXCEEDED");
+        failures += finite ? 0 : 1;
+    }
+
+    std::vector<StageConfig> configs;
+    std::string error;
+    parseChainSpec(findChainPreset("vader")->spec, &configs, &error);
+    for (const StageConfig& config : configs) {
+        EffectChain single(Chunk);
+        single.build(std::vector<StageConfig>(1, config), Rate);
+        uint64_t allocations = 0;
+        double ns = runChain(single, input, output, &allocations);
+        printCost(("    " + config.type).c_str(), input.size(), ns, allocations);
+    }
+
+    EffectChain breath(Chunk);
+    breath.build("breath level=0.2 period=4 duck=0.8", Rate);
+    std::vector<float> silence(input.size(), 0.0f);
+    for (size_t offset = 0; offset < silence.size(); offset += Chunk)
+        breath.process(silence.data() + offset, output.data() + offset, std::min(Chunk, silence.size() - offset));
+    double quiet = rms(output.data(), output.size());
+    breath.reset();
+    for (size_t offset = 0; offset < input.size(); offset += Chunk)
+        breath.process(input.data() + offset, output.data() + offset, std::min(Chunk, input.size() - offset));
+    for (size_t i = 0; i < output.size(); ++i)
+        output[i] -= input[i];
+    double ducked = rms(output.data(), output.size());
+    std::printf("Breath rms on silence %.4f, under speech %.4f (%.1f dB)\n", quiet, ducked,
+                20.0 * std::log10(ducked / quiet));
+    std::printf("%d check(s) failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/Wsola.h"
+
+namespace {
+
+// Streams `input` through the stretcher in `chunk`-frame pieces, like the
+// qtst AudioProcessor does, and drains the output as it goes.
+double runWsola(const std::vector<int16_t>& input, double rate, size_t chunk, double pitch,
+                double tempo, SimdLevel level, size_t* framesOut) {
+    Wsola stretcher;
+    stretcher.setSampleRate(static_cast<int>(rate));
+    stretcher.setChannels(1);
+    stretcher.setSimdLevel(level);
+    stretcher.setPitch(pitch);
+    stretcher.setTempo(tempo);
+
+    std::vector<int16_t> out(4096);
+    size_t total = 0;
+    double ns = bestOfNs(3, [&] {
+        stretcher.clear();
+        total = 0;
+        for (size_t offset = 0; offset < input.size(); offset += chunk) {
+            size_t count = std::min(chunk, input.size() - offset);
+            stretcher.putSamples(input.data() + offset, count);
+            while (size_t received = stretcher.receiveSamples(out.data(), out.size()))
+                total += received;
+        }
+    });
+    *framesOut = total;
+    return ns;
+}
+
+std::vector<int16_t> makePcm(double rate, double seconds) {
+    std::vector<double> signal = makeTestSignal(static_cast<size_t>(rate * seconds), rate);
+    std::vector<int16_t> pcm(signal.size());
+    for (size_t i = 0; i < signal.size(); ++i)
+        pcm[i] = static_cast<int16_t>(signal[i] * 32767.0);
+    return pcm;
+}
+
+} // namespace
+
+// The stretcher that replaced SoundTouch in the qtst build: each kernel at
+// its 1024-frame chunks, then the detected kernel across chunk sizes and
+// rates.
+int benchWsola()
+{
+    struct Setting { const char* name; double pitch; double tempo; };
+    const Setting settings[] = {
+        { "Wsola pitch 0.8", 0.8, 1.0 },
+        { "Wsola tempo 1.25", 1.0, 1.25 },
+    };
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon };
+
+    std::vector<int16_t> input = makePcm(44100.0, 30.0);
+    for (const Setting& setting : settings) {
+        for (SimdLevel level : levels) {
+            if (!simdLevelSupported(level))
+                continue;
+            size_t framesOut = 0;
+            double ns = runWsola(input, 44100.0, 1024, setting.pitch, setting.tempo, level, &framesOut);
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s (%s)", setting.name, simdLevelName(level));
+            printResult(name, 44100.0, input.size(), ns, 1024);
+        }
+    }
+
+    const double rates[] = { 44100.0, 48000.0 };
+    for (double rate : rates) {
+        std::vector<int16_t> pcm = makePcm(rate, 5.0);
+        for (const Setting& setting : settings) {
+            for (size_t chunk = 32; chunk <= 4096; chunk *= 2) {
+                size_t framesOut = 0;
+                double ns = runWsola(pcm, rate, chunk, setting.pitch, setting.tempo,
+                                     detectSimdLevel(), &framesOut);
+                printResult(setting.name, rate, pcm.size(), ns, chunk);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Benchmarks.h"
+#include "../dsp/AllocationHooks.h"
+#include "../dsp/Simd.h"
+
+struct BenchmarkEntry {
+    const char* name;
+    int (*run)(); // Returns the number of failed checks
+};
+
+static const BenchmarkEntry benchmarks[] = {
+    { "ringbuffer", benchRingBuffer },
+    { "chain", benchChain },
+    { "convert", benchConvert },
+    { "formats", benchFormat },
+    { "filter", benchFilter },
+    { "pitchshifter", benchPitchShifter },
+    { "wsola", benchWsola },
+    { "phasevocoder", benchPhaseVocoder },
+    { "drift", benchDrift },
+    { "resampler", benchResampler },
+    { "callback", benchCallback },
+    { "vader", benchVader },
+    { "convolver", benchConvolver },
+    { "stages", benchStages },
+    { "latency", benchLatency },
+};
+
+// JSON string literal for `text`
+static std::string quoted(const std::string& text)
+{
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// The recorded results as one JSON document or CSV table. `label` tags the
+// run (a commit hash, say) so files from different builds can be compared.
+static bool writeRecords(const std::string& path, bool json, const std::string& label)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "cannot create %s\n", path.c_str());
+        return false;
+    }
+    const char* simd = simdLevelName(detectSimdLevel());
+    if (json) {
+        std::fprintf(file, "{\n  \"label\": %s,\n  \"simd\": \"%s\",\n  \"results\": [",
+                     quoted(label).c_str(), simd);
+    } else {
+        std::fprintf(file, "label,simd,benchmark,name,sample_rate,block,samples,ns,ns_per_sample,"
+                           "samples_per_sec\n");
+    }
+    const std::vector<BenchRecord>& records = benchRecords();
+    for (size_t i = 0; i < records.size(); ++i) {
+        const BenchRecord& r = records[i];
+        double nsPerSample = r.ns / r.samples;
+        if (json) {
+            std::fprintf(file, "%s\n    { \"benchmark\": %s, \"name\": %s, \"sample_rate\": %.0f, "
+                               "\"block\": %zu, \"samples\": %zu, \"ns\": %.0f, "
+                               "\"ns_per_sample\": %.4f, \"samples_per_sec\": %.0f }",
+                         i ? "," : "", quoted(r.benchmark).c_str(), quoted(r.name).c_str(),
+                         r.sampleRate, r.block, r.samples, r.ns, nsPerSample, 1e9 / nsPerSample);
+        } else {
+            std::fprintf(file, "%s,%s,%s,%s,%.0f,%zu,%zu,%.0f,%.4f,%.0f\n", quoted(label).c_str(), simd,
+                         r.benchmark.c_str(), quoted(r.name).c_str(), r.sampleRate, r.block, r.samples,
+                         r.ns, nsPerSample, 1e9 / nsPerSample);
+        }
+    }
+    if (json)
+        std::fprintf(file, "\n  ]\n}\n");
+    bool ok = !std::ferror(file);
+    return std::fclose(file) == 0 && ok;
+}
+
+// Usage: voiceBench [--json FILE] [--csv FILE] [--label TEXT] [name ...]
+// (no names runs everything). Exits with 1 if any check failed.
+int main(int argc, char *argv[])
+{
+    std::string jsonPath, csvPath, label;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--json" || arg == "--csv" || arg == "--label") && i + 1 < argc) {
+            std::string& value = arg == "--json" ? jsonPath : arg == "--csv" ? csvPath : label;
+            value = argv[++i];
+        } else {
+            selected.push_back(arg);
+        }
+    }
+
+    bool ranAny = false;
+    int failures = 0;
+    for (const BenchmarkEntry& entry : benchmarks) {
+        bool chosen = selected.empty();
+        for (const std::string& name : selected) {
+            if (name == entry.name)
+                chosen = true;
+        }
+        if (!chosen)
+            continue;
+
+        std::printf("== %s ==\n", entry.name);
+        currentBenchmark() = entry.name;
+        failures += entry.run();
+        ranAny = true;
+    }
+
+    if (!ranAny) {
+        std::fprintf(stderr, "Unknown benchmark. Available:");
+        for (const BenchmarkEntry& entry : benchmarks)
+            std::fprintf(stderr, " %s", entry.name);
+        std::fprintf(stderr, "\n");
+        return 1;
+    }
+    bool ok = failures == 0;
+    if (!ok)
+        std::printf("== %d check(s) failed in total ==\n", failures);
+    if (!jsonPath.empty())
+        ok = writeRecords(jsonPath, true, label) && ok;
+    if (!csvPath.empty())
+        ok = writeRecords(csvPath, false, label) && ok;
+    return ok ? 0 : 1;
+}
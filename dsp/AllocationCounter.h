@@ -0,0 +1,169 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Per-thread heap allocation accounting, for checking that audio callbacks
+// stay allocation free. The counts only move in builds that define
+// VOICECHANGER_COUNT_ALLOCATIONS and include AllocationHooks.h in one
+// translation unit; otherwise they stay at zero and the probes below
+// compile away.
+struct AllocationThreadState {
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t violations; // Heap calls made while guarded
+    int guardDepth;      // > 0 inside a guarded callback
+};
+
+inline AllocationThreadState& allocationThreadState() {
+    static thread_local AllocationThreadState state = { 0, 0, 0, 0 };
+    return state;
+}
+
+inline uint64_t allocationCount() { return allocationThreadState().allocations; }
+
+// What the hooks do when a guarded callback touches the heap. Record only
+// counts, for the probe to report from outside the callback; Abort stops
+// at the offending call so a debugger or core dump shows who made it.
+// Debug builds default to Abort, others to Record; the
+// VOICECHANGER_ALLOCATION_GUARD environment variable ("abort" or
+// "record") overrides either.
+enum class AllocationGuardMode { Record, Abort };
+
+inline std::atomic<int>& allocationGuardModeStorage() {
+    static std::atomic<int> mode(-1);
+    return mode;
+}
+
+inline void setAllocationGuardMode(AllocationGuardMode mode) {
+    allocationGuardModeStorage().store(static_cast<int>(mode), std::memory_order_relaxed);
+}
+
+inline AllocationGuardMode allocationGuardMode() {
+    int mode = allocationGuardModeStorage().load(std::memory_order_relaxed);
+    if (mode < 0) {
+#ifdef NDEBUG
+        mode = static_cast<int>(AllocationGuardMode::Record);
+#else
+        mode = static_cast<int>(AllocationGuardMode::Abort);
+#endif
+        if (const char* env = std::getenv("VOICECHANGER_ALLOCATION_GUARD")) {
+            if (std::strcmp(env, "abort") == 0)
+                mode = static_cast<int>(AllocationGuardMode::Abort);
+            else if (std::strcmp(env, "record") == 0)
+                mode = static_cast<int>(AllocationGuardMode::Record);
+        }
+        allocationGuardModeStorage().store(mode, std::memory_order_relaxed);
+    }
+    return static_cast<AllocationGuardMode>(mode);
+}
+
+// Called from the hooks, i.e. from inside malloc/free: must not allocate
+inline void allocationGuardViolation(const char* call) {
+    ++allocationThreadState().violations;
+    if (allocationGuardMode() == AllocationGuardMode::Abort) {
+        std::fputs("Allocation guard: ", stderr);
+        std::fputs(call, stderr);
+        std::fputs(" called from a real-time audio callback\n", stderr);
+        std::abort();
+    }
+}
+
+inline void noteAllocation(const char* call) {
+    AllocationThreadState& state = allocationThreadState();
+    ++state.allocations;
+    if (state.guardDepth > 0)
+        allocationGuardViolation(call);
+}
+
+inline void noteDeallocation(const char* call) {
+    AllocationThreadState& state = allocationThreadState();
+    ++state.deallocations;
+    if (state.guardDepth > 0)
+        allocationGuardViolation(call);
+}
+
+// Steady-state heap check for one callback site.
+//
+// Each Scope (or ALLOCATION_SCOPE(probe)) arms the guard on the calling
+// thread until the end of the enclosing block, so any malloc, free, new
+// or delete in between is a violation. The first `warmupCalls` are not
+// guarded (lazy setup, first-touch growth). In Record mode the scope
+// only adds its violations to the probe's atomics as it ends, since it is
+// still on the audio thread; report() prints them from the non-real-time
+// side, e.g. once the stream has stopped.
+class AllocationProbe {
+public:
+    explicit AllocationProbe(const char* name, unsigned warmupCalls = 16)
+        : name(name), warmup(warmupCalls), calls(0), failures(0), heapCalls(0), worstCall(0) {}
+
+    class Scope {
+    public:
+        explicit Scope(AllocationProbe& probe)
+            : probe(probe), armed(probe.calls >= probe.warmup),
+              start(allocationThreadState().violations)
+        {
+            if (armed)
+                ++allocationThreadState().guardDepth;
+            else
+                ++probe.calls;
+        }
+
+        ~Scope() {
+            if (!armed)
+                return;
+            AllocationThreadState& state = allocationThreadState();
+            --state.guardDepth;
+            if (state.violations != start)
+                probe.fail(state.violations - start);
+        }
+
+    private:
+        AllocationProbe& probe;
+        bool armed;
+        uint64_t start;
+    };
+
+    // Steady-state calls that touched the heap; safe to read from any thread
+    uint64_t violations() const { return failures.load(std::memory_order_relaxed); }
+
+    // Prints the violations so far, if any. Does I/O: never call it from
+    // the guarded callback itself.
+    void report(FILE* out) const {
+        uint64_t count = violations();
+        if (count == 0)
+            return;
+        std::fprintf(out, "%s: %llu steady-state callbacks made %llu heap calls, at most %llu in one\n",
+                     name, static_cast<unsigned long long>(count),
+                     static_cast<unsigned long long>(heapCalls.load(std::memory_order_relaxed)),
+                     static_cast<unsigned long long>(worstCall.load(std::memory_order_relaxed)));
+    }
+
+private:
+    // On the audio thread, the counters' only writer: atomics only
+    void fail(uint64_t count) {
+        failures.fetch_add(1, std::memory_order_relaxed);
+        heapCalls.fetch_add(count, std::memory_order_relaxed);
+        if (count > worstCall.load(std::memory_order_relaxed))
+            worstCall.store(count, std::memory_order_relaxed);
+    }
+
+    const char* name;
+    unsigned warmup;
+    unsigned calls;
+    std::atomic<uint64_t> failures;
+    std::atomic<uint64_t> heapCalls;
+    std::atomic<uint64_t> worstCall;
+};
+
+#ifdef VOICECHANGER_COUNT_ALLOCATIONS
+#define ALLOCATION_SCOPE(probe) AllocationProbe::Scope allocationScope(probe)
+#else
+#define ALLOCATION_SCOPE(probe) ((void)0)
+#endif
+
+#endif // ALLOCATIONCOUNTER_H
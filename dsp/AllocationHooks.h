@@ -0,0 +1,102 @@
+#ifndef ALLOCATIONHOOKS_H
+#define ALLOCATIONHOOKS_H
+
+#include "AllocationCounter.h"
+
+// Heap hooks behind allocationCount() and the allocation guard. Include
+// from exactly one translation unit per executable; does nothing unless
+// VOICECHANGER_COUNT_ALLOCATIONS is defined.
+//
+// On glibc malloc and free themselves are interposed, which also covers
+// new/delete and heap use inside Qt and the C++ runtime. Elsewhere only
+// the global operator new and delete are replaced.
+#ifdef VOICECHANGER_COUNT_ALLOCATIONS
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void* __libc_malloc(size_t size) noexcept;
+void* __libc_calloc(size_t count, size_t size) noexcept;
+void* __libc_realloc(void* ptr, size_t size) noexcept;
+void* __libc_memalign(size_t alignment, size_t size) noexcept;
+void __libc_free(void* ptr) noexcept;
+
+void* malloc(size_t size) noexcept {
+    noteAllocation("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    noteAllocation("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    noteAllocation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    noteAllocation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+    noteAllocation("posix_memalign");
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    noteAllocation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+void free(void* ptr) noexcept {
+    if (ptr)
+        noteDeallocation("free");
+    __libc_free(ptr);
+}
+}
+
+#else
+
+void* operator new(size_t size) {
+    noteAllocation("operator new");
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr)
+        noteDeallocation("operator delete");
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+#endif
+
+#endif // VOICECHANGER_COUNT_ALLOCATIONS
+
+#endif // ALLOCATIONHOOKS_H
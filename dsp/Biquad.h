@@ -0,0 +1,545 @@
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+#include "DspMath.h"
+#include "DspStage.h"
+#include "Simd.h"
+
+// Second-order IIR sections (RBJ "Audio EQ Cookbook" designs) in
+// transposed direct form II, plus SIMD kernels that run several sections
+// side by side: either the sections of one cascade, pipelined so each lane
+// works one sample behind the previous one, or the channels of a bank of
+// independent filters.
+
+enum class BiquadType {
+    LowPass,
+    HighPass,
+    BandPass, // 0 dB peak gain
+    Notch,
+    AllPass,
+    Peaking,
+    LowShelf,
+    HighShelf
+};
+
+// Normalized coefficients (a0 == 1) of one section
+struct BiquadCoefficients {
+    float b0, b1, b2, a1, a2;
+
+    static BiquadCoefficients identity() { return BiquadCoefficients{ 1.0f, 0.0f, 0.0f, 0.0f, 0.0f }; }
+
+    // `gainDb` only matters for Peaking and the shelves; for the shelves
+    // `q` sets the slope, 0.707 giving the steepest one without overshoot.
+    static BiquadCoefficients design(BiquadType type, double frequency, double q,
+                                     double sampleRate, double gainDb = 0.0) {
+        double nyquist = sampleRate * 0.5;
+        frequency = frequency < 1.0 ? 1.0 : (frequency > nyquist * 0.999 ? nyquist * 0.999 : frequency);
+        q = q < 0.01 ? 0.01 : q;
+
+        double w0 = 2.0 * PI * frequency / sampleRate;
+        double cosw = std::cos(w0);
+        double alpha = std::sin(w0) / (2.0 * q);
+        double A = std::pow(10.0, gainDb / 40.0);
+        double b0, b1, b2, a0, a1, a2;
+
+        switch (type) {
+        case BiquadType::LowPass:
+            b0 = (1.0 - cosw) / 2.0; b1 = 1.0 - cosw; b2 = b0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::HighPass:
+            b0 = (1.0 + cosw) / 2.0; b1 = -(1.0 + cosw); b2 = b0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::BandPass:
+            b0 = alpha; b1 = 0.0; b2 = -alpha;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::Notch:
+            b0 = 1.0; b1 = -2.0 * cosw; b2 = 1.0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::AllPass:
+            b0 = 1.0 - alpha; b1 = -2.0 * cosw; b2 = 1.0 + alpha;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::Peaking:
+            b0 = 1.0 + alpha * A; b1 = -2.0 * cosw; b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A; a1 = -2.0 * cosw; a2 = 1.0 - alpha / A;
+            break;
+        case BiquadType::LowShelf: {
+            double k = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1.0) - (A - 1.0) * cosw + k);
+            b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+            b2 = A * ((A + 1.0) - (A - 1.0) * cosw - k);
+            a0 = (A + 1.0) + (A - 1.0) * cosw + k;
+            a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw);
+            a2 = (A + 1.0) + (A - 1.0) * cosw - k;
+            break;
+        }
+        case BiquadType::HighShelf:
+        default: {
+            double k = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1.0) + (A - 1.0) * cosw + k);
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+            b2 = A * ((A + 1.0) + (A - 1.0) * cosw - k);
+            a0 = (A + 1.0) - (A - 1.0) * cosw + k;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw);
+            a2 = (A + 1.0) - (A - 1.0) * cosw - k;
+            break;
+        }
+        }
+
+        return BiquadCoefficients{ static_cast<float>(b0 / a0), static_cast<float>(b1 / a0),
+                                   static_cast<float>(b2 / a0), static_cast<float>(a1 / a0),
+                                   static_cast<float>(a2 / a0) };
+    }
+
+    // Complex response at `frequency`, from the stored (float) coefficients
+    std::complex<double> response(double frequency, double sampleRate) const {
+        std::complex<double> z1 = std::polar(1.0, -2.0 * PI * frequency / sampleRate);
+        std::complex<double> z2 = z1 * z1;
+        return (static_cast<double>(b0) + static_cast<double>(b1) * z1 + static_cast<double>(b2) * z2)
+             / (1.0 + static_cast<double>(a1) * z1 + static_cast<double>(a2) * z2);
+    }
+
+    double magnitudeDb(double frequency, double sampleRate) const {
+        return 20.0 * std::log10(std::abs(response(frequency, sampleRate)) + 1e-30);
+    }
+};
+
+// Q of section `index` when `sections` second-order sections make up a
+// Butterworth low- or high-pass of order 2 * sections.
+inline double butterworthQ(size_t sections, size_t index) {
+    return 1.0 / (2.0 * std::sin(PI * (2.0 * index + 1.0) / (4.0 * sections)));
+}
+
+// One TDF-II section, for per-sample use
+class Biquad {
+public:
+    explicit Biquad(const BiquadCoefficients& coefficients = BiquadCoefficients::identity())
+        : c(coefficients), s1(0.0f), s2(0.0f) {}
+
+    void setCoefficients(const BiquadCoefficients& coefficients) { c = coefficients; }
+    const BiquadCoefficients& coefficients() const { return c; }
+
+    float processSample(float x) {
+        float y = c.b0 * x + s1;
+        s1 = c.b1 * x - c.a1 * y + s2;
+        s2 = c.b2 * x - c.a2 * y;
+        return y;
+    }
+
+    void reset() { s1 = s2 = 0.0f; }
+
+private:
+    BiquadCoefficients c;
+    float s1;
+    float s2;
+};
+
+// Coefficients and state of up to eight sections, one per SIMD lane
+struct alignas(32) BiquadLanes {
+    static const size_t Count = 8;
+
+    float b0[Count];
+    float b1[Count];
+    float b2[Count];
+    float a1[Count];
+    float a2[Count];
+    float s1[Count];
+    float s2[Count];
+
+    BiquadLanes() {
+        for (size_t i = 0; i < Count; ++i) {
+            set(i, BiquadCoefficients::identity());
+            s1[i] = s2[i] = 0.0f;
+        }
+    }
+
+    void set(size_t lane, const BiquadCoefficients& c) {
+        b0[lane] = c.b0;
+        b1[lane] = c.b1;
+        b2[lane] = c.b2;
+        a1[lane] = c.a1;
+        a2[lane] = c.a2;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < Count; ++i)
+            s1[i] = s2[i] = 0.0f;
+    }
+};
+
+// Cascade kernels: run lanes [first, first + width) in series over `n`
+// samples. Bank kernels: run those lanes as independent filters over
+// interleaved frames `stride` floats apart, lane l reading channel l. The
+// scalar kernels have width 1; the SIMD ones 4 or 8, null when missing.
+typedef void (*BiquadCascadeKernel)(BiquadLanes& lanes, size_t first, const float* in,
+                                    float* out, size_t n);
+typedef void (*BiquadBankKernel)(BiquadLanes& lanes, size_t first, size_t stride,
+                                 const float* in, float* out, size_t frames);
+
+struct BiquadKernels {
+    BiquadCascadeKernel cascade4;
+    BiquadCascadeKernel cascade8;
+    BiquadBankKernel bank4;
+    BiquadBankKernel bank8;
+    SimdLevel level;
+};
+
+inline void biquadCascadeScalar(BiquadLanes& lanes, size_t first, const float* in, float* out,
+                                size_t n) {
+    const float b0 = lanes.b0[first], b1 = lanes.b1[first], b2 = lanes.b2[first];
+    const float a1 = lanes.a1[first], a2 = lanes.a2[first];
+    float s1 = lanes.s1[first], s2 = lanes.s2[first];
+    for (size_t i = 0; i < n; ++i) {
+        float x = in[i];
+        float y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        out[i] = y;
+    }
+    lanes.s1[first] = s1;
+    lanes.s2[first] = s2;
+}
+
+inline void biquadBankScalar(BiquadLanes& lanes, size_t first, size_t stride, const float* in,
+                             float* out, size_t frames) {
+    const float b0 = lanes.b0[first], b1 = lanes.b1[first], b2 = lanes.b2[first];
+    const float a1 = lanes.a1[first], a2 = lanes.a2[first];
+    float s1 = lanes.s1[first], s2 = lanes.s2[first];
+    for (size_t i = 0; i < frames; ++i) {
+        float x = in[i * stride + first];
+        float y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        out[i * stride + first] = y;
+    }
+    lanes.s1[first] = s1;
+    lanes.s2[first] = s2;
+}
+
+// The pipelined cascade kernels take n + width - 1 steps: at step t lane l
+// works on sample t - l, fed by lane l - 1's output from step t - 1, and the
+// last lane's output is sample t - width + 1. Lanes whose sample is outside
+// the block (the first and last width - 1 steps) keep their state, so the
+// cascade adds no delay and blocks join seamlessly.
+inline void biquadPipelineMask(int32_t* mask, size_t width, size_t t, size_t n) {
+    for (size_t l = 0; l < width; ++l)
+        mask[l] = (l <= t && t - l < n) ? -1 : 0;
+}
+
+#if defined(DSP_HAVE_X86)
+DSP_TARGET("sse2")
+inline void biquadCascadeSse2(BiquadLanes& lanes, size_t first, const float* in, float* out,
+                              size_t n) {
+    const size_t Width = 4;
+    const __m128 b0 = _mm_load_ps(lanes.b0 + first), b1 = _mm_load_ps(lanes.b1 + first);
+    const __m128 b2 = _mm_load_ps(lanes.b2 + first), a1 = _mm_load_ps(lanes.a1 + first);
+    const __m128 a2 = _mm_load_ps(lanes.a2 + first);
+    __m128 s1 = _mm_load_ps(lanes.s1 + first), s2 = _mm_load_ps(lanes.s2 + first);
+    __m128 y = _mm_setzero_ps();
+    alignas(16) int32_t mask[Width];
+
+    for (size_t t = 0; t < n + Width - 1; ++t) {
+        __m128 x = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4));
+        x = _mm_move_ss(x, _mm_set_ss(t < n ? in[t] : 0.0f));
+        y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+        __m128 n1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), s2);
+        __m128 n2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        if (t + 1 < Width || t >= n) {
+            biquadPipelineMask(mask, Width, t, n);
+            __m128 m = _mm_load_ps(reinterpret_cast<const float*>(mask));
+            s1 = _mm_or_ps(_mm_and_ps(m, n1), _mm_andnot_ps(m, s1));
+            s2 = _mm_or_ps(_mm_and_ps(m, n2), _mm_andnot_ps(m, s2));
+        } else {
+            s1 = n1;
+            s2 = n2;
+        }
+        if (t + 1 >= Width)
+            out[t + 1 - Width] = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    _mm_store_ps(lanes.s1 + first, s1);
+    _mm_store_ps(lanes.s2 + first, s2);
+}
+
+DSP_TARGET("avx2,fma")
+inline void biquadCascadeAvx2(BiquadLanes& lanes, size_t first, const float* in, float* out,
+                              size_t n) {
+    const size_t Width = 8;
+    const __m256 b0 = _mm256_load_ps(lanes.b0 + first), b1 = _mm256_load_ps(lanes.b1 + first);
+    const __m256 b2 = _mm256_load_ps(lanes.b2 + first), a1 = _mm256_load_ps(lanes.a1 + first);
+    const __m256 a2 = _mm256_load_ps(lanes.a2 + first);
+    const __m256i shift = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    __m256 s1 = _mm256_load_ps(lanes.s1 + first), s2 = _mm256_load_ps(lanes.s2 + first);
+    __m256 y = _mm256_setzero_ps();
+    alignas(32) int32_t mask[Width];
+
+    for (size_t t = 0; t < n + Width - 1; ++t) {
+        __m256 x = _mm256_permutevar8x32_ps(y, shift);
+        x = _mm256_blend_ps(x, _mm256_set1_ps(t < n ? in[t] : 0.0f), 1);
+        y = _mm256_fmadd_ps(b0, x, s1);
+        __m256 n1 = _mm256_fnmadd_ps(a1, y, _mm256_fmadd_ps(b1, x, s2));
+        __m256 n2 = _mm256_fnmadd_ps(a2, y, _mm256_mul_ps(b2, x));
+        if (t + 1 < Width || t >= n) {
+            biquadPipelineMask(mask, Width, t, n);
+            __m256 m = _mm256_load_ps(reinterpret_cast<const float*>(mask));
+            s1 = _mm256_blendv_ps(s1, n1, m);
+            s2 = _mm256_blendv_ps(s2, n2, m);
+        } else {
+            s1 = n1;
+            s2 = n2;
+        }
+        if (t + 1 >= Width) {
+            __m128 high = _mm256_extractf128_ps(y, 1);
+            out[t + 1 - Width] = _mm_cvtss_f32(_mm_shuffle_ps(high, high, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+    }
+    _mm256_store_ps(lanes.s1 + first, s1);
+    _mm256_store_ps(lanes.s2 + first, s2);
+}
+
+DSP_TARGET("sse2")
+inline void biquadBankSse2(BiquadLanes& lanes, size_t first, size_t stride, const float* in,
+                           float* out, size_t frames) {
+    const __m128 b0 = _mm_load_ps(lanes.b0 + first), b1 = _mm_load_ps(lanes.b1 + first);
+    const __m128 b2 = _mm_load_ps(lanes.b2 + first), a1 = _mm_load_ps(lanes.a1 + first);
+    const __m128 a2 = _mm_load_ps(lanes.a2 + first);
+    __m128 s1 = _mm_load_ps(lanes.s1 + first), s2 = _mm_load_ps(lanes.s2 + first);
+    for (size_t i = 0; i < frames; ++i) {
+        __m128 x = _mm_loadu_ps(in + i * stride + first);
+        __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+        s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), s2);
+        s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_storeu_ps(out + i * stride + first, y);
+    }
+    _mm_store_ps(lanes.s1 + first, s1);
+    _mm_store_ps(lanes.s2 + first, s2);
+}
+
+DSP_TARGET("avx2,fma")
+inline void biquadBankAvx2(BiquadLanes& lanes, size_t first, size_t stride, const float* in,
+                           float* out, size_t frames) {
+    const __m256 b0 = _mm256_load_ps(lanes.b0 + first), b1 = _mm256_load_ps(lanes.b1 + first);
+    const __m256 b2 = _mm256_load_ps(lanes.b2 + first), a1 = _mm256_load_ps(lanes.a1 + first);
+    const __m256 a2 = _mm256_load_ps(lanes.a2 + first);
+    __m256 s1 = _mm256_load_ps(lanes.s1 + first), s2 = _mm256_load_ps(lanes.s2 + first);
+    for (size_t i = 0; i < frames; ++i) {
+        __m256 x = _mm256_loadu_ps(in + i * stride + first);
+        __m256 y = _mm256_fmadd_ps(b0, x, s1);
+        s1 = _mm256_fnmadd_ps(a1, y, _mm256_fmadd_ps(b1, x, s2));
+        s2 = _mm256_fnmadd_ps(a2, y, _mm256_mul_ps(b2, x));
+        _mm256_storeu_ps(out + i * stride + first, y);
+    }
+    _mm256_store_ps(lanes.s1 + first, s1);
+    _mm256_store_ps(lanes.s2 + first, s2);
+}
+#endif
+
+#if defined(DSP_HAVE_NEON)
+inline void biquadCascadeNeon(BiquadLanes& lanes, size_t first, const float* in, float* out,
+                              size_t n) {
+    const size_t Width = 4;
+    const float32x4_t b0 = vld1q_f32(lanes.b0 + first), b1 = vld1q_f32(lanes.b1 + first);
+    const float32x4_t b2 = vld1q_f32(lanes.b2 + first), a1 = vld1q_f32(lanes.a1 + first);
+    const float32x4_t a2 = vld1q_f32(lanes.a2 + first);
+    float32x4_t s1 = vld1q_f32(lanes.s1 + first), s2 = vld1q_f32(lanes.s2 + first);
+    float32x4_t y = vdupq_n_f32(0.0f);
+    int32_t mask[Width];
+
+    for (size_t t = 0; t < n + Width - 1; ++t) {
+        // {x, y0, y1, y2}
+        float32x4_t x = vextq_f32(vdupq_n_f32(t < n ? in[t] : 0.0f), y, 3);
+        y = vmlaq_f32(s1, b0, x);
+        float32x4_t n1 = vmlsq_f32(vmlaq_f32(s2, b1, x), a1, y);
+        float32x4_t n2 = vmlsq_f32(vmulq_f32(b2, x), a2, y);
+        if (t + 1 < Width || t >= n) {
+            biquadPipelineMask(mask, Width, t, n);
+            uint32x4_t m = vreinterpretq_u32_s32(vld1q_s32(mask));
+            s1 = vbslq_f32(m, n1, s1);
+            s2 = vbslq_f32(m, n2, s2);
+        } else {
+            s1 = n1;
+            s2 = n2;
+        }
+        if (t + 1 >= Width)
+            out[t + 1 - Width] = vgetq_lane_f32(y, 3);
+    }
+    vst1q_f32(lanes.s1 + first, s1);
+    vst1q_f32(lanes.s2 + first, s2);
+}
+
+inline void biquadBankNeon(BiquadLanes& lanes, size_t first, size_t stride, const float* in,
+                           float* out, size_t frames) {
+    const float32x4_t b0 = vld1q_f32(lanes.b0 + first), b1 = vld1q_f32(lanes.b1 + first);
+    const float32x4_t b2 = vld1q_f32(lanes.b2 + first), a1 = vld1q_f32(lanes.a1 + first);
+    const float32x4_t a2 = vld1q_f32(lanes.a2 + first);
+    float32x4_t s1 = vld1q_f32(lanes.s1 + first), s2 = vld1q_f32(lanes.s2 + first);
+    for (size_t i = 0; i < frames; ++i) {
+        float32x4_t x = vld1q_f32(in + i * stride + first);
+        float32x4_t y = vmlaq_f32(s1, b0, x);
+        s1 = vmlsq_f32(vmlaq_f32(s2, b1, x), a1, y);
+        s2 = vmlsq_f32(vmulq_f32(b2, x), a2, y);
+        vst1q_f32(out + i * stride + first, y);
+    }
+    vst1q_f32(lanes.s1 + first, s1);
+    vst1q_f32(lanes.s2 + first, s2);
+}
+#endif
+
+// Kernels for `level`; levels that are not compiled in fall back to scalar.
+inline BiquadKernels biquadKernels(SimdLevel level) {
+    switch (level) {
+#if defined(DSP_HAVE_X86)
+    case SimdLevel::Avx2:
+        return { biquadCascadeSse2, biquadCascadeAvx2, biquadBankSse2, biquadBankAvx2, level };
+    case SimdLevel::Sse2:
+        return { biquadCascadeSse2, nullptr, biquadBankSse2, nullptr, level };
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon:
+        return { biquadCascadeNeon, nullptr, biquadBankNeon, nullptr, level };
+#endif
+    default:
+        return { nullptr, nullptr, nullptr, nullptr, SimdLevel::Scalar };
+    }
+}
+
+inline const BiquadKernels& defaultBiquadKernels() {
+    static const BiquadKernels kernels = biquadKernels(detectSimdLevel());
+    return kernels;
+}
+
+// Up to eight sections in series.
+//
+// With a SIMD level the sections run pipelined in 4 or 8 lanes (unused
+// lanes are identity sections), so a cascade of four costs about as much
+// as a single section; a single section always takes the scalar path.
+// AVX2 uses FMA, so its output differs from scalar by rounding only.
+class BiquadCascade : public DspStage {
+public:
+    static const size_t MaxSections = BiquadLanes::Count;
+
+    explicit BiquadCascade(const BiquadKernels& kernels = defaultBiquadKernels())
+        : kernels(kernels), count(0) {}
+
+    // Sets section `index` (< MaxSections), growing the cascade to cover it
+    void setSection(size_t index, const BiquadCoefficients& c) {
+        lanes.set(index, c);
+        if (index >= count)
+            count = index + 1;
+    }
+
+    // Drops sections from `sections` on
+    void setSectionCount(size_t sections) {
+        for (size_t i = sections; i < MaxSections; ++i)
+            lanes.set(i, BiquadCoefficients::identity());
+        count = sections;
+    }
+
+    size_t sectionCount() const { return count; }
+    SimdLevel simdLevel() const { return kernels.level; }
+
+    // Cascade magnitude at `frequency`
+    double magnitudeDb(double frequency, double sampleRate) const {
+        double db = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            BiquadCoefficients c{ lanes.b0[i], lanes.b1[i], lanes.b2[i], lanes.a1[i], lanes.a2[i] };
+            db += c.magnitudeDb(frequency, sampleRate);
+        }
+        return db;
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        if (count == 0) {
+            if (in != out) {
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = in[i];
+            }
+            return;
+        }
+        if (count == 1 || !kernels.cascade4) {
+            biquadCascadeScalar(lanes, 0, in, out, n);
+            for (size_t i = 1; i < count; ++i)
+                biquadCascadeScalar(lanes, i, out, out, n);
+        } else if (count > 4 && kernels.cascade8) {
+            kernels.cascade8(lanes, 0, in, out, n);
+        } else {
+            kernels.cascade4(lanes, 0, in, out, n);
+            if (count > 4)
+                kernels.cascade4(lanes, 4, out, out, n);
+        }
+    }
+
+    void reset() override { lanes.clear(); }
+
+private:
+    BiquadKernels kernels;
+    BiquadLanes lanes;
+    size_t count;
+};
+
+// Up to eight independent channels, each with up to MaxSections sections,
+// over interleaved frames. Groups of 4 or 8 channels share one SIMD
+// register per section; channel counts that do not fill a group run the
+// remainder through the scalar kernel.
+class BiquadBank {
+public:
+    static const size_t MaxChannels = BiquadLanes::Count;
+    static const size_t MaxSections = 4;
+
+    explicit BiquadBank(size_t channels, const BiquadKernels& kernels = defaultBiquadKernels())
+        : kernels(kernels), channelCount(channels < MaxChannels ? channels : MaxChannels),
+          count(0) {}
+
+    void setSection(size_t channel, size_t section, const BiquadCoefficients& c) {
+        sections[section].set(channel, c);
+        if (section >= count)
+            count = section + 1;
+    }
+
+    size_t channels() const { return channelCount; }
+    SimdLevel simdLevel() const { return kernels.level; }
+
+    // `in` and `out` hold `frames` interleaved frames of channels() samples
+    void process(const float* in, float* out, size_t frames) {
+        const float* src = in;
+        for (size_t s = 0; s < count; ++s) {
+            size_t lane = 0;
+            if (kernels.bank8) {
+                for (; lane + 8 <= channelCount; lane += 8)
+                    kernels.bank8(sections[s], lane, channelCount, src, out, frames);
+            }
+            if (kernels.bank4) {
+                for (; lane + 4 <= channelCount; lane += 4)
+                    kernels.bank4(sections[s], lane, channelCount, src, out, frames);
+            }
+            for (; lane < channelCount; ++lane)
+                biquadBankScalar(sections[s], lane, channelCount, src, out, frames);
+            src = out;
+        }
+        if (count == 0 && in != out) {
+            for (size_t i = 0; i < frames * channelCount; ++i)
+                out[i] = in[i];
+        }
+    }
+
+    void reset() {
+        for (size_t s = 0; s < MaxSections; ++s)
+            sections[s].clear();
+    }
+
+private:
+    BiquadKernels kernels;
+    size_t channelCount;
+    size_t count;
+    BiquadLanes sections[MaxSections];
+};
+
+#endif // BIQUAD_H
@@ -0,0 +1,115 @@
+#ifndef BREATHGENERATOR_H
+#define BREATHGENERATOR_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Biquad.h"
+#include "DspMath.h"
+#include "DspStage.h"
+
+// Procedural respirator breathing mixed under the input.
+//
+// One white-noise source feeds two band-passes: a brighter, hissing one
+// for the inhale and a lower, rougher one for the exhale, each faded in and
+// out by a sin^2 window placed in a cycle of `period` seconds (inhale,
+// short hold, exhale, pause). Nothing is sampled from disk, so the loop
+// never repeats exactly. While the input is loud the breath ducks by up to
+// `duck` (0..1), as a speaker would not breathe mid-word. The envelopes
+// are evaluated once per block and ramped across it.
+class BreathGenerator : public DspStage {
+public:
+    BreathGenerator(double sampleRate, double level = 0.2, double period = 4.5, double duck = 0.8)
+        : rate(sampleRate),
+          inhale(BiquadCoefficients::design(BiquadType::BandPass, 2200.0, 1.1, sampleRate)),
+          exhale(BiquadCoefficients::design(BiquadType::BandPass, 800.0, 0.7, sampleRate))
+    {
+        setLevel(level);
+        setPeriod(period);
+        setDuck(duck);
+        reset();
+    }
+
+    void setLevel(double amount) { gain = static_cast<float>(amount < 0.0 ? 0.0 : amount); }
+
+    void setPeriod(double seconds) {
+        periodSamples = static_cast<size_t>((seconds < 1.0 ? 1.0 : seconds) * rate);
+    }
+
+    void setDuck(double amount) {
+        duck = static_cast<float>(amount < 0.0 ? 0.0 : amount > 1.0 ? 1.0 : amount);
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        if (n == 0)
+            return;
+
+        float peak = 0.0f;
+        for (size_t i = 0; i < n; ++i)
+            peak = std::fabs(in[i]) > peak ? std::fabs(in[i]) : peak;
+        follower = peak > follower
+            ? peak : follower * static_cast<float>(std::exp(-static_cast<double>(n) / (ReleaseSeconds * rate)));
+        float ducked = follower > DuckThreshold ? 1.0f : follower / DuckThreshold;
+        float level = gain * (1.0f - duck * ducked);
+
+        position = (position + n) % periodSamples;
+        double phase = static_cast<double>(position) / periodSamples;
+        float inhaleEnd = level * InhaleGain * window(phase, 0.0, 0.36);
+        float exhaleEnd = level * window(phase, 0.46, 0.44);
+        const float inhaleStep = (inhaleEnd - inhaleLevel) / static_cast<float>(n);
+        const float exhaleStep = (exhaleEnd - exhaleLevel) / static_cast<float>(n);
+
+        float a = inhaleLevel, b = exhaleLevel;
+        uint32_t s = seed;
+        for (size_t i = 0; i < n; ++i) {
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            float noise = static_cast<float>(static_cast<int32_t>(s)) * (1.0f / 2147483648.0f);
+            a += inhaleStep;
+            b += exhaleStep;
+            out[i] = in[i] + a * inhale.processSample(noise) + b * exhale.processSample(noise);
+        }
+        seed = s;
+        inhaleLevel = inhaleEnd;
+        exhaleLevel = exhaleEnd;
+    }
+
+    void reset() override {
+        inhale.reset();
+        exhale.reset();
+        seed = 0x2545F491u;
+        position = 0;
+        follower = 0.0f;
+        inhaleLevel = exhaleLevel = 0.0f;
+    }
+
+private:
+    static constexpr double ReleaseSeconds = 0.4;
+    static constexpr float DuckThreshold = 0.05f; // About -26 dBFS of speech
+    static constexpr float InhaleGain = 0.6f;
+
+    // sin^2 bump over [start, start + length) of the cycle, zero elsewhere
+    static float window(double phase, double start, double length) {
+        double x = (phase - start) / length;
+        if (x <= 0.0 || x >= 1.0)
+            return 0.0f;
+        double s = std::sin(PI * x);
+        return static_cast<float>(s * s);
+    }
+
+    double rate;
+    Biquad inhale;
+    Biquad exhale;
+    size_t periodSamples;
+    size_t position;
+    uint32_t seed;
+    float gain;
+    float duck;
+    float follower;
+    float inhaleLevel;
+    float exhaleLevel;
+};
+
+#endif // BREATHGENERATOR_H
@@ -0,0 +1,154 @@
+#ifndef CALLBACKSTATS_H
+#define CALLBACKSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "AllocationCounter.h"
+
+// Duration statistics for one audio callback site.
+//
+// record() runs on the audio thread and only does relaxed loads and stores
+// (there is one writer), so it never blocks; summary() may be called from
+// any thread. Durations go into a log-linear histogram with 16 buckets per
+// octave, so the p99 it reports is within ~6% of the true value.
+class CallbackStats {
+public:
+    struct Summary {
+        uint64_t count;
+        double minUs;
+        double avgUs;
+        double p99Us;
+        double maxUs;
+    };
+
+    CallbackStats() { reset(); }
+
+    void record(uint64_t ns) {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        if (n == 0 || ns < minNs.load(std::memory_order_relaxed))
+            minNs.store(ns, std::memory_order_relaxed);
+        if (ns > maxNs.load(std::memory_order_relaxed))
+            maxNs.store(ns, std::memory_order_relaxed);
+        totalNs.store(totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        std::atomic<uint32_t>& bucket = histogram[bucketIndex(ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        count.store(n + 1, std::memory_order_release);
+    }
+
+    Summary summary() const {
+        Summary s;
+        s.count = count.load(std::memory_order_acquire);
+        if (s.count == 0) {
+            s.minUs = s.avgUs = s.p99Us = s.maxUs = 0.0;
+            return s;
+        }
+        s.minUs = minNs.load(std::memory_order_relaxed) * 1e-3;
+        s.maxUs = maxNs.load(std::memory_order_relaxed) * 1e-3;
+        s.avgUs = totalNs.load(std::memory_order_relaxed) * 1e-3 / s.count;
+
+        // Walk the histogram to the bucket holding the 99th percentile
+        uint64_t rank = s.count - s.count / 100;
+        uint64_t seen = 0;
+        s.p99Us = s.maxUs;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            seen += histogram[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                s.p99Us = bucketMidpoint(i) * 1e-3;
+                break;
+            }
+        }
+        if (s.p99Us > s.maxUs)
+            s.p99Us = s.maxUs;
+        return s;
+    }
+
+    // Only valid while nothing is recording
+    void reset() {
+        count.store(0, std::memory_order_relaxed);
+        totalNs.store(0, std::memory_order_relaxed);
+        minNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < BucketCount; ++i)
+            histogram[i].store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static const int SubBucketBits = 4;
+    static const size_t SubBuckets = size_t(1) << SubBucketBits;
+    static const size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    // Values below 16 ns map one to one; above, each octave gets 16 buckets
+    static size_t bucketIndex(uint64_t ns) {
+        if (ns < SubBuckets)
+            return static_cast<size_t>(ns);
+        int octave = 63 - __builtin_clzll(ns);
+        size_t sub = static_cast<size_t>(ns >> (octave - SubBucketBits)) & (SubBuckets - 1);
+        return static_cast<size_t>(octave - SubBucketBits + 1) * SubBuckets + sub;
+    }
+
+    static double bucketMidpoint(size_t index) {
+        if (index < SubBuckets)
+            return static_cast<double>(index);
+        int octave = static_cast<int>(index / SubBuckets) + SubBucketBits - 1;
+        double width = static_cast<double>(uint64_t(1) << (octave - SubBucketBits));
+        double low = static_cast<double>(uint64_t(1) << octave) + (index % SubBuckets) * width;
+        return low + width / 2;
+    }
+
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> totalNs;
+    std::atomic<uint64_t> minNs;
+    std::atomic<uint64_t> maxNs;
+    std::atomic<uint32_t> histogram[BucketCount];
+};
+
+// Instrumentation for one callback site: duration statistics plus, in
+// builds with VOICECHANGER_COUNT_ALLOCATIONS, the heap guard. Put a
+// CallbackMonitor::Scope at the top of the callback.
+class CallbackMonitor {
+public:
+    explicit CallbackMonitor(const char* name) : allocations(name) {}
+
+    class Scope {
+    public:
+        explicit Scope(CallbackMonitor& monitor)
+            : monitor(monitor),
+#ifdef VOICECHANGER_COUNT_ALLOCATIONS
+              guard(monitor.allocations),
+#endif
+              start(std::chrono::steady_clock::now()) {}
+
+        ~Scope() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            monitor.timing.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+    private:
+        CallbackMonitor& monitor;
+#ifdef VOICECHANGER_COUNT_ALLOCATIONS
+        AllocationProbe::Scope guard;
+#endif
+        std::chrono::steady_clock::time_point start;
+    };
+
+    CallbackStats::Summary summary() const { return timing.summary(); }
+
+    // Steady-state callbacks that touched the heap (counting builds only)
+    uint64_t violations() const { return allocations.violations(); }
+
+    // Prints the heap violations, if any; not from inside the callback
+    void reportViolations(FILE* out) const { allocations.report(out); }
+
+    void reset() { timing.reset(); }
+
+private:
+    CallbackStats timing;
+    AllocationProbe allocations;
+};
+
+#endif // CALLBACKSTATS_H
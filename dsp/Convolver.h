@@ -0,0 +1,284 @@
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../WavFile.h"
+#include "DspMath.h"
+#include "DspStage.h"
+#include "Fft.h"
+#include "Simd.h"
+
+// y += x * h over `n` bins of split (re[], im[]) spectra; n is a multiple of 8
+typedef void (*ComplexMacKernel)(const float* xr, const float* xi, const float* hr,
+                                 const float* hi, float* yr, float* yi, size_t n);
+
+inline void complexMacScalar(const float* xr, const float* xi, const float* hr, const float* hi,
+                             float* yr, float* yi, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        yr[i] += xr[i] * hr[i] - xi[i] * hi[i];
+        yi[i] += xr[i] * hi[i] + xi[i] * hr[i];
+    }
+}
+
+#if defined(DSP_HAVE_X86)
+DSP_TARGET("sse2")
+inline void complexMacSse2(const float* xr, const float* xi, const float* hr, const float* hi,
+                           float* yr, float* yi, size_t n) {
+    for (size_t i = 0; i < n; i += 4) {
+        __m128 ar = _mm_loadu_ps(xr + i), ai = _mm_loadu_ps(xi + i);
+        __m128 br = _mm_loadu_ps(hr + i), bi = _mm_loadu_ps(hi + i);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+        __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+        _mm_storeu_ps(yr + i, _mm_add_ps(_mm_loadu_ps(yr + i), re));
+        _mm_storeu_ps(yi + i, _mm_add_ps(_mm_loadu_ps(yi + i), im));
+    }
+}
+
+DSP_TARGET("avx2,fma")
+inline void complexMacAvx2(const float* xr, const float* xi, const float* hr, const float* hi,
+                           float* yr, float* yi, size_t n) {
+    for (size_t i = 0; i < n; i += 8) {
+        __m256 ar = _mm256_loadu_ps(xr + i), ai = _mm256_loadu_ps(xi + i);
+        __m256 br = _mm256_loadu_ps(hr + i), bi = _mm256_loadu_ps(hi + i);
+        __m256 re = _mm256_fnmadd_ps(ai, bi, _mm256_fmadd_ps(ar, br, _mm256_loadu_ps(yr + i)));
+        __m256 im = _mm256_fmadd_ps(ai, br, _mm256_fmadd_ps(ar, bi, _mm256_loadu_ps(yi + i)));
+        _mm256_storeu_ps(yr + i, re);
+        _mm256_storeu_ps(yi + i, im);
+    }
+}
+#endif
+
+#if defined(DSP_HAVE_NEON)
+inline void complexMacNeon(const float* xr, const float* xi, const float* hr, const float* hi,
+                           float* yr, float* yi, size_t n) {
+    for (size_t i = 0; i < n; i += 4) {
+        float32x4_t ar = vld1q_f32(xr + i), ai = vld1q_f32(xi + i);
+        float32x4_t br = vld1q_f32(hr + i), bi = vld1q_f32(hi + i);
+        float32x4_t re = vmlsq_f32(vmlaq_f32(vld1q_f32(yr + i), ar, br), ai, bi);
+        float32x4_t im = vmlaq_f32(vmlaq_f32(vld1q_f32(yi + i), ar, bi), ai, br);
+        vst1q_f32(yr + i, re);
+        vst1q_f32(yi + i, im);
+    }
+}
+#endif
+
+// Kernel for `level`; levels that are not compiled in fall back to scalar.
+inline ComplexMacKernel complexMacKernel(SimdLevel level) {
+    switch (level) {
+#if defined(DSP_HAVE_X86)
+    case SimdLevel::Avx2: return complexMacAvx2;
+    case SimdLevel::Sse2: return complexMacSse2;
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon: return complexMacNeon;
+#endif
+    default: return complexMacScalar;
+    }
+}
+
+// Reads a WAV impulse response as mono float at `sampleRate`, resampling
+// linearly if the file's rate differs, truncated to `maxSeconds`.
+inline bool loadImpulseResponse(const std::string& path, double sampleRate, std::vector<float>* ir,
+                                std::string* error, double maxSeconds = 10.0) {
+    WavReader reader;
+    if (!reader.open(path)) {
+        *error = reader.errorString();
+        return false;
+    }
+    std::vector<float> raw(static_cast<size_t>(std::min<uint64_t>(
+        reader.frameCount(), static_cast<uint64_t>(maxSeconds * reader.sampleRate()))));
+    raw.resize(reader.readMono(raw.data(), raw.size()));
+    if (raw.empty()) {
+        *error = path + " has no samples";
+        return false;
+    }
+
+    double step = static_cast<double>(reader.sampleRate()) / sampleRate;
+    if (std::fabs(step - 1.0) < 1e-9) {
+        ir->swap(raw);
+        return true;
+    }
+    // Linear interpolation; when shrinking, scale so the IR keeps its gain
+    size_t length = static_cast<size_t>((raw.size() - 1) / step) + 1;
+    ir->assign(length, 0.0f);
+    float scale = static_cast<float>(step > 1.0 ? step : 1.0);
+    for (size_t i = 0; i < length; ++i) {
+        double position = i * step;
+        size_t index = static_cast<size_t>(position);
+        float frac = static_cast<float>(position - index);
+        float next = index + 1 < raw.size() ? raw[index + 1] : 0.0f;
+        (*ir)[i] = scale * (raw[index] + frac * (next - raw[index]));
+    }
+    return true;
+}
+
+// Convolution with a long impulse response (rooms, cabinets, helmets).
+//
+// The IR is split into partitions of `partition` samples whose spectra are
+// computed once up front. Input is gathered into partition-sized blocks;
+// each finished block is transformed once, pushed into a frequency-domain
+// delay line, multiplied against every partition spectrum and accumulated
+// (uniformly partitioned overlap-save), so the work per sample grows with
+// the IR length only through the spectral multiply-adds, which run through
+// the SIMD kernel. That path delays the output by one partition. With
+// `zeroLatency` the first partition is instead applied as a direct-form
+// FIR and the FFT path handles the rest of the IR, whose one-partition
+// delay then lines up exactly: no added latency for one partition's worth
+// of multiply-adds per sample. Process calls of any size are fine.
+// Partitions are rounded up to a power of two from 16 to MaxPartition.
+class Convolver : public DspStage {
+public:
+    static const size_t MaxPartition = 8192;
+
+    Convolver(const std::vector<float>& impulseResponse, size_t partition = 128,
+              bool zeroLatency = true, double mix = 1.0,
+              ComplexMacKernel kernel = complexMacKernel(detectSimdLevel()))
+        : blockSize(nextPowerOfTwo(partition < 16 ? 16
+                                   : partition > MaxPartition ? MaxPartition : partition)),
+          direct(zeroLatency), mac(kernel), fft(2 * blockSize),
+          bins(blockSize + 1), stride((blockSize + 1 + 7) / 8 * 8),
+          time(2 * blockSize, 0.0f), tail(blockSize, 0.0f), frame(2 * blockSize),
+          spectrum(bins), sumRe(stride), sumIm(stride)
+    {
+        setMix(mix);
+
+        const size_t start = direct ? std::min(blockSize, impulseResponse.size()) : 0;
+        if (direct) {
+            // Reversed, so the FIR is a forward dot product over the history
+            head.assign(blockSize, 0.0f);
+            for (size_t k = 0; k < start; ++k)
+                head[blockSize - 1 - k] = impulseResponse[k];
+        }
+
+        partitions = (impulseResponse.size() - start + blockSize - 1) / blockSize;
+        filterRe.assign(partitions * stride, 0.0f);
+        filterIm.assign(partitions * stride, 0.0f);
+        for (size_t p = 0; p < partitions; ++p) {
+            std::fill(frame.begin(), frame.end(), 0.0f);
+            size_t offset = start + p * blockSize;
+            size_t count = std::min(blockSize, impulseResponse.size() - offset);
+            std::copy(impulseResponse.begin() + offset, impulseResponse.begin() + offset + count,
+                      frame.begin());
+            fft.forward(frame.data(), spectrum.data());
+            for (size_t k = 0; k < bins; ++k) {
+                filterRe[p * stride + k] = spectrum[k].re;
+                filterIm[p * stride + k] = spectrum[k].im;
+            }
+        }
+        historyRe.assign(partitions * stride, 0.0f);
+        historyIm.assign(partitions * stride, 0.0f);
+        reset();
+    }
+
+    void setMix(double amount) {
+        wet = static_cast<float>(amount < 0.0 ? 0.0 : amount > 1.0 ? 1.0 : amount);
+    }
+
+    size_t partitionSize() const { return blockSize; }
+    size_t partitionCount() const { return partitions; }
+
+    void process(const float* in, float* out, size_t n) override {
+        const float w = wet, dry = 1.0f - wet;
+        size_t done = 0;
+        while (done < n) {
+            size_t count = std::min(n - done, blockSize - fill);
+            float* current = time.data() + blockSize + fill;
+            std::copy(in + done, in + done + count, current);
+            for (size_t i = 0; i < count; ++i) {
+                float y = tail[fill + i];
+                if (direct)
+                    y += dot(head.data(), current + i + 1 - blockSize, blockSize);
+                out[done + i] = dry * current[i] + w * y;
+            }
+            fill += count;
+            done += count;
+            if (fill == blockSize) {
+                runPartitions();
+                fill = 0;
+            }
+        }
+    }
+
+    void reset() override {
+        std::fill(time.begin(), time.end(), 0.0f);
+        std::fill(tail.begin(), tail.end(), 0.0f);
+        std::fill(historyRe.begin(), historyRe.end(), 0.0f);
+        std::fill(historyIm.begin(), historyIm.end(), 0.0f);
+        fill = 0;
+        newest = 0;
+    }
+
+    size_t latency() const override { return direct ? 0 : blockSize; }
+
+private:
+    // Four accumulators keep the adds independent without reassociation
+    static float dot(const float* a, const float* b, size_t n) {
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        for (size_t i = 0; i < n; i += 4) {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // One finished input block: transform [previous | current], push it into
+    // the delay line, accumulate against every partition and keep the valid
+    // second half of the inverse as the output for the next block
+    void runPartitions() {
+        if (partitions > 0) {
+            newest = newest == 0 ? partitions - 1 : newest - 1;
+            fft.forward(time.data(), spectrum.data());
+            float* xr = historyRe.data() + newest * stride;
+            float* xi = historyIm.data() + newest * stride;
+            for (size_t k = 0; k < bins; ++k) {
+                xr[k] = spectrum[k].re;
+                xi[k] = spectrum[k].im;
+            }
+
+            std::fill(sumRe.begin(), sumRe.end(), 0.0f);
+            std::fill(sumIm.begin(), sumIm.end(), 0.0f);
+            for (size_t p = 0; p < partitions; ++p) {
+                size_t slot = newest + p < partitions ? newest + p : newest + p - partitions;
+                mac(historyRe.data() + slot * stride, historyIm.data() + slot * stride,
+                    filterRe.data() + p * stride, filterIm.data() + p * stride,
+                    sumRe.data(), sumIm.data(), stride);
+            }
+            for (size_t k = 0; k < bins; ++k)
+                spectrum[k] = { sumRe[k], sumIm[k] };
+            fft.inverse(spectrum.data(), frame.data());
+            std::copy(frame.begin() + blockSize, frame.end(), tail.begin());
+        }
+        std::copy(time.begin() + blockSize, time.end(), time.begin());
+    }
+
+    size_t blockSize;
+    bool direct;
+    ComplexMacKernel mac;
+    RealFft fft;
+    size_t bins;
+    size_t stride; // Bins rounded up for the kernel
+    size_t partitions;
+    std::vector<float> head;
+    std::vector<float> filterRe; // Partition spectra, `stride` apart
+    std::vector<float> filterIm;
+    std::vector<float> historyRe; // Input spectra, newest at `newest`, older after it
+    std::vector<float> historyIm;
+    std::vector<float> time;      // Previous block | block being gathered
+    std::vector<float> tail;      // FFT-path output for the block being gathered
+    std::vector<float> frame;
+    std::vector<Complex> spectrum;
+    std::vector<float> sumRe;
+    std::vector<float> sumIm;
+    size_t fill;
+    size_t newest;
+    float wet;
+};
+
+#endif // CONVOLVER_H
@@ -0,0 +1,128 @@
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include <cstddef>
+
+#include "Simd.h"
+
+// Cross-correlation kernels used by the WSOLA overlap search.
+//
+// Each variant computes, in one pass over x, the dot product with ref and
+// the energy of x, which is all the search needs for a normalized score.
+typedef void (*DotEnergyKernel)(const float* ref, const float* x, size_t n,
+                                float* dot, float* energy);
+
+inline void dotEnergyScalar(const float* ref, const float* x, size_t n,
+                            float* dot, float* energy) {
+    float d0 = 0.0f, d1 = 0.0f, e0 = 0.0f, e1 = 0.0f;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        d0 += ref[i] * x[i];
+        d1 += ref[i + 1] * x[i + 1];
+        e0 += x[i] * x[i];
+        e1 += x[i + 1] * x[i + 1];
+    }
+    for (; i < n; ++i) {
+        d0 += ref[i] * x[i];
+        e0 += x[i] * x[i];
+    }
+    *dot = d0 + d1;
+    *energy = e0 + e1;
+}
+
+#if defined(DSP_HAVE_X86)
+DSP_TARGET("sse2")
+inline void dotEnergySse2(const float* ref, const float* x, size_t n,
+                          float* dot, float* energy) {
+    __m128 d = _mm_setzero_ps(), e = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 xv = _mm_loadu_ps(x + i);
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(ref + i), xv));
+        e = _mm_add_ps(e, _mm_mul_ps(xv, xv));
+    }
+    float dl[4], el[4];
+    _mm_storeu_ps(dl, d);
+    _mm_storeu_ps(el, e);
+    float dsum = (dl[0] + dl[1]) + (dl[2] + dl[3]);
+    float esum = (el[0] + el[1]) + (el[2] + el[3]);
+    for (; i < n; ++i) {
+        dsum += ref[i] * x[i];
+        esum += x[i] * x[i];
+    }
+    *dot = dsum;
+    *energy = esum;
+}
+
+DSP_TARGET("avx2,fma")
+inline void dotEnergyAvx2(const float* ref, const float* x, size_t n,
+                          float* dot, float* energy) {
+    __m256 d0 = _mm256_setzero_ps(), d1 = _mm256_setzero_ps();
+    __m256 e0 = _mm256_setzero_ps(), e1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 xa = _mm256_loadu_ps(x + i);
+        __m256 xb = _mm256_loadu_ps(x + i + 8);
+        d0 = _mm256_fmadd_ps(_mm256_loadu_ps(ref + i), xa, d0);
+        d1 = _mm256_fmadd_ps(_mm256_loadu_ps(ref + i + 8), xb, d1);
+        e0 = _mm256_fmadd_ps(xa, xa, e0);
+        e1 = _mm256_fmadd_ps(xb, xb, e1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 xa = _mm256_loadu_ps(x + i);
+        d0 = _mm256_fmadd_ps(_mm256_loadu_ps(ref + i), xa, d0);
+        e0 = _mm256_fmadd_ps(xa, xa, e0);
+    }
+    float dl[8], el[8];
+    _mm256_storeu_ps(dl, _mm256_add_ps(d0, d1));
+    _mm256_storeu_ps(el, _mm256_add_ps(e0, e1));
+    float dsum = ((dl[0] + dl[1]) + (dl[2] + dl[3])) + ((dl[4] + dl[5]) + (dl[6] + dl[7]));
+    float esum = ((el[0] + el[1]) + (el[2] + el[3])) + ((el[4] + el[5]) + (el[6] + el[7]));
+    for (; i < n; ++i) {
+        dsum += ref[i] * x[i];
+        esum += x[i] * x[i];
+    }
+    *dot = dsum;
+    *energy = esum;
+}
+#endif
+
+#if defined(DSP_HAVE_NEON)
+inline void dotEnergyNeon(const float* ref, const float* x, size_t n,
+                          float* dot, float* energy) {
+    float32x4_t d = vdupq_n_f32(0.0f), e = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t xv = vld1q_f32(x + i);
+        d = vmlaq_f32(d, vld1q_f32(ref + i), xv);
+        e = vmlaq_f32(e, xv, xv);
+    }
+    float dl[4], el[4];
+    vst1q_f32(dl, d);
+    vst1q_f32(el, e);
+    float dsum = (dl[0] + dl[1]) + (dl[2] + dl[3]);
+    float esum = (el[0] + el[1]) + (el[2] + el[3]);
+    for (; i < n; ++i) {
+        dsum += ref[i] * x[i];
+        esum += x[i] * x[i];
+    }
+    *dot = dsum;
+    *energy = esum;
+}
+#endif
+
+// Kernel for the requested level, falling back to scalar if it is not built in.
+inline DotEnergyKernel dotEnergyKernel(SimdLevel level) {
+    switch (level) {
+#if defined(DSP_HAVE_X86)
+    case SimdLevel::Avx2: return dotEnergyAvx2;
+    case SimdLevel::Sse2: return dotEnergySse2;
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon: return dotEnergyNeon;
+#endif
+    default: return dotEnergyScalar;
+    }
+}
+
+#endif // CORRELATION_H
@@ -0,0 +1,57 @@
+#ifndef DELAYLINE_H
+#define DELAYLINE_H
+
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "DspMath.h"
+
+// Preallocated circular delay line.
+//
+// write() and read() are constant time: the history lives in a
+// power-of-two buffer and the write position is masked instead of
+// shifting samples. read(0) returns the most recently written sample,
+// read(d) the one written d samples earlier. readFractional() linearly
+// interpolates between neighbouring taps for non-integer delays.
+template <typename Sample>
+class DelayLine {
+public:
+    explicit DelayLine(size_t maxDelaySamples)
+        : buffer(nextPowerOfTwo(maxDelaySamples + 2), Sample(0)),
+          mask(buffer.size() - 1), writePos(0), limit(maxDelaySamples) {}
+
+    size_t maxDelay() const { return limit; }
+
+    void write(Sample input) {
+        writePos = (writePos + 1) & mask;
+        buffer[writePos] = input;
+    }
+
+    Sample read(size_t delay) const {
+        return buffer[(writePos - delay) & mask];
+    }
+
+    Sample readFractional(double delay) const {
+        double whole = std::floor(delay);
+        size_t index = static_cast<size_t>(whole);
+        Sample frac = static_cast<Sample>(delay - whole);
+        Sample a = read(index);
+        Sample b = read(index + 1);
+        return a + frac * (b - a);
+    }
+
+    void clear() {
+        std::fill(buffer.begin(), buffer.end(), Sample(0));
+        writePos = 0;
+    }
+
+private:
+    std::vector<Sample> buffer;
+    size_t mask;
+    size_t writePos;
+    size_t limit;
+};
+
+#endif // DELAYLINE_H
@@ -0,0 +1,49 @@
+#ifndef DISTORTION_H
+#define DISTORTION_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "DspStage.h"
+
+// Memoryless tanh-style soft clipper.
+//
+// The input is driven by `driveDb` into a rational tanh approximation
+// (exact at 0 and at the +-3 clip point, within 2% in between, and cheap
+// enough to vectorize), then scaled so a full-scale input still peaks at
+// full scale. `mix` blends the clipped signal with the dry one.
+class Distortion : public DspStage {
+public:
+    explicit Distortion(double driveDb = 12.0, double mix = 1.0) {
+        setDrive(driveDb);
+        setMix(mix);
+    }
+
+    void setDrive(double driveDb) {
+        drive = static_cast<float>(std::pow(10.0, driveDb / 20.0));
+        makeup = 1.0f / shape(drive);
+    }
+
+    void setMix(double amount) {
+        mix = static_cast<float>(amount < 0.0 ? 0.0 : amount > 1.0 ? 1.0 : amount);
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        const float d = drive, m = mix * makeup, dry = 1.0f - mix;
+        for (size_t i = 0; i < n; ++i)
+            out[i] = m * shape(in[i] * d) + dry * in[i];
+    }
+
+private:
+    static float shape(float x) {
+        x = x < -3.0f ? -3.0f : x > 3.0f ? 3.0f : x;
+        float x2 = x * x;
+        return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+    }
+
+    float drive;
+    float makeup;
+    float mix;
+};
+
+#endif // DISTORTION_H
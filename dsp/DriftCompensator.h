@@ -0,0 +1,75 @@
+#ifndef DRIFTCOMPENSATOR_H
+#define DRIFTCOMPENSATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "DriftResampler.h"
+#include "JitterBuffer.h"
+#include "SampleConvert.h"
+
+// Playback side of a jitter buffer whose producer runs on another clock.
+//
+// Before each chunk the fill level is fed to a DriftController, and the
+// DriftResampler consumes slightly more or fewer frames than it produces
+// so the fill settles on the buffer's target instead of creeping into
+// trims or underruns. The controller holds while the buffer primes. Runs
+// entirely in preallocated storage; correctionPpm() may be read from any
+// thread.
+class DriftCompensator {
+public:
+    static const size_t Chunk = 256; // Output frames per controller update
+
+    DriftCompensator(JitterBuffer<int16_t>* buffer, double sampleRate,
+                     SampleConverter converter = defaultSampleConverter())
+        : buffer(buffer), controller(sampleRate), converter(converter), correction(0.0f) {}
+
+    // Fills `frames` of playback audio as float
+    void render(float* out, size_t frames) {
+        for (size_t offset = 0; offset < frames; offset += Chunk) {
+            size_t n = std::min(Chunk, frames - offset);
+
+            if (buffer->isPriming()) {
+                controller.reset();
+            } else {
+                resampler.setRatio(controller.update(static_cast<double>(buffer->fillFrames()),
+                                                     static_cast<double>(buffer->targetFrames()), n));
+            }
+
+            size_t need = resampler.inputNeeded(n);
+            buffer->pull(raw, need);
+            converter.toFloat(raw, input, need);
+            resampler.process(input, out + offset, n);
+        }
+        correction.store(static_cast<float>(controller.correctionPpm()), std::memory_order_relaxed);
+    }
+
+    // Retunes the controller; call while neither side runs
+    void setSampleRate(double sampleRate) { controller.setSampleRate(sampleRate); }
+
+    // Current rate correction; positive means playback consumes faster
+    float correctionPpm() const { return correction.load(std::memory_order_relaxed); }
+
+    void reset() {
+        resampler.reset();
+        controller.reset();
+        correction.store(0.0f, std::memory_order_relaxed);
+    }
+
+private:
+    // The controller clamps the ratio to +-1000 ppm, so a chunk never
+    // needs more than Chunk + 1 input frames; leave generous headroom.
+    static const size_t MaxInput = Chunk * 2;
+
+    JitterBuffer<int16_t>* buffer;
+    DriftResampler resampler;
+    DriftController controller;
+    SampleConverter converter;
+    std::atomic<float> correction;
+    int16_t raw[MaxInput];
+    float input[MaxInput];
+};
+
+#endif // DRIFTCOMPENSATOR_H
@@ -0,0 +1,138 @@
+#ifndef DRIFTRESAMPLER_H
+#define DRIFTRESAMPLER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Asynchronous resampler for clock drift between two devices nominally at
+// the same rate.
+//
+// The ratio (input frames consumed per output frame) stays within a few
+// hundred ppm of 1, so 4-point Hermite interpolation is plenty: the images
+// it leaves sit far above the audio band at such small ratio offsets. The
+// read position is a 32.32 fixed-point phase, so inputNeeded() tells the
+// caller exactly how many frames process() will consume and nothing is
+// ever held back or handed back to the source.
+class DriftResampler {
+public:
+    DriftResampler() : step(One), phase(0) {
+        std::fill(history, history + 4, 0.0f);
+    }
+
+    void setRatio(double ratio) {
+        step = static_cast<uint64_t>(ratio * static_cast<double>(One) + 0.5);
+    }
+
+    double ratio() const { return static_cast<double>(step) / static_cast<double>(One); }
+
+    // Input frames process() will consume to produce `outFrames`
+    size_t inputNeeded(size_t outFrames) const {
+        return static_cast<size_t>((phase + outFrames * step) >> FractionBits);
+    }
+
+    // Produces `outFrames` from exactly inputNeeded(outFrames) input frames.
+    // Two frames of lookahead live in the history, so the output trails the
+    // input by two frames.
+    void process(const float* in, float* out, size_t outFrames) {
+        float xm1 = history[0], x0 = history[1], x1 = history[2], x2 = history[3];
+        uint64_t p = phase;
+        for (size_t i = 0; i < outFrames; ++i) {
+            float t = static_cast<float>(p & FractionMask) * (1.0f / static_cast<float>(One));
+            float c1 = 0.5f * (x1 - xm1);
+            float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+            float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+            out[i] = ((c3 * t + c2) * t + c1) * t + x0;
+
+            p += step;
+            for (; p >= One; p -= One) {
+                xm1 = x0;
+                x0 = x1;
+                x1 = x2;
+                x2 = *in++;
+            }
+        }
+        phase = p;
+        history[0] = xm1;
+        history[1] = x0;
+        history[2] = x1;
+        history[3] = x2;
+    }
+
+    void reset() {
+        std::fill(history, history + 4, 0.0f);
+        phase = 0;
+    }
+
+private:
+    static const int FractionBits = 32;
+    static const uint64_t One = uint64_t(1) << FractionBits;
+    static const uint64_t FractionMask = One - 1;
+
+    uint64_t step;
+    uint64_t phase;
+    float history[4]; // x[-1], x[0], x[1], x[2]
+};
+
+// PI controller that turns a buffer fill level into a resampling ratio.
+//
+// The plant is an integrator: the fill error grows at (drift - correction)
+// * sampleRate frames per second. Gains are chosen for a critically damped
+// loop with the given time constant, and the measured fill is low-passed
+// first because callbacks make it a sawtooth one device buffer deep. The
+// correction is clamped to +-maxPpm, which also bounds the integrator.
+class DriftController {
+public:
+    DriftController(double sampleRate, double timeConstantSeconds = 8.0, double maxPpm = 1000.0)
+        : limit(maxPpm * 1e-6), timeConstant(timeConstantSeconds),
+          smoothingSeconds(timeConstantSeconds / 8.0),
+          smoothed(0.0), integral(0.0), correction(0.0), primed(false)
+    {
+        setSampleRate(sampleRate);
+    }
+
+    void setSampleRate(double sampleRate) {
+        rate = sampleRate;
+        kp = 1.0 / (sampleRate * timeConstant);
+        ki = sampleRate * kp * kp / 4.0;
+    }
+
+    // Feeds the fill level seen before consuming `frames`; returns the ratio
+    double update(double fillFrames, double targetFrames, size_t frames) {
+        double dt = frames / rate;
+        if (!primed) {
+            smoothed = fillFrames;
+            primed = true;
+        } else {
+            smoothed += (fillFrames - smoothed) * (dt / (dt + smoothingSeconds));
+        }
+
+        double error = smoothed - targetFrames;
+        integral = std::max(-limit, std::min(limit, integral + ki * error * dt));
+        correction = std::max(-limit, std::min(limit, kp * error + integral));
+        return 1.0 + correction;
+    }
+
+    // Forgets the fill history, e.g. while the buffer re-primes
+    void reset() {
+        integral = 0.0;
+        correction = 0.0;
+        primed = false;
+    }
+
+    double correctionPpm() const { return correction * 1e6; }
+
+private:
+    double rate;
+    double limit;
+    double timeConstant;
+    double kp;
+    double ki;
+    double smoothingSeconds;
+    double smoothed;
+    double integral;
+    double correction;
+    bool primed;
+};
+
+#endif // DRIFTRESAMPLER_H
@@ -0,0 +1,16 @@
+#ifndef DSPMATH_H
+#define DSPMATH_H
+
+#include <cstddef>
+
+const double PI = 3.14159265358979323846;
+
+// Smallest power of two that is >= n (n == 0 yields 1).
+inline size_t nextPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+#endif // DSPMATH_H
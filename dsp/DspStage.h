@@ -0,0 +1,25 @@
+#ifndef DSPSTAGE_H
+#define DSPSTAGE_H
+
+#include <cstddef>
+
+// Common block interface for the stages of the processing chain.
+//
+// process() handles a whole callback buffer at a time so each stage can
+// keep its state in registers across the block and the compiler can
+// vectorize what is not a recurrence. `in` and `out` may be the same
+// buffer; implementations must not allocate.
+class DspStage {
+public:
+    virtual ~DspStage() {}
+
+    virtual void process(const float* in, float* out, size_t n) = 0;
+
+    // Clears all internal history
+    virtual void reset() {}
+
+    // Algorithmic delay in samples
+    virtual size_t latency() const { return 0; }
+};
+
+#endif // DSPSTAGE_H
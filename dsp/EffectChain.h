@@ -0,0 +1,523 @@
+#ifndef EFFECTCHAIN_H
+#define EFFECTCHAIN_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BreathGenerator.h"
+#include "Convolver.h"
+#include "Distortion.h"
+#include "DspStage.h"
+#include "FilterStage.h"
+#include "Gain.h"
+#include "HelmetResonator.h"
+#include "LowPassFilter.h"
+#include "PitchStage.h"
+#include "Reverb.h"
+#include "RingModulator.h"
+#include "StateVariableFilter.h"
+
+// Chain used when no other is configured: the original voice changer
+const char* const DEFAULT_CHAIN_SPEC = "pitch factor=0.8; lowpass cutoff=3400";
+
+// Named chain descriptions for complete characters
+struct ChainPreset {
+    const char* name;
+    const char* description;
+    const char* spec;
+};
+
+const ChainPreset CHAIN_PRESETS[] = {
+    { "vader", "Darth Vader: deep, metallic, inside a helmet, with respirator breathing",
+      "pitch factor=0.78; ringmod freq=30 mix=0.2; helmet size=1 feedback=0.55 damping=0.4 mix=0.35; "
+      "distortion drive=6 mix=0.3; filter type=highpass cutoff=90; lowpass cutoff=3600; "
+      "breath level=0.12 period=4.5 duck=0.85" },
+    { "vader-voice", "The vader preset without the breathing",
+      "pitch factor=0.78; ringmod freq=30 mix=0.2; helmet size=1 feedback=0.55 damping=0.4 mix=0.35; "
+      "distortion drive=6 mix=0.3; filter type=highpass cutoff=90; lowpass cutoff=3600" },
+};
+
+inline const ChainPreset* findChainPreset(const std::string& name) {
+    for (const ChainPreset& preset : CHAIN_PRESETS) {
+        if (name == preset.name)
+            return &preset;
+    }
+    return nullptr;
+}
+
+// One stage of a chain description: a registered type plus key=value settings
+struct StageConfig {
+    std::string type;
+    std::vector<std::pair<std::string, std::string>> settings;
+
+    const std::string* find(const std::string& key) const {
+        for (const auto& setting : settings) {
+            if (setting.first == key)
+                return &setting.second;
+        }
+        return nullptr;
+    }
+
+    std::string text(const std::string& key, const std::string& fallback) const {
+        const std::string* value = find(key);
+        return value ? *value : fallback;
+    }
+
+    // build() has already rejected values that do not parse, so the
+    // fallback here only stands in for a missing key
+    double number(const std::string& key, double fallback) const {
+        const std::string* value = find(key);
+        double parsed;
+        return value && parseNumber(*value, &parsed) ? parsed : fallback;
+    }
+
+    // True if all of `text` is one finite number
+    static bool parseNumber(const std::string& text, double* value) {
+        char* end = nullptr;
+        double parsed = std::strtod(text.c_str(), &end);
+        if (end == text.c_str() || *end != '\0' || !std::isfinite(parsed))
+            return false;
+        *value = parsed;
+        return true;
+    }
+};
+
+// Parses a chain description such as
+//
+//     pitch factor=0.8; lowpass cutoff=3400   # the default
+//
+// Stages are separated by ';' or newlines and run in the order written;
+// '#' starts a comment. Returns false and fills `error` on malformed input.
+inline bool parseChainSpec(const std::string& spec, std::vector<StageConfig>* stages,
+                           std::string* error) {
+    stages->clear();
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t end = spec.find_first_of(";\n", pos);
+        if (end == std::string::npos)
+            end = spec.size();
+        std::string entry = spec.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t comment = entry.find('#');
+        if (comment != std::string::npos)
+            entry.erase(comment);
+
+        StageConfig config;
+        size_t at = 0;
+        while (true) {
+            size_t start = entry.find_first_not_of(" \t\r", at);
+            if (start == std::string::npos)
+                break;
+            size_t stop = entry.find_first_of(" \t\r", start);
+            if (stop == std::string::npos)
+                stop = entry.size();
+            std::string token = entry.substr(start, stop - start);
+            at = stop;
+
+            if (config.type.empty()) {
+                config.type = token;
+                continue;
+            }
+            size_t equals = token.find('=');
+            if (equals == std::string::npos || equals == 0 || equals + 1 == token.size()) {
+                *error = "Expected key=value after '" + config.type + "', got '" + token + "'";
+                return false;
+            }
+            config.settings.emplace_back(token.substr(0, equals), token.substr(equals + 1));
+        }
+        if (!config.type.empty())
+            stages->push_back(std::move(config));
+    }
+    return true;
+}
+
+// A stage type the chain can build by name. `create` placement-constructs
+// the stage in `memory`, which is `size` bytes aligned to `alignment`.
+// `validate`, if set, checks settings that can fail (files to load, names
+// to look up) before anything is torn down, so a bad description leaves
+// the old chain running.
+struct StageType {
+    const char* name;
+    const char* keys;        // Accepted settings, space separated
+    const char* textKeys;    // Those of them that take a word or path, not a number
+    const char* description;
+    size_t size;
+    size_t alignment;
+    DspStage* (*create)(void* memory, const StageConfig& config, double sampleRate);
+    bool (*validate)(const StageConfig& config, std::string* error);
+};
+
+template <typename Stage>
+StageType makeStageType(const char* name, const char* keys, const char* textKeys, const char* description,
+                        DspStage* (*create)(void*, const StageConfig&, double),
+                        bool (*validate)(const StageConfig&, std::string*) = nullptr) {
+    return StageType{ name, keys, textKeys, description, sizeof(Stage), alignof(Stage), create, validate };
+}
+
+// Name -> StageType lookup. The built-in stages are registered on first
+// use; add() makes further types available to every chain built later.
+class StageRegistry {
+public:
+    static StageRegistry& instance() {
+        static StageRegistry registry;
+        return registry;
+    }
+
+    void add(const StageType& type) {
+        for (StageType& existing : entries) {
+            if (std::strcmp(existing.name, type.name) == 0) {
+                existing = type;
+                return;
+            }
+        }
+        entries.push_back(type);
+    }
+
+    const StageType* find(const std::string& name) const {
+        for (const StageType& type : entries) {
+            if (name == type.name)
+                return &type;
+        }
+        return nullptr;
+    }
+
+    const std::vector<StageType>& types() const { return entries; }
+
+private:
+    StageRegistry() {
+        add(makeStageType<PitchStage>(
+            "pitch", "factor engine formants formant-shift", "engine",
+            "Pitch shift by `factor`; engine=granular|vocoder, formants=1 preserves formants",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                PitchStage* stage = new (memory) PitchStage(
+                    c.number("factor", 0.8), rate,
+                    c.text("engine", "granular") == "vocoder" ? PitchStage::Engine::Vocoder
+                                                              : PitchStage::Engine::Granular);
+                stage->setFormantPreservation(c.number("formants", 0.0) != 0.0,
+                                              c.number("formant-shift", 1.0));
+                return stage;
+            },
+            [](const StageConfig& c, std::string* error) {
+                std::string engine = c.text("engine", "granular");
+                if (engine != "granular" && engine != "vocoder") {
+                    *error = "Stage 'pitch': unknown engine '" + engine + "'";
+                    return false;
+                }
+                return true;
+            }));
+        add(makeStageType<FilterStage>(
+            "lowpass", "cutoff q order", "", "Butterworth low-pass at `cutoff` Hz, `order` 2-16",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                return new (memory) FilterStage(BiquadType::LowPass, c.number("cutoff", 3400.0),
+                                                c.number("q", 0.7071), rate,
+                                                static_cast<int>(c.number("order", 2.0)));
+            }));
+        add(makeStageType<FilterStage>(
+            "filter", "type cutoff q gain order", "type",
+            "Biquad type=lowpass|highpass|bandpass|notch|allpass|peak|lowshelf|highshelf, "
+            "`gain` dB for peak/shelves",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                BiquadType type = BiquadType::LowPass;
+                parseBiquadType(c.text("type", "lowpass").c_str(), &type);
+                return new (memory) FilterStage(type, c.number("cutoff", 1000.0),
+                                                c.number("q", 0.7071), rate,
+                                                static_cast<int>(c.number("order", 2.0)),
+                                                c.number("gain", 0.0));
+            },
+            validateFilterType));
+        add(makeStageType<StateVariableFilter>(
+            "svf", "type cutoff q gain", "type", "State-variable filter; same types as `filter`",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                BiquadType type = BiquadType::LowPass;
+                parseBiquadType(c.text("type", "lowpass").c_str(), &type);
+                return new (memory) StateVariableFilter(type, c.number("cutoff", 1000.0),
+                                                        c.number("q", 0.7071), rate,
+                                                        c.number("gain", 0.0));
+            },
+            validateFilterType));
+        add(makeStageType<LowPassFilter>(
+            "onepole", "cutoff", "", "One-pole (6 dB/octave) low-pass at `cutoff` Hz",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                return new (memory) LowPassFilter(c.number("cutoff", 300.0), rate);
+            }));
+        add(makeStageType<Gain>(
+            "gain", "db", "", "Fixed gain of `db` decibels",
+            [](void* memory, const StageConfig& c, double) -> DspStage* {
+                return new (memory) Gain(c.number("db", 0.0));
+            }));
+        add(makeStageType<Distortion>(
+            "distortion", "drive mix", "", "Soft clipper with `drive` dB and wet `mix` 0..1",
+            [](void* memory, const StageConfig& c, double) -> DspStage* {
+                return new (memory) Distortion(c.number("drive", 12.0), c.number("mix", 1.0));
+            }));
+        add(makeStageType<RingModulator>(
+            "ringmod", "freq mix", "", "Ring modulator with a `freq` Hz sine carrier, wet `mix` 0..1",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                return new (memory) RingModulator(c.number("freq", 30.0), c.number("mix", 0.5), rate);
+            }));
+        add(makeStageType<HelmetResonator>(
+            "helmet", "size feedback damping mix", "",
+            "Helmet/mask resonance; size 0.25..2, feedback 0..0.95, damping and mix 0..1",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                return new (memory) HelmetResonator(rate, c.number("size", 1.0), c.number("feedback", 0.5),
+                                                    c.number("damping", 0.4), c.number("mix", 0.35));
+            }));
+        add(makeStageType<BreathGenerator>(
+            "breath", "level period duck", "",
+            "Respirator breathing every `period` s at `level`, ducked by `duck` 0..1 under speech",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                return new (memory) BreathGenerator(rate, c.number("level", 0.2), c.number("period", 4.5),
+                                                    c.number("duck", 0.8));
+            }));
+        add(makeStageType<Reverb>(
+            "reverb", "room damping mix", "", "Freeverb-style reverb; room, damping and mix 0..1",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                return new (memory) Reverb(rate, c.number("room", 0.5), c.number("damping", 0.5),
+                                           c.number("mix", 0.25));
+            }));
+        add(makeStageType<Convolver>(
+            "convolver", "ir partition direct mix gain normalize", "ir",
+            "Convolution with the WAV impulse response `ir`; partition size, direct=1 for "
+            "zero latency, wet `mix` 0..1, `gain` dB, normalize=1 scales to unit energy",
+            [](void* memory, const StageConfig& c, double rate) -> DspStage* {
+                std::vector<float> ir;
+                std::string error;
+                loadImpulseResponse(c.text("ir", ""), rate, &ir, &error);
+                float scale = static_cast<float>(std::pow(10.0, c.number("gain", 0.0) / 20.0));
+                if (c.number("normalize", 0.0) != 0.0) {
+                    double energy = 0.0;
+                    for (float x : ir)
+                        energy += static_cast<double>(x) * x;
+                    if (energy > 0.0)
+                        scale /= static_cast<float>(std::sqrt(energy));
+                }
+                for (float& x : ir)
+                    x *= scale;
+                return new (memory) Convolver(ir, static_cast<size_t>(c.number("partition", 128.0)),
+                                              c.number("direct", 1.0) != 0.0, c.number("mix", 1.0));
+            },
+            [](const StageConfig& c, std::string* error) {
+                if (!c.find("ir")) {
+                    *error = "Stage 'convolver' needs ir=<file.wav>";
+                    return false;
+                }
+                double partition = c.number("partition", 128.0);
+                if (partition < 1.0 || partition > Convolver::MaxPartition) {
+                    *error = "Stage 'convolver': partition must be 1 to "
+                           + std::to_string(Convolver::MaxPartition);
+                    return false;
+                }
+                WavReader reader;
+                if (!reader.open(*c.find("ir"))) {
+                    *error = "Stage 'convolver': " + reader.errorString();
+                    return false;
+                }
+                return true;
+            }));
+    }
+
+    // For the stages that take a biquad type=
+    static bool validateFilterType(const StageConfig& c, std::string* error) {
+        BiquadType type;
+        if (!parseBiquadType(c.text("type", "lowpass").c_str(), &type)) {
+            *error = "Stage '" + c.type + "': unknown type '" + c.text("type", "") + "'";
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<StageType> entries;
+};
+
+// A chain of stages assembled at run time from a description.
+//
+// build() placement-constructs every stage back to back in one
+// cache-line-aligned arena, so the per-block walk touches a flat array of
+// pointers into contiguous memory. Stages run out of place between two
+// preallocated ping-pong buffers, chunked to the block size given to the
+// constructor; the first stage reads the caller's input and the last one
+// writes the caller's output. Nothing is allocated after build(), and
+// rebuilding is only valid while nothing is processing.
+class EffectChain : public DspStage {
+public:
+    explicit EffectChain(size_t maxBlock = 1024)
+        : blockSize(maxBlock), ping(maxBlock), pong(maxBlock) {}
+
+    ~EffectChain() { destroy(); }
+
+    EffectChain(const EffectChain&) = delete;
+    EffectChain& operator=(const EffectChain&) = delete;
+
+    bool build(const std::string& spec, double sampleRate) {
+        std::vector<StageConfig> configs;
+        std::string error;
+        if (!parseChainSpec(spec, &configs, &error)) {
+            errorText = error;
+            return false;
+        }
+        return build(configs, sampleRate);
+    }
+
+    // On failure the previous chain is kept and errorString() says why
+    bool build(const std::vector<StageConfig>& configs, double sampleRate) {
+        std::vector<const StageType*> types;
+        if (!resolve(configs, &types, &errorText))
+            return false;
+        size_t total = 0;
+        for (const StageType* type : types)
+            total = alignUp(total, type->alignment) + type->size;
+
+        destroy();
+        arena.reset(new unsigned char[total + ArenaAlignment]);
+        unsigned char* base = reinterpret_cast<unsigned char*>(
+            alignUp(reinterpret_cast<uintptr_t>(arena.get()), ArenaAlignment));
+        size_t offset = 0;
+        for (size_t i = 0; i < types.size(); ++i) {
+            offset = alignUp(offset, types[i]->alignment);
+            stages.push_back(types[i]->create(base + offset, configs[i], sampleRate));
+            names.push_back(configs[i].type);
+            offset += types[i]->size;
+        }
+        errorText.clear();
+        return true;
+    }
+
+    const std::string& errorString() const { return errorText; }
+
+    // Runs every check build() makes without constructing any stage, so
+    // options can be rejected up front without loading an IR twice
+    static bool check(const std::string& spec, std::string* error) {
+        std::vector<StageConfig> configs;
+        std::vector<const StageType*> types;
+        return parseChainSpec(spec, &configs, error) && resolve(configs, &types, error);
+    }
+
+    size_t size() const { return stages.size(); }
+    DspStage* stage(size_t index) const { return stages[index]; }
+    const std::string& stageName(size_t index) const { return names[index]; }
+
+    // First stage of the given class, or null
+    template <typename Stage>
+    Stage* find() const {
+        for (DspStage* stage : stages) {
+            if (Stage* match = dynamic_cast<Stage*>(stage))
+                return match;
+        }
+        return nullptr;
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        const size_t count = stages.size();
+        if (count == 0) {
+            if (in != out)
+                std::memmove(out, in, n * sizeof(float));
+            return;
+        }
+        if (count == 1) {
+            stages[0]->process(in, out, n);
+            return;
+        }
+
+        float* buffers[2] = { ping.data(), pong.data() };
+        for (size_t offset = 0; offset < n; offset += blockSize) {
+            size_t chunk = n - offset < blockSize ? n - offset : blockSize;
+            const float* src = in + offset;
+            for (size_t i = 0; i + 1 < count; ++i) {
+                float* dst = buffers[i & 1];
+                stages[i]->process(src, dst, chunk);
+                src = dst;
+            }
+            stages[count - 1]->process(src, out + offset, chunk);
+        }
+    }
+
+    void reset() override {
+        for (DspStage* stage : stages)
+            stage->reset();
+    }
+
+    size_t latency() const override {
+        size_t total = 0;
+        for (DspStage* stage : stages)
+            total += stage->latency();
+        return total;
+    }
+
+private:
+    static const size_t ArenaAlignment = 64;
+
+    static size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Looks up each stage's type and checks its settings
+    static bool resolve(const std::vector<StageConfig>& configs, std::vector<const StageType*>* types,
+                        std::string* error) {
+        const StageRegistry& registry = StageRegistry::instance();
+        for (const StageConfig& config : configs) {
+            const StageType* type = registry.find(config.type);
+            if (!type) {
+                *error = "Unknown stage '" + config.type + "'";
+                return false;
+            }
+            for (const auto& setting : config.settings) {
+                if (!hasKey(type->keys, setting.first)) {
+                    *error = "Stage '" + config.type + "' has no setting '" + setting.first + "'";
+                    return false;
+                }
+                double value;
+                if (!hasKey(type->textKeys, setting.first)
+                    && !StageConfig::parseNumber(setting.second, &value)) {
+                    *error = "Stage '" + config.type + "' setting '" + setting.first
+                           + "' is not a number: '" + setting.second + "'";
+                    return false;
+                }
+            }
+            if (type->validate && !type->validate(config, error))
+                return false;
+            types->push_back(type);
+        }
+        return true;
+    }
+
+    static bool hasKey(const char* keys, const std::string& key) {
+        const char* p = keys;
+        while (*p) {
+            const char* end = std::strchr(p, ' ');
+            size_t length = end ? static_cast<size_t>(end - p) : std::strlen(p);
+            if (length == key.size() && key.compare(0, length, p, length) == 0)
+                return true;
+            if (!end)
+                break;
+            p = end + 1;
+        }
+        return false;
+    }
+
+    void destroy() {
+        for (DspStage* stage : stages)
+            stage->~DspStage();
+        stages.clear();
+        names.clear();
+        arena.reset();
+    }
+
+    size_t blockSize;
+    std::vector<float> ping;
+    std::vector<float> pong;
+    std::unique_ptr<unsigned char[]> arena;
+    std::vector<DspStage*> stages;
+    std::vector<std::string> names;
+    std::string errorText;
+};
+
+#endif // EFFECTCHAIN_H
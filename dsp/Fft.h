@@ -0,0 +1,130 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "DspMath.h"
+
+struct Complex {
+    float re;
+    float im;
+};
+
+// Radix-2 FFT for real signals.
+//
+// A real transform of size N is computed as a complex transform of size
+// N/2 over the even/odd samples, followed by a split step. Twiddles and
+// the bit-reversal permutation are tabulated in the constructor together
+// with the work buffer, so forward() and inverse() never allocate.
+// inverse(forward(x)) == x; no extra scaling is needed by the caller.
+class RealFft {
+public:
+    explicit RealFft(size_t fftSize)
+        : n(fftSize), half(fftSize / 2), twiddles(half / 2 + 1), splitTwiddles(half + 1),
+          bitReverse(half), work(half)
+    {
+        for (size_t k = 0; k < twiddles.size(); ++k) {
+            double angle = -2.0 * PI * k / half;
+            twiddles[k] = { static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)) };
+        }
+        for (size_t k = 0; k <= half; ++k) {
+            double angle = -2.0 * PI * k / n;
+            splitTwiddles[k] = { static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)) };
+        }
+        size_t bits = 0;
+        while ((size_t(1) << bits) < half)
+            ++bits;
+        for (size_t i = 0; i < half; ++i) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b)
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            bitReverse[i] = r;
+        }
+    }
+
+    size_t size() const { return n; }
+    size_t bins() const { return half + 1; }
+
+    // n real samples in, n/2 + 1 bins out
+    void forward(const float* input, Complex* spectrum) {
+        for (size_t i = 0; i < half; ++i)
+            work[bitReverse[i]] = { input[2 * i], input[2 * i + 1] };
+        transform(false);
+
+        spectrum[0] = { work[0].re + work[0].im, 0.0f };
+        spectrum[half] = { work[0].re - work[0].im, 0.0f };
+        for (size_t k = 1; k < half; ++k) {
+            Complex a = work[k];
+            Complex b = { work[half - k].re, -work[half - k].im };
+            Complex even = { 0.5f * (a.re + b.re), 0.5f * (a.im + b.im) };
+            Complex diff = { 0.5f * (a.re - b.re), 0.5f * (a.im - b.im) };
+            // odd = diff / i
+            Complex odd = { diff.im, -diff.re };
+            Complex w = splitTwiddles[k];
+            spectrum[k] = { even.re + w.re * odd.re - w.im * odd.im,
+                            even.im + w.re * odd.im + w.im * odd.re };
+        }
+    }
+
+    // n/2 + 1 bins in, n real samples out
+    void inverse(const Complex* spectrum, float* output) {
+        for (size_t k = 0; k < half; ++k) {
+            Complex a = spectrum[k];
+            Complex b = { spectrum[half - k].re, -spectrum[half - k].im };
+            Complex even = { a.re + b.re, a.im + b.im };
+            Complex diff = { a.re - b.re, a.im - b.im };
+            Complex w = { splitTwiddles[k].re, -splitTwiddles[k].im };
+            Complex odd = { w.re * diff.re - w.im * diff.im, w.re * diff.im + w.im * diff.re };
+            // z = even + i * odd
+            work[bitReverse[k]] = { even.re - odd.im, even.im + odd.re };
+        }
+        transform(true);
+
+        const float scale = 1.0f / n;
+        for (size_t i = 0; i < half; ++i) {
+            output[2 * i] = work[i].re * scale;
+            output[2 * i + 1] = work[i].im * scale;
+        }
+    }
+
+private:
+    // In-place iterative radix-2 over the bit-reversed work buffer
+    void transform(bool inverse) {
+        for (size_t length = 2; length <= half; length <<= 1) {
+            size_t stride = half / length;
+            size_t middle = length / 2;
+            for (size_t start = 0; start < half; start += length) {
+                for (size_t j = 0; j < middle; ++j) {
+                    Complex w = twiddleAt(j * stride);
+                    if (inverse)
+                        w.im = -w.im;
+                    Complex& a = work[start + j];
+                    Complex& b = work[start + j + middle];
+                    Complex t = { w.re * b.re - w.im * b.im, w.re * b.im + w.im * b.re };
+                    b = { a.re - t.re, a.im - t.im };
+                    a = { a.re + t.re, a.im + t.im };
+                }
+            }
+        }
+    }
+
+    // e^{-2 pi i k / half} for k < half, from a quarter-plus-one table
+    Complex twiddleAt(size_t k) const {
+        size_t quarter = half / 2;
+        if (k <= quarter)
+            return twiddles[k];
+        Complex t = twiddles[half - k];
+        return { t.re, -t.im };
+    }
+
+    size_t n;
+    size_t half;
+    std::vector<Complex> twiddles;
+    std::vector<Complex> splitTwiddles;
+    std::vector<size_t> bitReverse;
+    std::vector<Complex> work;
+};
+
+#endif // FFT_H
@@ -0,0 +1,88 @@
+#ifndef FILTERSTAGE_H
+#define FILTERSTAGE_H
+
+#include <cstddef>
+#include <cstring>
+
+#include "Biquad.h"
+#include "DspStage.h"
+#include "SmoothedValue.h"
+
+// Name used in chain descriptions for each BiquadType; false if unknown
+inline bool parseBiquadType(const char* name, BiquadType* type) {
+    static const struct { const char* name; BiquadType type; } names[] = {
+        { "lowpass", BiquadType::LowPass },   { "highpass", BiquadType::HighPass },
+        { "bandpass", BiquadType::BandPass }, { "notch", BiquadType::Notch },
+        { "allpass", BiquadType::AllPass },   { "peak", BiquadType::Peaking },
+        { "lowshelf", BiquadType::LowShelf }, { "highshelf", BiquadType::HighShelf },
+    };
+    for (const auto& entry : names) {
+        if (std::strcmp(entry.name, name) == 0) {
+            *type = entry.type;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Filter stage of order 2 to 16 built from a BiquadCascade.
+//
+// Low- and high-passes above second order are Butterworth, with `q`
+// setting only the resonance of a second-order one; other types repeat
+// the same section, splitting `gainDb` between them so the peak or shelf
+// keeps the requested gain. setCutoff() glides: while the cutoff moves
+// the sections are redesigned once per block.
+class FilterStage : public DspStage {
+public:
+    FilterStage(BiquadType type, double cutoffFrequency, double q, double sampleRate,
+                int order = 2, double gainDb = 0.0)
+        : type(type), quality(q), gain(gainDb), rate(sampleRate),
+          sections(order < 2 ? 1 : (order / 2 > static_cast<int>(BiquadCascade::MaxSections)
+                                        ? BiquadCascade::MaxSections : static_cast<size_t>(order / 2))),
+          cutoff(cutoffFrequency, 0.05, sampleRate)
+    {
+        design(cutoffFrequency);
+    }
+
+    void setCutoff(double cutoffFrequency) { cutoff.setTarget(cutoffFrequency); }
+    double cutoffFrequency() const { return cutoff.target(); }
+
+    BiquadType filterType() const { return type; }
+    size_t order() const { return sections * 2; }
+
+    // Magnitude of the current design at `frequency`
+    double magnitudeDb(double frequency) const { return cascade.magnitudeDb(frequency, rate); }
+
+    void process(const float* in, float* out, size_t n) override {
+        if (!cutoff.settled())
+            design(cutoff.advance(n));
+        cascade.process(in, out, n);
+    }
+
+    void reset() override {
+        cascade.reset();
+        cutoff.reset(cutoff.target());
+        design(cutoff.target());
+    }
+
+private:
+    void design(double frequency) {
+        const bool butterworth = sections > 1 &&
+            (type == BiquadType::LowPass || type == BiquadType::HighPass);
+        for (size_t i = 0; i < sections; ++i) {
+            double q = butterworth ? butterworthQ(sections, i) : quality;
+            cascade.setSection(i, BiquadCoefficients::design(type, frequency, q, rate,
+                                                             gain / sections));
+        }
+    }
+
+    BiquadType type;
+    double quality;
+    double gain;
+    double rate;
+    size_t sections;
+    SmoothedValue cutoff;
+    BiquadCascade cascade;
+};
+
+#endif // FILTERSTAGE_H
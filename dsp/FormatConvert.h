@@ -0,0 +1,489 @@
+#ifndef FORMATCONVERT_H
+#define FORMATCONVERT_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "SampleConvert.h"
+#include "Simd.h"
+
+// Device sample formats <-> the mono signal the path runs on.
+//
+// A device may negotiate any combination of encoding, sample size, byte
+// order and channel count. Each combination gets its own converter,
+// instantiated at compile time from a sample codec and a channel count,
+// so the inner loops have no per-sample branches; formatConverter() picks
+// one when a stream starts. Decoding mixes all channels down to mono (the
+// mean), encoding writes the mono signal to every channel. Integers are
+// full scale at +-1.0 like int16 (x / 2^(bits-1)), unsigned ones are
+// offset by half their range, and float -> integer rounds to nearest and
+// saturates, with NaN becoming silence, as floatToInt16Sample() does.
+// Float devices get the chain's samples unchanged.
+//
+// The common little-endian layouts (int16 and float32, mono and stereo)
+// have SIMD kernels that match the scalar ones bit for bit.
+enum class SampleEncoding {
+    Signed,
+    Unsigned,
+    Float
+};
+
+const int MAX_FORMAT_CHANNELS = 8;
+
+struct SampleFormat {
+    SampleEncoding encoding;
+    int bits;       // 8, 16, 24 (packed) or 32; float is 32 only
+    bool bigEndian;
+    int channels;   // 1..MAX_FORMAT_CHANNELS
+};
+
+inline size_t frameBytes(const SampleFormat& format) {
+    return static_cast<size_t>(format.channels) * static_cast<size_t>(format.bits / 8);
+}
+
+// E.g. "s16le x2", "f32be x1", "u8 x2"
+inline std::string sampleFormatName(const SampleFormat& format) {
+    std::string name = format.encoding == SampleEncoding::Float ? "f"
+                     : format.encoding == SampleEncoding::Unsigned ? "u" : "s";
+    name += std::to_string(format.bits);
+    if (format.bits > 8)
+        name += format.bigEndian ? "be" : "le";
+    return name + " x" + std::to_string(format.channels);
+}
+
+typedef void (*FrameDecodeKernel)(const void* in, float* out, size_t frames);
+typedef void (*FrameDecodeInt16Kernel)(const void* in, int16_t* out, size_t frames);
+typedef void (*FrameEncodeKernel)(const float* in, void* out, size_t frames);
+
+struct FormatConverter {
+    FrameDecodeKernel toFloat;      // Device frames -> mono float
+    FrameDecodeInt16Kernel toInt16; // Device frames -> mono int16 (the jitter buffer's format)
+    FrameEncodeKernel fromFloat;    // Mono float -> device frames
+    SampleFormat format;
+    SimdLevel level;
+};
+
+// Raw little- or big-endian unsigned integer of `Bytes` bytes
+template <int Bytes, bool BigEndian>
+inline uint32_t loadBytes(const uint8_t* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < Bytes; ++i)
+        value |= static_cast<uint32_t>(p[BigEndian ? Bytes - 1 - i : i]) << (8 * i);
+    return value;
+}
+
+template <int Bytes, bool BigEndian>
+inline void storeBytes(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < Bytes; ++i)
+        p[BigEndian ? Bytes - 1 - i : i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+// Two's complement or offset-binary integers of `Bits` bits
+template <int Bits, bool IsSigned, bool BigEndian>
+struct IntegerCodec {
+    static const int Bytes = Bits / 8;
+
+    static float load(const uint8_t* p) {
+        uint32_t raw = loadBytes<Bytes, BigEndian>(p);
+        if (!IsSigned)
+            raw ^= 1u << (Bits - 1); // Offset binary -> two's complement
+        int32_t value = static_cast<int32_t>(raw << (32 - Bits)) >> (32 - Bits);
+        return static_cast<float>(value) * (1.0f / static_cast<float>(1u << (Bits - 1)));
+    }
+
+    static void store(uint8_t* p, float sample) {
+        uint32_t raw = static_cast<uint32_t>(quantize(sample));
+        if (!IsSigned)
+            raw ^= 1u << (Bits - 1);
+        storeBytes<Bytes, BigEndian>(p, raw);
+    }
+
+    // Round to nearest even, saturating; NaN maps to silence
+    static int32_t quantize(float sample) {
+        if (Bits == 16)
+            return floatToInt16Sample(sample);
+        // float holds every 24-bit step exactly; 32 bits need a double
+        const double full = static_cast<double>(1u << (Bits - 1));
+        double scaled = static_cast<double>(sample) * full;
+        if (!(scaled < full - 1.0))
+            return scaled != scaled ? 0 : static_cast<int32_t>(full - 1.0);
+        if (scaled < -full)
+            return static_cast<int32_t>(-full);
+        return static_cast<int32_t>(std::nearbyint(scaled));
+    }
+};
+
+template <bool BigEndian>
+struct Float32Codec {
+    static const int Bytes = 4;
+
+    static float load(const uint8_t* p) {
+        uint32_t raw = loadBytes<4, BigEndian>(p);
+        float sample;
+        std::memcpy(&sample, &raw, sizeof(sample));
+        return sample;
+    }
+
+    static void store(uint8_t* p, float sample) {
+        uint32_t raw;
+        std::memcpy(&raw, &sample, sizeof(raw));
+        storeBytes<4, BigEndian>(p, raw);
+    }
+};
+
+// Stereo sums in float like the SIMD kernels; wider layouts in double so
+// that a 24-bit sample repeated on every channel comes back unchanged
+template <typename Codec, int Channels>
+inline float loadMono(const uint8_t* frame) {
+    if (Channels <= 2) {
+        float sum = Codec::load(frame);
+        if (Channels == 2)
+            sum += Codec::load(frame + Codec::Bytes);
+        return Channels == 1 ? sum : sum * 0.5f;
+    }
+    double sum = 0.0;
+    for (int c = 0; c < Channels; ++c)
+        sum += Codec::load(frame + c * Codec::Bytes);
+    return static_cast<float>(sum / Channels);
+}
+
+template <typename Codec, int Channels>
+void decodeFrames(const void* in, float* out, size_t frames) {
+    const uint8_t* p = static_cast<const uint8_t*>(in);
+    for (size_t i = 0; i < frames; ++i, p += Codec::Bytes * Channels)
+        out[i] = loadMono<Codec, Channels>(p);
+}
+
+template <typename Codec, int Channels>
+void decodeFramesInt16(const void* in, int16_t* out, size_t frames) {
+    const uint8_t* p = static_cast<const uint8_t*>(in);
+    for (size_t i = 0; i < frames; ++i, p += Codec::Bytes * Channels)
+        out[i] = floatToInt16Sample(loadMono<Codec, Channels>(p));
+}
+
+template <typename Codec, int Channels>
+void encodeFrames(const float* in, void* out, size_t frames) {
+    uint8_t* p = static_cast<uint8_t*>(out);
+    for (size_t i = 0; i < frames; ++i, p += Codec::Bytes * Channels) {
+        Codec::store(p, in[i]);
+        for (int c = 1; c < Channels; ++c)
+            std::memcpy(p + c * Codec::Bytes, p, Codec::Bytes);
+    }
+}
+
+// The scalar kernels of `Codec` for 1..MAX_FORMAT_CHANNELS channels
+template <typename Codec, size_t... Index>
+inline FormatConverter codecConverter(const SampleFormat& format, std::index_sequence<Index...>) {
+    const FormatConverter table[] = {
+        { decodeFrames<Codec, Index + 1>, decodeFramesInt16<Codec, Index + 1>,
+          encodeFrames<Codec, Index + 1>, format, SimdLevel::Scalar }...
+    };
+    FormatConverter converter = table[format.channels - 1];
+    converter.format = format;
+    return converter;
+}
+
+template <typename Codec>
+inline FormatConverter codecConverter(const SampleFormat& format) {
+    return codecConverter<Codec>(format, std::make_index_sequence<MAX_FORMAT_CHANNELS>());
+}
+
+template <bool BigEndian>
+inline bool scalarFormatConverter(const SampleFormat& format, FormatConverter* converter) {
+    const bool isSigned = format.encoding == SampleEncoding::Signed;
+    switch (format.encoding) {
+    case SampleEncoding::Signed:
+    case SampleEncoding::Unsigned:
+        switch (format.bits) {
+        case 8:
+            *converter = isSigned ? codecConverter<IntegerCodec<8, true, BigEndian>>(format)
+                                  : codecConverter<IntegerCodec<8, false, BigEndian>>(format);
+            return true;
+        case 16:
+            *converter = isSigned ? codecConverter<IntegerCodec<16, true, BigEndian>>(format)
+                                  : codecConverter<IntegerCodec<16, false, BigEndian>>(format);
+            return true;
+        case 24:
+            *converter = isSigned ? codecConverter<IntegerCodec<24, true, BigEndian>>(format)
+                                  : codecConverter<IntegerCodec<24, false, BigEndian>>(format);
+            return true;
+        case 32:
+            *converter = isSigned ? codecConverter<IntegerCodec<32, true, BigEndian>>(format)
+                                  : codecConverter<IntegerCodec<32, false, BigEndian>>(format);
+            return true;
+        }
+        return false;
+    case SampleEncoding::Float:
+        if (format.bits != 32)
+            return false;
+        *converter = codecConverter<Float32Codec<BigEndian>>(format);
+        return true;
+    }
+    return false;
+}
+
+// Mono int16 and float32 are the existing sample kernels on other pointer types
+template <Int16ToFloatKernel Kernel>
+inline void monoInt16ToFloat(const void* in, float* out, size_t frames) {
+    Kernel(static_cast<const int16_t*>(in), out, frames);
+}
+
+template <FloatToInt16Kernel Kernel>
+inline void floatToMonoInt16(const float* in, void* out, size_t frames) {
+    Kernel(in, static_cast<int16_t*>(out), frames);
+}
+
+template <FloatToInt16Kernel Kernel>
+inline void monoFloat32ToInt16(const void* in, int16_t* out, size_t frames) {
+    Kernel(static_cast<const float*>(in), out, frames);
+}
+
+// Little-endian float32 mono needs no conversion at all
+inline void copyFloat32(const void* in, float* out, size_t frames) {
+    std::memcpy(out, in, frames * sizeof(float));
+}
+
+inline void copyToFloat32(const float* in, void* out, size_t frames) {
+    std::memcpy(out, in, frames * sizeof(float));
+}
+
+inline void copyInt16(const void* in, int16_t* out, size_t frames) {
+    std::memcpy(out, in, frames * sizeof(int16_t));
+}
+
+template <Int16ToFloatKernel ToFloat, FloatToInt16Kernel ToInt16>
+inline void setMonoKernels(const SampleFormat& format, SimdLevel level, FormatConverter* converter) {
+    if (format.encoding == SampleEncoding::Float)
+        *converter = { copyFloat32, monoFloat32ToInt16<ToInt16>, copyToFloat32, format, level };
+    else
+        *converter = { monoInt16ToFloat<ToFloat>, copyInt16, floatToMonoInt16<ToInt16>, format, level };
+}
+
+inline void setMonoKernels(const SampleFormat& format, SimdLevel level, FormatConverter* converter) {
+    switch (level) {
+#if defined(DSP_HAVE_X86)
+    case SimdLevel::Avx2: setMonoKernels<int16ToFloatAvx2, floatToInt16Avx2>(format, level, converter); return;
+    case SimdLevel::Sse2: setMonoKernels<int16ToFloatSse2, floatToInt16Sse2>(format, level, converter); return;
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon: setMonoKernels<int16ToFloatNeon, floatToInt16Neon>(format, level, converter); return;
+#endif
+    default: setMonoKernels<int16ToFloatScalar, floatToInt16Scalar>(format, SimdLevel::Scalar, converter); return;
+    }
+}
+
+// Stereo kernels convert through a stack block of this many frames
+const size_t CONVERT_CHUNK = 256;
+
+#if defined(DSP_HAVE_X86)
+// Mean of each stereo pair, rounded to nearest even like the scalar path
+DSP_TARGET("sse2")
+inline void stereoInt16ToInt16Sse2(const void* in, int16_t* out, size_t frames) {
+    const int16_t* src = static_cast<const int16_t*>(in);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i one = _mm_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m128i a = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i)), ones);
+        __m128i b = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 8)), ones);
+        // sum / 2: floor, plus one for an odd half that would land on an odd result
+        __m128i qa = _mm_srai_epi32(a, 1);
+        __m128i qb = _mm_srai_epi32(b, 1);
+        qa = _mm_add_epi32(qa, _mm_and_si128(_mm_and_si128(a, qa), one));
+        qb = _mm_add_epi32(qb, _mm_and_si128(_mm_and_si128(b, qb), one));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(qa, qb));
+    }
+    decodeFramesInt16<IntegerCodec<16, true, false>, 2>(src + 2 * i, out + i, frames - i);
+}
+
+DSP_TARGET("sse2")
+inline void stereoInt16ToFloatSse2(const void* in, float* out, size_t frames) {
+    const int16_t* src = static_cast<const int16_t*>(in);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128 scale = _mm_set1_ps(1.0f / 65536.0f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128i sums = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i)), ones);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(sums), scale));
+    }
+    decodeFrames<IntegerCodec<16, true, false>, 2>(src + 2 * i, out + i, frames - i);
+}
+
+DSP_TARGET("sse2")
+inline void floatToStereoInt16Sse2(const float* in, void* out, size_t frames) {
+    int16_t* dst = static_cast<int16_t*>(out);
+    int16_t mono[8];
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        floatToInt16Sse2(in + i, mono, 8);
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mono));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi16(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 8), _mm_unpackhi_epi16(v, v));
+    }
+    encodeFrames<IntegerCodec<16, true, false>, 2>(in + i, dst + 2 * i, frames - i);
+}
+
+DSP_TARGET("sse2")
+inline void stereoFloat32ToFloatSse2(const void* in, float* out, size_t frames) {
+    const float* src = static_cast<const float*>(in);
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 a = _mm_loadu_ps(src + 2 * i);
+        __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+        __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+    decodeFrames<Float32Codec<false>, 2>(src + 2 * i, out + i, frames - i);
+}
+
+DSP_TARGET("sse2")
+inline void stereoFloat32ToInt16Sse2(const void* in, int16_t* out, size_t frames) {
+    const float* src = static_cast<const float*>(in);
+    float mono[CONVERT_CHUNK];
+    for (size_t i = 0; i < frames; i += CONVERT_CHUNK) {
+        size_t n = frames - i < CONVERT_CHUNK ? frames - i : CONVERT_CHUNK;
+        stereoFloat32ToFloatSse2(src + 2 * i, mono, n);
+        floatToInt16Sse2(mono, out + i, n);
+    }
+}
+
+DSP_TARGET("sse2")
+inline void floatToStereoFloat32Sse2(const float* in, void* out, size_t frames) {
+    float* dst = static_cast<float*>(out);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 v = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(v, v));
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(v, v));
+    }
+    encodeFrames<Float32Codec<false>, 2>(in + i, dst + 2 * i, frames - i);
+}
+#endif
+
+#if defined(DSP_HAVE_NEON)
+inline void stereoInt16ToInt16Neon(const void* in, int16_t* out, size_t frames) {
+    const int16_t* src = static_cast<const int16_t*>(in);
+    const int32x4_t one = vdupq_n_s32(1);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t v = vld2q_s16(src + 2 * i);
+        int32x4_t lo = vaddl_s16(vget_low_s16(v.val[0]), vget_low_s16(v.val[1]));
+        int32x4_t hi = vaddl_s16(vget_high_s16(v.val[0]), vget_high_s16(v.val[1]));
+        int32x4_t qlo = vshrq_n_s32(lo, 1);
+        int32x4_t qhi = vshrq_n_s32(hi, 1);
+        qlo = vaddq_s32(qlo, vandq_s32(vandq_s32(lo, qlo), one));
+        qhi = vaddq_s32(qhi, vandq_s32(vandq_s32(hi, qhi), one));
+        vst1q_s16(out + i, vcombine_s16(vmovn_s32(qlo), vmovn_s32(qhi)));
+    }
+    decodeFramesInt16<IntegerCodec<16, true, false>, 2>(src + 2 * i, out + i, frames - i);
+}
+
+inline void stereoInt16ToFloatNeon(const void* in, float* out, size_t frames) {
+    const int16_t* src = static_cast<const int16_t*>(in);
+    const float32x4_t scale = vdupq_n_f32(1.0f / 65536.0f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        int16x4x2_t v = vld2_s16(src + 2 * i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vaddl_s16(v.val[0], v.val[1])), scale));
+    }
+    decodeFrames<IntegerCodec<16, true, false>, 2>(src + 2 * i, out + i, frames - i);
+}
+
+inline void floatToStereoInt16Neon(const float* in, void* out, size_t frames) {
+    int16_t* dst = static_cast<int16_t*>(out);
+    int16_t mono[8];
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        floatToInt16Neon(in + i, mono, 8);
+        int16x8x2_t v;
+        v.val[0] = v.val[1] = vld1q_s16(mono);
+        vst2q_s16(dst + 2 * i, v);
+    }
+    encodeFrames<IntegerCodec<16, true, false>, 2>(in + i, dst + 2 * i, frames - i);
+}
+
+inline void stereoFloat32ToFloatNeon(const void* in, float* out, size_t frames) {
+    const float* src = static_cast<const float*>(in);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t v = vld2q_f32(src + 2 * i);
+        vst1q_f32(out + i, vmulq_f32(vaddq_f32(v.val[0], v.val[1]), half));
+    }
+    decodeFrames<Float32Codec<false>, 2>(src + 2 * i, out + i, frames - i);
+}
+
+inline void stereoFloat32ToInt16Neon(const void* in, int16_t* out, size_t frames) {
+    const float* src = static_cast<const float*>(in);
+    float mono[CONVERT_CHUNK];
+    for (size_t i = 0; i < frames; i += CONVERT_CHUNK) {
+        size_t n = frames - i < CONVERT_CHUNK ? frames - i : CONVERT_CHUNK;
+        stereoFloat32ToFloatNeon(src + 2 * i, mono, n);
+        floatToInt16Neon(mono, out + i, n);
+    }
+}
+
+inline void floatToStereoFloat32Neon(const float* in, void* out, size_t frames) {
+    float* dst = static_cast<float*>(out);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t v;
+        v.val[0] = v.val[1] = vld1q_f32(in + i);
+        vst2q_f32(dst + 2 * i, v);
+    }
+    encodeFrames<Float32Codec<false>, 2>(in + i, dst + 2 * i, frames - i);
+}
+#endif
+
+// Converter for `format`, with SIMD kernels at `level` where there are
+// some; false if the format is not one of the supported combinations.
+inline bool formatConverter(const SampleFormat& format, SimdLevel level, FormatConverter* converter) {
+    if (format.channels < 1 || format.channels > MAX_FORMAT_CHANNELS)
+        return false;
+    if (!(format.bigEndian ? scalarFormatConverter<true>(format, converter)
+                           : scalarFormatConverter<false>(format, converter)))
+        return false;
+    if (format.bigEndian && format.bits > 8)
+        return true;
+
+    const bool int16 = format.encoding == SampleEncoding::Signed && format.bits == 16;
+    const bool float32 = format.encoding == SampleEncoding::Float;
+    if (format.channels == 1 && (int16 || float32)) {
+        setMonoKernels(format, level, converter);
+    } else if (format.channels == 2 && (int16 || float32)) {
+        switch (level) {
+#if defined(DSP_HAVE_X86)
+        case SimdLevel::Avx2:
+        case SimdLevel::Sse2:
+            if (int16)
+                *converter = { stereoInt16ToFloatSse2, stereoInt16ToInt16Sse2, floatToStereoInt16Sse2,
+                               format, SimdLevel::Sse2 };
+            else
+                *converter = { stereoFloat32ToFloatSse2, stereoFloat32ToInt16Sse2, floatToStereoFloat32Sse2,
+                               format, SimdLevel::Sse2 };
+            break;
+#endif
+#if defined(DSP_HAVE_NEON)
+        case SimdLevel::Neon:
+            if (int16)
+                *converter = { stereoInt16ToFloatNeon, stereoInt16ToInt16Neon, floatToStereoInt16Neon,
+                               format, SimdLevel::Neon };
+            else
+                *converter = { stereoFloat32ToFloatNeon, stereoFloat32ToInt16Neon, floatToStereoFloat32Neon,
+                               format, SimdLevel::Neon };
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+#endif // FORMATCONVERT_H
@@ -0,0 +1,28 @@
+#ifndef GAIN_H
+#define GAIN_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "DspStage.h"
+
+// Fixed gain, set in decibels
+class Gain : public DspStage {
+public:
+    explicit Gain(double gainDb = 0.0) { setGainDb(gainDb); }
+
+    void setGainDb(double gainDb) {
+        gain = static_cast<float>(std::pow(10.0, gainDb / 20.0));
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        const float g = gain;
+        for (size_t i = 0; i < n; ++i)
+            out[i] = in[i] * g;
+    }
+
+private:
+    float gain;
+};
+
+#endif // GAIN_H
@@ -0,0 +1,104 @@
+#ifndef HELMETRESONATOR_H
+#define HELMETRESONATOR_H
+
+#include <cstddef>
+
+#include "DelayLine.h"
+#include "DspStage.h"
+
+// Small-enclosure resonance, as of a voice inside a helmet or mask.
+//
+// Three damped feedback combs with mutually prime delays of a few
+// milliseconds (the reflections between face and visor) run in parallel;
+// their peaks every few hundred hertz give the boxy, metallic colour.
+// `size` scales the delays (1 is roughly a helmet), `feedback` (0..0.95)
+// sets how long it rings, `damping` (0..1) how quickly the highs die out
+// and `mix` the wet/dry balance. The lines are sized for size=2 up front.
+class HelmetResonator : public DspStage {
+public:
+    HelmetResonator(double sampleRate, double size = 1.0, double feedback = 0.5,
+                    double damping = 0.4, double mix = 0.35)
+        : rate(sampleRate),
+          combs{ Comb(delaySamples(MaxSize, 0)), Comb(delaySamples(MaxSize, 1)),
+                 Comb(delaySamples(MaxSize, 2)) }
+    {
+        setSize(size);
+        setFeedback(feedback);
+        setDamping(damping);
+        setMix(mix);
+    }
+
+    void setSize(double size) {
+        size = size < MinSize ? MinSize : size > MaxSize ? MaxSize : size;
+        for (size_t i = 0; i < CombCount; ++i)
+            combs[i].length = delaySamples(size, i);
+    }
+
+    void setFeedback(double amount) {
+        feedback = static_cast<float>(amount < 0.0 ? 0.0 : amount > 0.95 ? 0.95 : amount);
+    }
+
+    void setDamping(double amount) {
+        damp = static_cast<float>(0.7 * (amount < 0.0 ? 0.0 : amount > 1.0 ? 1.0 : amount));
+    }
+
+    void setMix(double amount) {
+        wet = static_cast<float>(amount < 0.0 ? 0.0 : amount > 1.0 ? 1.0 : amount);
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        const float fb = feedback, d = damp;
+        const float w = wet * (1.0f - fb) * (1.0f / CombCount), dry = 1.0f - wet;
+        for (size_t i = 0; i < n; ++i) {
+            float x = in[i];
+            float sum = 0.0f;
+            for (Comb& comb : combs)
+                sum += comb.process(x, fb, d);
+            out[i] = dry * x + w * sum;
+        }
+    }
+
+    void reset() override {
+        for (Comb& comb : combs)
+            comb.clear();
+    }
+
+private:
+    static const size_t CombCount = 3;
+    static constexpr double MinSize = 0.25;
+    static constexpr double MaxSize = 2.0;
+
+    struct Comb {
+        explicit Comb(size_t maxLength) : line(maxLength), length(maxLength), filtered(0.0f) {}
+
+        float process(float input, float feedback, float damp) {
+            float output = line.read(length - 1);
+            filtered = output * (1.0f - damp) + filtered * damp;
+            line.write(input + filtered * feedback);
+            return output;
+        }
+
+        void clear() {
+            line.clear();
+            filtered = 0.0f;
+        }
+
+        DelayLine<float> line;
+        size_t length;
+        float filtered;
+    };
+
+    size_t delaySamples(double size, size_t comb) const {
+        static const double baseMs[CombCount] = { 1.7, 2.3, 3.1 };
+        size_t length = static_cast<size_t>(baseMs[comb] * size * 1e-3 * rate + 0.5);
+        return length < 1 ? 1 : length;
+    }
+
+    double rate;
+    Comb combs[CombCount];
+    float feedback;
+    float damp;
+    float wet;
+};
+
+#endif // HELMETRESONATOR_H
@@ -0,0 +1,125 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "SpscRingBuffer.h"
+
+// Bounded buffer between a push-mode producer (capture) and a pull-mode
+// consumer (playback) that holds a target amount of queued audio.
+//
+// The consumer always gets the number of frames it asks for. Playback
+// starts once the target is queued; if the buffer runs dry the missing
+// frames are padded with silence and it re-primes to the target (an
+// underrun). If more than target + tolerance piles up, the oldest frames
+// are dropped back down to the target, so latency cannot creep. A push
+// that does not fit at all is truncated (an overrun). push() and pull()
+// are lock-free and may run on different threads; the counters can be
+// read from any thread.
+template <typename T>
+class JitterBuffer {
+public:
+    struct Stats {
+        size_t fillFrames;     // Currently queued
+        size_t targetFrames;
+        uint64_t underruns;    // Times playback ran dry
+        uint64_t overruns;     // Pushes truncated because the buffer was full
+        uint64_t corrections;  // Times the backlog was trimmed to the target
+        uint64_t paddedFrames; // Silence inserted
+        uint64_t droppedFrames;// Audio discarded by overruns and corrections
+    };
+
+    JitterBuffer(size_t capacityFrames, size_t targetFrames)
+        : ring(capacityFrames), target(std::min(targetFrames, capacityFrames / 2)), priming(true),
+          underruns(0), overruns(0), corrections(0), paddedFrames(0),
+          pushDropped(0), pullDropped(0) {}
+
+    // Desired queue depth; clamped to half the capacity
+    void setTarget(size_t frames) {
+        target.store(std::min(frames, ring.capacity() / 2), std::memory_order_relaxed);
+    }
+
+    size_t targetFrames() const { return target.load(std::memory_order_relaxed); }
+
+    // Producer side
+    size_t push(const T* data, size_t count) {
+        size_t written = ring.write(data, count);
+        if (written < count) {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            pushDropped.fetch_add(count - written, std::memory_order_relaxed);
+        }
+        return written;
+    }
+
+    // Consumer side: always fills `count` frames
+    void pull(T* out, size_t count) {
+        const size_t goal = targetFrames();
+        size_t fill = ring.availableToRead();
+
+        if (priming) {
+            if (fill < goal || fill == 0) {
+                std::fill(out, out + count, T(0));
+                paddedFrames.fetch_add(count, std::memory_order_relaxed);
+                return;
+            }
+            priming = false;
+        }
+
+        const size_t tolerance = std::max(goal / 2, count);
+        if (fill > goal + tolerance) {
+            size_t excess = ring.discard(fill - goal);
+            corrections.fetch_add(1, std::memory_order_relaxed);
+            pullDropped.fetch_add(excess, std::memory_order_relaxed);
+        }
+
+        size_t got = ring.read(out, count);
+        if (got < count) {
+            std::fill(out + got, out + count, T(0));
+            paddedFrames.fetch_add(count - got, std::memory_order_relaxed);
+            underruns.fetch_add(1, std::memory_order_relaxed);
+            priming = true;
+        }
+    }
+
+    size_t fillFrames() const { return ring.availableToRead(); }
+
+    // Consumer side: true until the target is queued again after a start
+    // or an underrun
+    bool isPriming() const { return priming; }
+
+    Stats stats() const {
+        Stats s;
+        s.fillFrames = ring.availableToRead();
+        s.targetFrames = targetFrames();
+        s.underruns = underruns.load(std::memory_order_relaxed);
+        s.overruns = overruns.load(std::memory_order_relaxed);
+        s.corrections = corrections.load(std::memory_order_relaxed);
+        s.paddedFrames = paddedFrames.load(std::memory_order_relaxed);
+        s.droppedFrames = pushDropped.load(std::memory_order_relaxed)
+                        + pullDropped.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Empties the buffer and re-primes. Only valid while neither side runs.
+    void reset() {
+        ring.reset();
+        priming = true;
+    }
+
+private:
+    SpscRingBuffer<T> ring;
+    std::atomic<size_t> target;
+    bool priming; // Consumer-owned
+
+    std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> corrections;
+    std::atomic<uint64_t> paddedFrames;
+    std::atomic<uint64_t> pushDropped;
+    std::atomic<uint64_t> pullDropped;
+};
+
+#endif // JITTERBUFFER_H
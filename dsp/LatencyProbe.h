@@ -0,0 +1,120 @@
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "DspMath.h"
+#include "DspStage.h"
+#include "Fft.h"
+
+// Test signal for delay measurements: three Hann-windowed exponential
+// chirps (300 Hz - 3 kHz, inside every voice chain's passband) at uneven
+// spacing. The chirps give a sharp waveform correlation peak; the uneven
+// bursts give the envelope one too, which survives pitch shifting.
+inline std::vector<float> makeLatencyProbe(double sampleRate) {
+    const double burstSeconds = 0.08;
+    const double starts[] = { 0.0, 0.25, 0.43 };
+    const double f0 = 300.0, f1 = 3000.0;
+    const size_t burst = static_cast<size_t>(burstSeconds * sampleRate);
+    std::vector<float> probe(static_cast<size_t>(0.51 * sampleRate) + burst, 0.0f);
+
+    const double k = std::log(f1 / f0) / burstSeconds;
+    for (double start : starts) {
+        size_t offset = static_cast<size_t>(start * sampleRate);
+        for (size_t i = 0; i < burst; ++i) {
+            double t = i / sampleRate;
+            double phase = 2.0 * PI * f0 * (std::exp(k * t) - 1.0) / k;
+            double window = 0.5 - 0.5 * std::cos(2.0 * PI * i / (burst - 1));
+            probe[offset + i] = static_cast<float>(0.5 * window * std::sin(phase));
+        }
+    }
+    return probe;
+}
+
+struct DelayEstimate {
+    size_t samples;
+    double confidence; // Normalized correlation at the peak, 0..1
+    bool envelope;     // Found on the envelopes rather than the waveforms
+};
+
+// Where `reference` best lines up inside `recorded`, looking at lags
+// 0..maxDelay. Waveform correlation is exact for linear paths; with
+// `envelope` both signals are rectified and smoothed first (2 ms), which
+// still finds bursts whose pitch or phase was changed, to a few ms.
+inline DelayEstimate estimateDelay(const std::vector<float>& reference,
+                                   const std::vector<float>& recorded, size_t maxDelay,
+                                   double sampleRate, bool envelope = false) {
+    const size_t length = std::min(recorded.size(), reference.size() + maxDelay);
+    std::vector<double> a(reference.begin(), reference.end());
+    std::vector<double> b(recorded.begin(), recorded.begin() + length);
+    if (envelope) {
+        const double smooth = std::exp(-1.0 / (0.002 * sampleRate));
+        for (std::vector<double>* x : { &a, &b }) {
+            double state = 0.0, mean = 0.0;
+            for (double& v : *x) {
+                state = std::fabs(v) + smooth * (state - std::fabs(v));
+                v = state;
+                mean += state;
+            }
+            mean /= x->empty() ? 1.0 : static_cast<double>(x->size());
+            for (double& v : *x)
+                v -= mean;
+        }
+    }
+
+    // Cross-correlation through one transform of each side
+    const size_t n = nextPowerOfTwo(a.size() + b.size());
+    RealFft fft(n);
+    std::vector<float> frame(n, 0.0f);
+    std::vector<Complex> fa(n / 2 + 1), fb(n / 2 + 1);
+    std::copy(a.begin(), a.end(), frame.begin());
+    fft.forward(frame.data(), fa.data());
+    std::fill(frame.begin(), frame.end(), 0.0f);
+    std::copy(b.begin(), b.end(), frame.begin());
+    fft.forward(frame.data(), fb.data());
+    for (size_t k = 0; k < fa.size(); ++k) {
+        Complex x = fa[k], y = fb[k];
+        fb[k] = { x.re * y.re + x.im * y.im, x.re * y.im - x.im * y.re };
+    }
+    fft.inverse(fb.data(), frame.data());
+
+    DelayEstimate estimate = { 0, 0.0, envelope };
+    const size_t lags = std::min(maxDelay + 1, length);
+    for (size_t lag = 1; lag < lags; ++lag) {
+        if (frame[lag] > frame[estimate.samples])
+            estimate.samples = lag;
+    }
+
+    double referenceEnergy = 0.0, windowEnergy = 0.0;
+    for (double v : a)
+        referenceEnergy += v * v;
+    for (size_t i = estimate.samples; i < std::min(length, estimate.samples + a.size()); ++i)
+        windowEnergy += b[i] * b[i];
+    double norm = std::sqrt(referenceEnergy * windowEnergy);
+    estimate.confidence = norm > 0.0 ? std::max(0.0, frame[estimate.samples] / norm) : 0.0;
+    return estimate;
+}
+
+// Runs the probe through `stage` (reset first) in `block`-sized calls and
+// measures the delay: by waveform if that correlates well, else by
+// envelope. Output is not needed afterwards, so the stage is left dirty.
+inline DelayEstimate measureStageDelay(DspStage& stage, double sampleRate, size_t maxDelay,
+                                       size_t block = 256) {
+    std::vector<float> probe = makeLatencyProbe(sampleRate);
+    std::vector<float> signal(probe);
+    signal.resize(probe.size() + maxDelay, 0.0f);
+    stage.reset();
+    for (size_t offset = 0; offset < signal.size(); offset += block)
+        stage.process(signal.data() + offset, signal.data() + offset,
+                      std::min(block, signal.size() - offset));
+
+    DelayEstimate estimate = estimateDelay(probe, signal, maxDelay, sampleRate);
+    if (estimate.confidence < 0.5)
+        estimate = estimateDelay(probe, signal, maxDelay, sampleRate, true);
+    return estimate;
+}
+
+#endif // LATENCYPROBE_H
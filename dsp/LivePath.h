@@ -0,0 +1,258 @@
+#ifndef LIVEPATH_H
+#define LIVEPATH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "CallbackStats.h"
+#include "DriftCompensator.h"
+#include "EffectChain.h"
+#include "FilterStage.h"
+#include "FormatConvert.h"
+#include "JitterBuffer.h"
+#include "PitchStage.h"
+#include "PolyphaseResampler.h"
+#include "SampleConvert.h"
+#include "TripleBuffer.h"
+
+// The bodies of the two live audio callbacks and the chain they drive,
+// without Qt. CaptureSink and PlaybackSource (AudioDevices.h) wrap them in
+// QIODevices; voiceBench calls them directly, so what it times and guards
+// is the code the devices run.
+
+const int PROCESS_CHUNK = 256;            // Frames per step through a callback
+const int MIN_TARGET_LATENCY_MS = 10;
+const int MAX_TARGET_LATENCY_MS = 100;
+const int JITTER_BUFFER_FRAMES = 1 << 15; // Room for 2x the max target at 96 kHz
+
+typedef JitterBuffer<int16_t> SampleJitterBuffer;
+
+// Settings the GUI thread may change while audio is running. The GUI
+// publishes whole snapshots through a TripleBuffer and the audio thread
+// picks up the newest once per callback, so neither side ever blocks on
+// the other and the audio side never sees a half-written set. Values of
+// -1 or 0 below leave the chain's own configuration alone.
+struct ParameterSnapshot {
+    int pitchEngine = -1;       // LiveChain::PitchEngine
+    bool formants = false;
+    float formantShift = 1.0f;
+    float pitchFactor = 0.0f;   // Pitch stage ratio, if > 0
+    float cutoffHz = 0.0f;      // Filter cutoff, if > 0
+    int targetLatencyMs = 40;   // Jitter buffer depth, 10-100 ms
+};
+
+typedef TripleBuffer<ParameterSnapshot> AudioParameters;
+
+// An EffectChain plus the live controls that act on it.
+//
+// The pitch settings act on the chain's first "pitch" stage and the cutoff
+// on its first low-pass filter stage (else its first filter stage), if
+// any; both glide to new values. Until build() succeeds the chain is empty
+// and audio passes through unchanged.
+class LiveChain {
+public:
+    // Which pitch engine the chain's pitch stage runs
+    enum PitchEngine {
+        ConfiguredPitch = -1, // Whatever the chain description asked for
+        GranularPitch,        // Low-latency two-head delay-line shifter
+        PhaseVocoderPitch     // STFT shifter, optionally formant preserving
+    };
+
+    LiveChain() : chain(PROCESS_CHUNK), pitch(nullptr), filter(nullptr) {}
+
+    // Rebuilds the chain for `sampleRate`; only while no audio is flowing.
+    // On failure the previous chain stays and chainErrorString() says why.
+    bool build(const std::string& spec, double sampleRate) {
+        if (!chain.build(spec, sampleRate))
+            return false;
+        pitch = chain.find<PitchStage>();
+        // The cutoff control belongs to the first low-pass, if there is one
+        filter = chain.find<FilterStage>();
+        for (size_t i = 0; i < chain.size(); ++i) {
+            FilterStage* stage = dynamic_cast<FilterStage*>(chain.stage(i));
+            if (stage && stage->filterType() == BiquadType::LowPass) {
+                filter = stage;
+                break;
+            }
+        }
+        return true;
+    }
+
+    const std::string& chainErrorString() const { return chain.errorString(); }
+
+    void setPitchEngine(PitchEngine engine) {
+        if (pitch && engine != ConfiguredPitch)
+            pitch->setEngine(engine == PhaseVocoderPitch ? PitchStage::Engine::Vocoder
+                                                         : PitchStage::Engine::Granular);
+    }
+
+    void setFormantPreservation(bool enabled, double formantShift = 1.0) {
+        if (pitch)
+            pitch->setFormantPreservation(enabled, formantShift);
+    }
+
+    // Applies a live settings snapshot; cheap enough to call every callback
+    void applyParameters(const ParameterSnapshot& snapshot) {
+        if (snapshot.pitchEngine != ConfiguredPitch) {
+            setPitchEngine(static_cast<PitchEngine>(snapshot.pitchEngine));
+            setFormantPreservation(snapshot.formants, snapshot.formantShift);
+        }
+        if (pitch && snapshot.pitchFactor > 0.0f)
+            pitch->setPitchFactor(snapshot.pitchFactor);
+        if (filter && snapshot.cutoffHz > 0.0f)
+            filter->setCutoff(snapshot.cutoffHz);
+    }
+
+    // Algorithmic delay of the chain, in samples
+    size_t chainLatency() const { return chain.latency(); }
+
+    // Runs the chain in place on float samples. The playback callback
+    // calls this straight on its resampled block, so nothing is copied
+    // between stages.
+    void render(float* block, size_t count) {
+        chain.process(block, block, count);
+    }
+
+private:
+    EffectChain chain;
+    PitchStage* pitch;
+    FilterStage* filter;
+};
+
+// Timing and heap-guard instrumentation for the two live callbacks
+struct CallbackMonitors {
+    CallbackMonitor capture{"CaptureSink::writeData"};
+    CallbackMonitor playback{"PlaybackSource::readData"};
+};
+
+// Capture side: queues the raw samples in the jitter buffer; the DSP runs
+// on the playback side. Frames in any other format than 16-bit mono are
+// mixed down and converted on the way in, a stack block at a time. When
+// the input runs at another rate than the output, `bridge` (configured for
+// the two rates) brings the samples to the playback rate first, so
+// everything past the jitter buffer runs at a single rate.
+class CaptureCallback {
+public:
+    CaptureCallback(SampleJitterBuffer* buffer, CallbackMonitor* monitor, const FormatConverter& converter,
+                    PolyphaseResampler* bridge = nullptr)
+        : buffer(buffer), monitor(monitor), converter(converter), bridge(bridge),
+          samples(defaultSampleConverter()), frameSize(frameBytes(converter.format)),
+          native(converter.format.encoding == SampleEncoding::Signed && converter.format.bits == 16
+                 && !converter.format.bigEndian && converter.format.channels == 1) {}
+
+    size_t bytesPerFrame() const { return frameSize; }
+
+    // Takes `frames` frames in the device's format
+    void process(const char* data, size_t frames) {
+        CallbackMonitor::Scope scope(*monitor);
+        if (bridge) {
+            resample(data, frames);
+            return;
+        }
+        if (native) {
+            buffer->push(reinterpret_cast<const int16_t*>(data), frames);
+            return;
+        }
+        int16_t block[PROCESS_CHUNK];
+        for (size_t offset = 0; offset < frames; offset += PROCESS_CHUNK) {
+            size_t count = std::min(static_cast<size_t>(PROCESS_CHUNK), frames - offset);
+            converter.toInt16(data + offset * frameSize, block, count);
+            buffer->push(block, count);
+        }
+    }
+
+private:
+    // Input chunks small enough that they and their output fit one stack block
+    void resample(const char* data, size_t frames) {
+        const size_t chunk = std::min(static_cast<size_t>(PROCESS_CHUNK), bridge->maxInput(PROCESS_CHUNK));
+        float in[PROCESS_CHUNK];
+        float out[PROCESS_CHUNK];
+        int16_t block[PROCESS_CHUNK];
+        for (size_t offset = 0; offset < frames; offset += chunk) {
+            size_t count = std::min(chunk, frames - offset);
+            converter.toFloat(data + offset * frameSize, in, count);
+            size_t produced = bridge->process(in, count, out);
+            samples.toInt16(out, block, produced);
+            buffer->push(block, produced);
+        }
+    }
+
+    SampleJitterBuffer* buffer;
+    CallbackMonitor* monitor;
+    FormatConverter converter;
+    PolyphaseResampler* bridge;
+    SampleConverter samples;
+    size_t frameSize;
+    bool native; // The jitter buffer's own format: no conversion
+};
+
+// Playback side: always fills the full request. The jitter buffer pads
+// with silence while it primes or after an underrun, so the output never
+// stalls. Reads go through a DriftCompensator, so a capture clock that
+// runs slightly fast or slow is absorbed by resampling instead of by trims
+// and underruns.
+//
+// The chain is rendered on demand: each chunk is resampled into a float
+// block on the stack, processed in place, and converted straight into the
+// device's buffer, in the stream's format. Nothing is copied through an
+// intermediate queue and nothing is allocated per callback.
+class PlaybackCallback {
+public:
+    PlaybackCallback(LiveChain* chain, SampleJitterBuffer* buffer, DriftCompensator* compensator,
+                     AudioParameters* parameters, CallbackMonitor* monitor, int sampleRate,
+                     const FormatConverter& converter)
+        : chain(chain), buffer(buffer), compensator(compensator), parameters(parameters), monitor(monitor),
+          sampleRate(sampleRate), converter(converter), frameSize(frameBytes(converter.format)) {}
+
+    size_t bytesPerFrame() const { return frameSize; }
+
+    // Applies the current settings snapshot; call on the audio thread
+    // before the output starts
+    void syncParameters() {
+        if (parameters) {
+            parameters->update();
+            applySnapshot(parameters->latest());
+        }
+    }
+
+    // Jitter buffer depth for a target in milliseconds at this stream's rate
+    static size_t targetFrames(int latencyMs, int sampleRate) {
+        latencyMs = std::min(std::max(latencyMs, MIN_TARGET_LATENCY_MS), MAX_TARGET_LATENCY_MS);
+        return static_cast<size_t>(static_cast<int64_t>(latencyMs) * sampleRate / 1000);
+    }
+
+    // Fills `frames` frames in the device's format
+    void process(char* data, size_t frames) {
+        CallbackMonitor::Scope scope(*monitor);
+        // This is the parameters' only reader; pick up the GUI's newest snapshot
+        if (parameters && parameters->update())
+            applySnapshot(parameters->latest());
+
+        float block[PROCESS_CHUNK];
+        for (size_t offset = 0; offset < frames; offset += PROCESS_CHUNK) {
+            size_t count = std::min(static_cast<size_t>(PROCESS_CHUNK), frames - offset);
+            compensator->render(block, count);
+            chain->render(block, count);
+            converter.fromFloat(block, data + offset * frameSize, count);
+        }
+    }
+
+private:
+    void applySnapshot(const ParameterSnapshot& snapshot) {
+        buffer->setTarget(targetFrames(snapshot.targetLatencyMs, sampleRate));
+        chain->applyParameters(snapshot);
+    }
+
+    LiveChain* chain;
+    SampleJitterBuffer* buffer;
+    DriftCompensator* compensator;
+    AudioParameters* parameters;
+    CallbackMonitor* monitor;
+    int sampleRate;
+    FormatConverter converter;
+    size_t frameSize;
+};
+
+#endif // LIVEPATH_H
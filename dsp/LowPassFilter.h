@@ -0,0 +1,72 @@
+#ifndef LOWPASSFILTER_H
+#define LOWPASSFILTER_H
+
+#include <cstddef>
+
+#include "DspMath.h"
+#include "DspStage.h"
+#include "SmoothedValue.h"
+
+// Simple Low-Pass Filter Implementation
+//
+// setCutoff() glides to the new frequency: the coefficient is ramped
+// linearly across each block towards a per-block one-pole target, so a
+// swept cutoff does not click.
+class LowPassFilter : public DspStage {
+public:
+    LowPassFilter(double cutoffFrequency, double sampleRate)
+        : rate(sampleRate), cutoff(cutoffFrequency, 0.05, sampleRate) {
+        alpha = coefficient(cutoffFrequency);
+        prev = 0.0f;
+    }
+
+    void setCutoff(double cutoffFrequency) { cutoff.setTarget(cutoffFrequency); }
+    double cutoffFrequency() const { return cutoff.target(); }
+
+    float processSample(float input) {
+        float output = prev + (alpha * (input - prev));
+        prev = output;
+        return output;
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        float state = prev;
+        float a = alpha;
+        if (!cutoff.settled() && n > 0) {
+            const float end = coefficient(cutoff.advance(n));
+            const float step = (end - a) / static_cast<float>(n);
+            for (size_t i = 0; i < n; ++i) {
+                a += step;
+                state += a * (in[i] - state);
+                out[i] = state;
+            }
+            alpha = end;
+            prev = state;
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            state += a * (in[i] - state);
+            out[i] = state;
+        }
+        prev = state;
+    }
+
+    void reset() override {
+        prev = 0.0f;
+        cutoff.reset(cutoff.target());
+        alpha = coefficient(cutoff.target());
+    }
+
+private:
+    float coefficient(double cutoffFrequency) const {
+        double RC = 1.0 / (2 * PI * cutoffFrequency);
+        return static_cast<float>(1.0 / (RC * rate + 1.0));
+    }
+
+    double rate;
+    SmoothedValue cutoff;
+    float alpha;
+    float prev;
+};
+
+#endif // LOWPASSFILTER_H
@@ -0,0 +1,219 @@
+#ifndef PHASEVOCODER_H
+#define PHASEVOCODER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "DspMath.h"
+#include "DspStage.h"
+#include "Fft.h"
+
+// STFT phase-vocoder pitch shifter.
+//
+// Every hop the last fftSize input samples are windowed and transformed,
+// each bin's true frequency is recovered from its phase advance, and the
+// bins are moved to pitchFactor times their frequency before resynthesis
+// by overlap-add. Latency is fftSize samples: the FIFOs are offset by
+// fftSize - hop, and a sample leaves the overlap-add one hop after that.
+//
+// In FormantMode::Preserve the spectral envelope is estimated by cepstral
+// smoothing, divided out before the bins are moved and reapplied (scaled
+// by formantShift) afterwards, so a deep pitch drop keeps the vocal-tract
+// resonances where they were instead of dragging them down with it.
+//
+// Every buffer, including the FFT tables, is allocated in the constructor.
+class PhaseVocoder : public DspStage {
+public:
+    enum class FormantMode {
+        Off,
+        Preserve
+    };
+
+    PhaseVocoder(double pitchFactor, double sampleRate, size_t fftSize = 2048, size_t overlap = 4)
+        : factor(pitchFactor), formantMode(FormantMode::Off), formantShift(1.0),
+          n(nextPowerOfTwo(std::max<size_t>(fftSize, 16))), bins(n / 2 + 1),
+          hop(n / std::max<size_t>(overlap, 2)), fifoOffset(n - hop),
+          lifter(std::max<size_t>(4, std::min(n / 4, static_cast<size_t>(sampleRate / 700.0)))),
+          fft(n), window(n), inFifo(n), outFifo(n), outAccum(2 * n), frame(n),
+          spectrum(bins), lastPhase(bins), sumPhase(bins), analysisMag(bins),
+          analysisFreq(bins), synthesisMag(bins), synthesisFreq(bins), envelope(bins),
+          cepstrum(n), cepstrumSpectrum(bins)
+    {
+        double energy = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * i / n));
+            energy += window[i] * window[i];
+        }
+        // Analysis and synthesis both apply the window
+        olaScale = static_cast<float>(hop / energy);
+        reset();
+    }
+
+    // Pitch factor (>1 higher pitch, <1 lower pitch)
+    void setPitchFactor(double pitchFactor) { factor = pitchFactor; }
+    double pitchFactor() const { return factor; }
+
+    void setFormantMode(FormantMode mode) { formantMode = mode; }
+
+    // Envelope scaling in Preserve mode: 1.0 keeps formants, <1 lowers them
+    void setFormantShift(double ratio) { formantShift = ratio; }
+
+    size_t fftSize() const { return n; }
+    size_t hopSize() const { return hop; }
+    // A sample leaves the overlap-add one hop after the frame holding it is
+    // complete, so the delay is a whole frame, not just the FIFO offset
+    size_t latency() const override { return n; }
+
+    // Copies up to the next frame boundary at a time; a frame is analysed
+    // and resynthesised every hop samples.
+    void process(const float* in, float* out, size_t count) override {
+        while (count > 0) {
+            size_t chunk = std::min(count, n - rover);
+            // Take the input before writing so in-place processing is safe
+            std::memcpy(inFifo.data() + rover, in, chunk * sizeof(float));
+            std::memcpy(out, outFifo.data() + (rover - fifoOffset), chunk * sizeof(float));
+            rover += chunk;
+            in += chunk;
+            out += chunk;
+            count -= chunk;
+            if (rover >= n) {
+                rover = fifoOffset;
+                processFrame();
+            }
+        }
+    }
+
+    float processSample(float input) {
+        inFifo[rover] = input;
+        float output = outFifo[rover - fifoOffset];
+        if (++rover >= n) {
+            rover = fifoOffset;
+            processFrame();
+        }
+        return output;
+    }
+
+    void reset() override {
+        std::fill(inFifo.begin(), inFifo.end(), 0.0f);
+        std::fill(outFifo.begin(), outFifo.end(), 0.0f);
+        std::fill(outAccum.begin(), outAccum.end(), 0.0f);
+        std::fill(lastPhase.begin(), lastPhase.end(), 0.0f);
+        std::fill(sumPhase.begin(), sumPhase.end(), 0.0f);
+        rover = fifoOffset;
+    }
+
+private:
+    void processFrame() {
+        for (size_t i = 0; i < n; ++i)
+            frame[i] = inFifo[i] * window[i];
+        fft.forward(frame.data(), spectrum.data());
+
+        // Analysis: magnitude and true frequency (in bins) per bin
+        const double expected = 2.0 * PI * hop / n;
+        const double oversampling = static_cast<double>(n) / hop;
+        for (size_t k = 0; k < bins; ++k) {
+            float re = spectrum[k].re, im = spectrum[k].im;
+            double phase = std::atan2(im, re);
+            double delta = phase - lastPhase[k] - k * expected;
+            lastPhase[k] = static_cast<float>(phase);
+            delta -= 2.0 * PI * std::floor(delta / (2.0 * PI) + 0.5);
+            analysisMag[k] = std::sqrt(re * re + im * im);
+            analysisFreq[k] = static_cast<float>(k + delta * oversampling / (2.0 * PI));
+        }
+
+        const bool formants = formantMode == FormantMode::Preserve;
+        if (formants) {
+            estimateEnvelope();
+            for (size_t k = 0; k < bins; ++k)
+                analysisMag[k] /= envelope[k];
+        }
+
+        // Move every bin to pitchFactor times its frequency
+        std::fill(synthesisMag.begin(), synthesisMag.end(), 0.0f);
+        std::fill(synthesisFreq.begin(), synthesisFreq.end(), 0.0f);
+        for (size_t k = 0; k < bins; ++k) {
+            size_t target = static_cast<size_t>(k * factor + 0.5);
+            if (target >= bins)
+                break;
+            synthesisMag[target] += analysisMag[k];
+            synthesisFreq[target] = static_cast<float>(analysisFreq[k] * factor);
+        }
+
+        if (formants) {
+            for (size_t k = 0; k < bins; ++k)
+                synthesisMag[k] *= envelopeAt(k / formantShift);
+        }
+
+        // Synthesis: accumulate phase at the moved frequencies
+        for (size_t k = 0; k < bins; ++k) {
+            double deviation = synthesisFreq[k] - static_cast<double>(k);
+            double advance = k * expected + 2.0 * PI * deviation / oversampling;
+            double phase = std::fmod(sumPhase[k] + advance, 2.0 * PI);
+            sumPhase[k] = static_cast<float>(phase);
+            spectrum[k] = { static_cast<float>(synthesisMag[k] * std::cos(phase)),
+                            static_cast<float>(synthesisMag[k] * std::sin(phase)) };
+        }
+        fft.inverse(spectrum.data(), frame.data());
+
+        for (size_t i = 0; i < n; ++i)
+            outAccum[i] += frame[i] * window[i] * olaScale;
+        std::memcpy(outFifo.data(), outAccum.data(), hop * sizeof(float));
+        std::memmove(outAccum.data(), outAccum.data() + hop, n * sizeof(float));
+        std::fill(outAccum.begin() + n, outAccum.end(), 0.0f);
+        std::memmove(inFifo.data(), inFifo.data() + hop, fifoOffset * sizeof(float));
+    }
+
+    // Cepstral smoothing of the current analysis magnitudes into `envelope`
+    void estimateEnvelope() {
+        for (size_t k = 0; k < bins; ++k)
+            cepstrumSpectrum[k] = { std::log(analysisMag[k] + 1e-9f), 0.0f };
+        fft.inverse(cepstrumSpectrum.data(), cepstrum.data());
+        for (size_t i = lifter; i <= n - lifter; ++i)
+            cepstrum[i] = 0.0f;
+        fft.forward(cepstrum.data(), cepstrumSpectrum.data());
+        for (size_t k = 0; k < bins; ++k)
+            envelope[k] = std::exp(cepstrumSpectrum[k].re);
+    }
+
+    float envelopeAt(double bin) const {
+        if (bin >= bins - 1)
+            return envelope[bins - 1];
+        size_t index = static_cast<size_t>(bin);
+        float frac = static_cast<float>(bin - index);
+        return envelope[index] + frac * (envelope[index + 1] - envelope[index]);
+    }
+
+    double factor; // Pitch factor (>1 higher pitch, <1 lower pitch)
+    FormantMode formantMode;
+    double formantShift;
+
+    size_t n;
+    size_t bins;
+    size_t hop;
+    size_t fifoOffset; // Input samples held before a frame is full; not the latency
+    size_t lifter; // Cepstral coefficients kept for the envelope
+    size_t rover;
+    float olaScale;
+
+    RealFft fft;
+    std::vector<float> window;
+    std::vector<float> inFifo;
+    std::vector<float> outFifo;
+    std::vector<float> outAccum;
+    std::vector<float> frame;
+    std::vector<Complex> spectrum;
+    std::vector<float> lastPhase;
+    std::vector<float> sumPhase;
+    std::vector<float> analysisMag;
+    std::vector<float> analysisFreq;
+    std::vector<float> synthesisMag;
+    std::vector<float> synthesisFreq;
+    std::vector<float> envelope;
+    std::vector<float> cepstrum;
+    std::vector<Complex> cepstrumSpectrum;
+};
+
+#endif // PHASEVOCODER_H
@@ -0,0 +1,180 @@
+#ifndef PITCHSHIFTER_H
+#define PITCHSHIFTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "Correlation.h"
+#include "DelayLine.h"
+#include "DspMath.h"
+#include "DspStage.h"
+
+// Delay-line pitch shifter with two crossfaded read heads.
+//
+// Each head reads the input through a delay that drifts by (1 - factor)
+// samples per output sample, so it plays back at `factor` times the input
+// rate. The usable delays form a window one grain long; a head is weighted
+// by a Hann window over its position in that range, so it fades out as it
+// reaches either end. When that happens it is moved back to sit half a
+// grain away from the other head, nudged by up to a quarter grain to the
+// position whose waveform best matches what the other head is playing.
+// That alignment keeps the splice in phase, which is what stops the
+// fundamental from being dragged off the requested ratio at every jump.
+//
+// All storage is allocated in the constructor; process() never allocates.
+class PitchShifter : public DspStage {
+public:
+    PitchShifter(double pitchFactor, double sampleRate, double grainMs = 20.0)
+        : factor(pitchFactor),
+          grainSize(std::max(16.0, grainMs * 0.001 * sampleRate)),
+          searchRange(static_cast<int>(grainSize / 4)),
+          matchLength(searchRange),
+          minDelay(searchRange + 1.0),
+          maxDelay(minDelay + grainSize),
+          buffer(static_cast<size_t>(maxDelay) + searchRange + matchLength + 2),
+          history(3 * searchRange + matchLength + 1), pattern(matchLength),
+          kernel(dotEnergyKernel(detectSimdLevel()))
+    {
+        reset();
+    }
+
+    // Pitch factor (>1 higher pitch, <1 lower pitch); safe to change between samples
+    void setPitchFactor(double pitchFactor) { factor = pitchFactor; }
+    double pitchFactor() const { return factor; }
+
+    // Average delay through the shifter, in samples
+    size_t latency() const override { return static_cast<size_t>(minDelay + grainSize * 0.5); }
+
+    // Same as processSample() per element, but the Hann weights are stepped
+    // with a rotation instead of calling sin() for every head and sample;
+    // they are only evaluated exactly at block starts and after a splice.
+    void process(const float* in, float* out, size_t n) override {
+        const double step = 1.0 - factor;
+        const double angle = PI * step / grainSize;
+        const double cosStep = std::cos(angle), sinStep = std::sin(angle);
+        double s[2], c[2];
+        for (int h = 0; h < 2; ++h)
+            headPhasor(h, &s[h], &c[h]);
+
+        for (size_t i = 0; i < n; ++i) {
+            buffer.write(in[i]);
+
+            float output = 0.0f;
+            float weight = 0.0f;
+            for (int h = 0; h < 2; ++h) {
+                float w = delay[h] > minDelay && delay[h] < maxDelay
+                    ? static_cast<float>(s[h] * s[h]) : 0.0f;
+                output += w * buffer.readFractional(delay[h]);
+                weight += w;
+            }
+
+            for (int h = 0; h < 2; ++h) {
+                if (advance(h, step)) {
+                    headPhasor(h, &s[h], &c[h]);
+                } else {
+                    double rotated = s[h] * cosStep + c[h] * sinStep;
+                    c[h] = c[h] * cosStep - s[h] * sinStep;
+                    s[h] = rotated;
+                }
+            }
+            out[i] = weight > 1e-3f ? output / weight : 0.0f;
+        }
+    }
+
+    float processSample(float input) {
+        buffer.write(input);
+
+        float output = 0.0f;
+        float weight = 0.0f;
+        for (int h = 0; h < 2; ++h) {
+            float w = window(delay[h]);
+            output += w * buffer.readFractional(delay[h]);
+            weight += w;
+        }
+
+        double step = 1.0 - factor;
+        for (int h = 0; h < 2; ++h)
+            advance(h, step);
+        return weight > 1e-3f ? output / weight : 0.0f;
+    }
+
+    void reset() override {
+        buffer.clear();
+        delay[0] = minDelay;
+        delay[1] = minDelay + grainSize * 0.5;
+    }
+
+private:
+    // Moves head h on by one sample; returns true if it had to be re-seated
+    bool advance(int h, double step) {
+        delay[h] += step;
+        if (step > 0.0 && delay[h] >= maxDelay)
+            splice(h, delay[1 - h] - grainSize * 0.5);
+        else if (step < 0.0 && delay[h] <= minDelay)
+            splice(h, delay[1 - h] + grainSize * 0.5);
+        else
+            return false;
+        return true;
+    }
+
+    // sin and cos of pi times head h's position through the grain
+    void headPhasor(int h, double* s, double* c) const {
+        double x = PI * (delay[h] - minDelay) / grainSize;
+        *s = std::sin(x);
+        *c = std::cos(x);
+    }
+
+    float window(double d) const {
+        double x = (d - minDelay) / grainSize;
+        if (x <= 0.0 || x >= 1.0)
+            return 0.0f;
+        float s = static_cast<float>(std::sin(PI * x));
+        return s * s;
+    }
+
+    // Re-seats head h near `target`, picking the offset whose recent
+    // history correlates best with the other head's.
+    void splice(int h, double target) {
+        size_t reference = static_cast<size_t>(std::lround(delay[1 - h]));
+        long centre = std::lround(target);
+        long lowest = std::max(1L, centre - searchRange);
+        long highest = std::min(static_cast<long>(maxDelay) + searchRange, centre + searchRange);
+
+        // Unroll the circular history so the search can use the SIMD kernel
+        size_t span = static_cast<size_t>(highest - lowest) + matchLength;
+        for (size_t j = 0; j < span; ++j)
+            history[j] = buffer.read(static_cast<size_t>(lowest) + j);
+        for (int k = 0; k < matchLength; ++k)
+            pattern[k] = buffer.read(reference + k);
+
+        long best = centre;
+        float bestScore = -1e30f;
+        for (long candidate = lowest; candidate <= highest; ++candidate) {
+            float correlation, energy;
+            kernel(pattern.data(), history.data() + (candidate - lowest), matchLength,
+                   &correlation, &energy);
+            float score = correlation / std::sqrt(energy + 1e-9f);
+            if (score > bestScore) {
+                bestScore = score;
+                best = candidate;
+            }
+        }
+        delay[h] = target + static_cast<double>(best - centre);
+    }
+
+    double factor; // Pitch factor (>1 higher pitch, <1 lower pitch)
+    double grainSize;
+    int searchRange;
+    int matchLength;
+    double minDelay;
+    double maxDelay;
+    double delay[2]; // Current read delay of each head, in samples
+    DelayLine<float> buffer;
+    std::vector<float> history; // Splice search scratch, sized for the widest search
+    std::vector<float> pattern;
+    DotEnergyKernel kernel;
+};
+
+#endif // PITCHSHIFTER_H
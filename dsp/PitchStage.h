@@ -0,0 +1,73 @@
+#ifndef PITCHSTAGE_H
+#define PITCHSTAGE_H
+
+#include <cstddef>
+
+#include "DspStage.h"
+#include "PhaseVocoder.h"
+#include "PitchShifter.h"
+#include "SmoothedValue.h"
+
+// Pitch stage that can switch engines while running: the low-latency
+// granular PitchShifter or the PhaseVocoder with optional formant
+// preservation. Both are built up front so switching never allocates; the
+// idle one keeps its stale history and is reset when it comes back.
+// setPitchFactor() glides to the new ratio over ~50 ms, stepping once per
+// block, so sweeps are heard as a glide rather than a jump.
+class PitchStage : public DspStage {
+public:
+    enum class Engine { Granular, Vocoder };
+
+    PitchStage(double pitchFactor, double sampleRate, Engine engine = Engine::Granular)
+        : shifter(pitchFactor, sampleRate), vocoder(pitchFactor, sampleRate),
+          active(nullptr), factor(pitchFactor, 0.05, sampleRate)
+    {
+        setEngine(engine);
+    }
+
+    void setEngine(Engine engine) {
+        DspStage* next = engine == Engine::Vocoder ? static_cast<DspStage*>(&vocoder)
+                                                   : static_cast<DspStage*>(&shifter);
+        if (next != active && active)
+            next->reset();
+        active = next;
+    }
+
+    Engine engine() const { return active == &vocoder ? Engine::Vocoder : Engine::Granular; }
+
+    void setPitchFactor(double pitchFactor) { factor.setTarget(pitchFactor); }
+    double pitchFactor() const { return factor.target(); }
+
+    void setFormantPreservation(bool enabled, double formantShift = 1.0) {
+        vocoder.setFormantMode(enabled ? PhaseVocoder::FormantMode::Preserve
+                                       : PhaseVocoder::FormantMode::Off);
+        vocoder.setFormantShift(formantShift);
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        if (!factor.settled()) {
+            double next = factor.advance(n);
+            shifter.setPitchFactor(next);
+            vocoder.setPitchFactor(next);
+        }
+        active->process(in, out, n);
+    }
+
+    void reset() override {
+        factor.reset(factor.target());
+        shifter.setPitchFactor(factor.target());
+        vocoder.setPitchFactor(factor.target());
+        shifter.reset();
+        vocoder.reset();
+    }
+
+    size_t latency() const override { return active->latency(); }
+
+private:
+    PitchShifter shifter;
+    PhaseVocoder vocoder;
+    DspStage* active;
+    SmoothedValue factor;
+};
+
+#endif // PITCHSTAGE_H
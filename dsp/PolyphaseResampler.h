@@ -0,0 +1,278 @@
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "DspMath.h"
+#include "Simd.h"
+
+// Dot products for the resampler's FIR phases. Each variant sums in its
+// own order, so results agree to rounding, not bit for bit.
+typedef float (*DotProductKernel)(const float* a, const float* b, size_t n);
+
+inline float dotProductScalar(const float* a, const float* b, size_t n) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i)
+        s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+#if defined(DSP_HAVE_X86)
+// Four accumulators each: a phase is only ~120 taps, so the sum is bound
+// by add latency rather than by loads
+DSP_TARGET("sse2")
+inline float dotProductSse2(const float* a, const float* b, size_t n) {
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+    for (; i + 4 <= n; i += 4)
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+DSP_TARGET("avx2,fma")
+inline float dotProductAvx2(const float* a, const float* b, size_t n) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+    }
+    for (; i + 8 <= n; i += 8)
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+    __m256 sum8 = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum4);
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+#endif
+
+#if defined(DSP_HAVE_NEON)
+inline float dotProductNeon(const float* a, const float* b, size_t n) {
+    float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f), s2 = vdupq_n_f32(0.0f), s3 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = vmlaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+        s1 = vmlaq_f32(s1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        s2 = vmlaq_f32(s2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        s3 = vmlaq_f32(s3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    for (; i + 4 <= n; i += 4)
+        s0 = vmlaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(vaddq_f32(s0, s1), vaddq_f32(s2, s3)));
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+#endif
+
+// Kernel for `level`; levels that are not compiled in fall back to scalar.
+inline DotProductKernel dotProductKernel(SimdLevel level) {
+    switch (level) {
+#if defined(DSP_HAVE_X86)
+    case SimdLevel::Avx2: return dotProductAvx2;
+    case SimdLevel::Sse2: return dotProductSse2;
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon: return dotProductNeon;
+#endif
+    default: return dotProductScalar;
+    }
+}
+
+// Fixed-ratio sample rate converter between two device rates.
+//
+// The ratio out/in is reduced to L/M (44.1 -> 48 kHz is 160/147) and each
+// output sample is one phase of a windowed-sinc low-pass designed at L
+// times the input rate: a dot product of the newest input frames with
+// that phase's precomputed taps. The filter passes up to 0.45 of the lower
+// rate, is down `StopbandDb` at its Nyquist frequency, and has as many
+// taps per phase as that takes (128 for 44.1 <-> 48 kHz). Rates
+// whose reduced L would need more than MaxPhases tables get the nearest
+// ratio that does not, a few ppm off, which a drift compensator
+// downstream absorbs like any other clock error.
+//
+// configure() allocates; process() does not, and takes any number of
+// input frames, so it can run in an audio callback.
+class PolyphaseResampler {
+public:
+    static constexpr int MaxPhases = 512;
+    static constexpr size_t Block = 256; // Input frames buffered per pass
+    static constexpr double StopbandDb = 90.0;
+    static constexpr double MaxRatio = 8.0;
+
+    explicit PolyphaseResampler(DotProductKernel kernel = dotProductKernel(detectSimdLevel()))
+        : dot(kernel), up(1), down(1), taps(0), phase(0), index(0), fill(0) {}
+
+    // Designs the filter for `inRate` -> `outRate`; false unless both are
+    // positive and within MaxRatio of each other
+    bool configure(int inRate, int outRate) {
+        if (inRate <= 0 || outRate <= 0 || outRate > inRate * MaxRatio || inRate > outRate * MaxRatio)
+            return false;
+        inputRate = inRate;
+        outputRate = outRate;
+        reduceRatio(outRate, inRate);
+
+        // Kaiser design at the upsampled rate; the transition runs from
+        // 0.45 to 0.5 of the lower rate and the cutoff sits in its middle
+        const double lower = std::min(inRate, outRate);
+        const double upsampled = static_cast<double>(up) * inRate;
+        const double transition = 0.05 * lower / upsampled;
+        const double length = (StopbandDb - 7.95) / (2.285 * 2.0 * PI * transition);
+        taps = (static_cast<size_t>(std::ceil(length / up)) + 15) & ~size_t(15);
+        const double cutoff = 0.475 * lower / upsampled;
+        const double beta = 0.1102 * (StopbandDb - 8.7);
+        const size_t total = taps * static_cast<size_t>(up);
+        const double centre = (total - 1) / 2.0;
+
+        // Phase p holds h[p + jL] reversed, so it lines up with the input
+        // history oldest first
+        coefficients.assign(total, 0.0f);
+        for (size_t k = 0; k < total; ++k) {
+            double x = (k - centre);
+            double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * PI * cutoff * x) / (2.0 * PI * cutoff * x);
+            double r = x / (centre + 1.0);
+            double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+            double h = 2.0 * cutoff * sinc * window * up;
+            size_t p = k % up, j = k / up;
+            coefficients[p * taps + (taps - 1 - j)] = static_cast<float>(h);
+        }
+        line.assign(taps - 1 + Block, 0.0f);
+        reset();
+        return true;
+    }
+
+    // Clears the history; the next output starts from silence
+    void reset() {
+        std::fill(line.begin(), line.end(), 0.0f);
+        fill = taps ? taps - 1 : 0;
+        index = 0;
+        phase = 0;
+    }
+
+    // Converts `frames` input frames, returning how many frames it wrote
+    // to `out`, at most maxOutput(frames)
+    size_t process(const float* in, size_t frames, float* out) {
+        size_t produced = 0;
+        while (frames > 0) {
+            size_t n = std::min(Block, frames);
+            std::memcpy(line.data() + fill, in, n * sizeof(float));
+            fill += n;
+            in += n;
+            frames -= n;
+
+            while (index + taps <= fill) {
+                out[produced++] = dot(coefficients.data() + static_cast<size_t>(phase) * taps, line.data() + index,
+                                      taps);
+                phase += down;
+                index += static_cast<size_t>(phase / up);
+                phase %= up;
+            }
+
+            // Keep the frames the next window still needs
+            size_t consumed = std::min(index, fill);
+            std::memmove(line.data(), line.data() + consumed, (fill - consumed) * sizeof(float));
+            fill -= consumed;
+            index -= consumed;
+        }
+        return produced;
+    }
+
+    // Most frames process() can write for `frames` of input
+    size_t maxOutput(size_t frames) const {
+        return frames * static_cast<size_t>(up) / static_cast<size_t>(down) + 2;
+    }
+
+    // Most input frames whose output is sure to fit in `frames`
+    size_t maxInput(size_t frames) const {
+        return frames > 2 ? (frames - 2) * static_cast<size_t>(down) / static_cast<size_t>(up) : 0;
+    }
+
+    // Group delay in output frames
+    double latency() const {
+        return (static_cast<double>(taps) * up - 1.0) / (2.0 * down);
+    }
+
+    // The exact ratio in use, out/in; may differ from the rates' by a few ppm
+    double ratio() const { return static_cast<double>(up) / down; }
+
+    int inRate() const { return inputRate; }
+    int outRate() const { return outputRate; }
+    int phases() const { return up; }
+    size_t tapsPerPhase() const { return taps; }
+
+private:
+    // out/in as L/M in lowest terms, or the closest continued-fraction
+    // convergent whose L fits MaxPhases
+    void reduceRatio(int outRate, int inRate) {
+        long long p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+        long long a = outRate, b = inRate;
+        while (b != 0) {
+            long long term = a / b;
+            long long p2 = term * p1 + p0, q2 = term * q1 + q0;
+            if (p2 > MaxPhases)
+                break;
+            p0 = p1; q0 = q1;
+            p1 = p2; q1 = q2;
+            long long rest = a - term * b;
+            a = b;
+            b = rest;
+        }
+        up = static_cast<int>(p1);
+        down = static_cast<int>(q1);
+    }
+
+    // Modified Bessel function of the first kind, order 0, for the window
+    static double besselI0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 64 && term > 1e-12 * sum; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    DotProductKernel dot;
+    int inputRate = 0;
+    int outputRate = 0;
+    int up;          // L
+    int down;        // M
+    size_t taps;     // Per phase, a multiple of 16
+    int phase;       // Of the next output, in [0, L)
+    size_t index;    // Oldest line frame of the next output's window
+    size_t fill;     // Valid frames in the line
+    std::vector<float> coefficients; // L phases of `taps`
+    std::vector<float> line;         // Input history, then the current block
+};
+
+#endif // POLYPHASERESAMPLER_H
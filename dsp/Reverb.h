@@ -0,0 +1,106 @@
+#ifndef REVERB_H
+#define REVERB_H
+
+#include <cstddef>
+
+#include "DelayLine.h"
+#include "DspStage.h"
+
+// Mono Schroeder/Moorer reverb in the Freeverb layout: four damped
+// feedback combs in parallel followed by two allpass diffusers. Delay
+// lengths are the Freeverb tunings scaled from 44.1 kHz to the stream
+// rate. `roomSize` (0..1) sets the comb feedback, `damping` (0..1) the
+// high-frequency loss per pass, and `mix` the wet/dry balance.
+class Reverb : public DspStage {
+public:
+    Reverb(double sampleRate, double roomSize = 0.5, double damping = 0.5, double mix = 0.25)
+        : combs{ Comb(scaled(1116, sampleRate)), Comb(scaled(1188, sampleRate)),
+                 Comb(scaled(1277, sampleRate)), Comb(scaled(1356, sampleRate)) },
+          allpasses{ Allpass(scaled(556, sampleRate)), Allpass(scaled(441, sampleRate)) }
+    {
+        setRoomSize(roomSize);
+        setDamping(damping);
+        setMix(mix);
+    }
+
+    void setRoomSize(double size) { feedback = static_cast<float>(0.7 + 0.28 * clamp01(size)); }
+    void setDamping(double amount) { damp = static_cast<float>(0.4 * clamp01(amount)); }
+
+    void setMix(double amount) {
+        wet = static_cast<float>(clamp01(amount));
+        dry = 1.0f - wet;
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        for (size_t i = 0; i < n; ++i) {
+            float input = in[i] * InputGain;
+            float sum = 0.0f;
+            for (Comb& comb : combs)
+                sum += comb.process(input, feedback, damp);
+            for (Allpass& allpass : allpasses)
+                sum = allpass.process(sum);
+            out[i] = dry * in[i] + wet * sum;
+        }
+    }
+
+    void reset() override {
+        for (Comb& comb : combs)
+            comb.clear();
+        for (Allpass& allpass : allpasses)
+            allpass.clear();
+    }
+
+private:
+    static constexpr float InputGain = 0.06f;
+
+    struct Comb {
+        explicit Comb(size_t length) : line(length), length(length), filtered(0.0f) {}
+
+        float process(float input, float feedback, float damp) {
+            float output = line.read(length - 1);
+            filtered = output * (1.0f - damp) + filtered * damp;
+            line.write(input + filtered * feedback);
+            return output;
+        }
+
+        void clear() {
+            line.clear();
+            filtered = 0.0f;
+        }
+
+        DelayLine<float> line;
+        size_t length;
+        float filtered;
+    };
+
+    struct Allpass {
+        explicit Allpass(size_t length) : line(length), length(length) {}
+
+        float process(float input) {
+            float delayed = line.read(length - 1);
+            line.write(input + delayed * 0.5f);
+            return delayed - input;
+        }
+
+        void clear() { line.clear(); }
+
+        DelayLine<float> line;
+        size_t length;
+    };
+
+    static size_t scaled(size_t length44k, double sampleRate) {
+        size_t length = static_cast<size_t>(length44k * sampleRate / 44100.0 + 0.5);
+        return length < 1 ? 1 : length;
+    }
+
+    static double clamp01(double x) { return x < 0.0 ? 0.0 : x > 1.0 ? 1.0 : x; }
+
+    Comb combs[4];
+    Allpass allpasses[2];
+    float feedback;
+    float damp;
+    float wet;
+    float dry;
+};
+
+#endif // REVERB_H
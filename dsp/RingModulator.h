@@ -0,0 +1,64 @@
+#ifndef RINGMODULATOR_H
+#define RINGMODULATOR_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "DspMath.h"
+#include "DspStage.h"
+
+// Ring modulator: multiplies the input by a sine carrier.
+//
+// Low carriers (20-60 Hz) give the buzzing, metallic edge of a voice
+// through a mask; higher ones turn speech robotic. The carrier is a
+// rotating phasor, one complex multiply per sample, renormalized once per
+// block so it neither decays nor grows. `mix` blends with the dry input.
+class RingModulator : public DspStage {
+public:
+    RingModulator(double frequency, double mix, double sampleRate)
+        : rate(sampleRate), re(1.0f), im(0.0f)
+    {
+        setFrequency(frequency);
+        setMix(mix);
+    }
+
+    void setFrequency(double frequency) {
+        double w = 2.0 * PI * frequency / rate;
+        stepRe = static_cast<float>(std::cos(w));
+        stepIm = static_cast<float>(std::sin(w));
+    }
+
+    void setMix(double amount) {
+        wet = static_cast<float>(amount < 0.0 ? 0.0 : amount > 1.0 ? 1.0 : amount);
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        const float cr = stepRe, ci = stepIm, w = wet, dry = 1.0f - wet;
+        float r = re, m = im;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = in[i] * (dry + w * m);
+            float next = r * cr - m * ci;
+            m = r * ci + m * cr;
+            r = next;
+        }
+        // First-order correction back onto the unit circle
+        float scale = 0.5f * (3.0f - (r * r + m * m));
+        re = r * scale;
+        im = m * scale;
+    }
+
+    void reset() override {
+        re = 1.0f;
+        im = 0.0f;
+    }
+
+private:
+    double rate;
+    float stepRe;
+    float stepIm;
+    float wet;
+    float re;
+    float im;
+};
+
+#endif // RINGMODULATOR_H
@@ -0,0 +1,173 @@
+#ifndef SAMPLECONVERT_H
+#define SAMPLECONVERT_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Simd.h"
+
+// int16 <-> float32 conversion for the edges of the processing chain.
+//
+// Floats are full scale at +-1.0 (int16 / 32768). The float -> int16
+// direction rounds to nearest and saturates, so clipped DSP output pins
+// at +-full scale instead of wrapping, and NaN becomes silence. The SIMD
+// variants match the scalar one bit for bit (32-bit ARM rounds exact .5
+// ties away from zero); sampleConverter() picks one per SimdLevel.
+typedef void (*Int16ToFloatKernel)(const int16_t* in, float* out, size_t n);
+typedef void (*FloatToInt16Kernel)(const float* in, int16_t* out, size_t n);
+
+struct SampleConverter {
+    Int16ToFloatKernel toFloat;
+    FloatToInt16Kernel toInt16;
+    SimdLevel level;
+};
+
+inline int16_t floatToInt16Sample(float sample) {
+    float scaled = sample * 32768.0f;
+    if (!(scaled < 32767.0f))
+        return scaled != scaled ? 0 : 32767; // NaN maps to silence
+    if (scaled < -32768.0f)
+        return -32768;
+    // Round to nearest even, as cvtps does in the default rounding mode
+    return static_cast<int16_t>(std::lrint(scaled));
+}
+
+inline void int16ToFloatScalar(const int16_t* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = in[i] * (1.0f / 32768.0f);
+}
+
+inline void floatToInt16Scalar(const float* in, int16_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = floatToInt16Sample(in[i]);
+}
+
+#if defined(DSP_HAVE_X86)
+DSP_TARGET("sse2")
+inline void int16ToFloatSse2(const int16_t* in, float* out, size_t n) {
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    int16ToFloatScalar(in + i, out + i, n - i);
+}
+
+DSP_TARGET("sse2")
+inline void floatToInt16Sse2(const float* in, int16_t* out, size_t n) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 upper = _mm_set1_ps(32767.0f);
+    const __m128 lower = _mm_set1_ps(-32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // max/min return the second operand for NaN, which clamps it to a rail;
+        // zero NaNs first so they come out silent like the scalar path.
+        __m128 a = _mm_loadu_ps(in + i);
+        __m128 b = _mm_loadu_ps(in + i + 4);
+        a = _mm_and_ps(a, _mm_cmpord_ps(a, a));
+        b = _mm_and_ps(b, _mm_cmpord_ps(b, b));
+        a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(a, scale), lower), upper);
+        b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(b, scale), lower), upper);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    floatToInt16Scalar(in + i, out + i, n - i);
+}
+
+DSP_TARGET("avx2")
+inline void int16ToFloatAvx2(const int16_t* in, float* out, size_t n) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), scale));
+    }
+    int16ToFloatScalar(in + i, out + i, n - i);
+}
+
+DSP_TARGET("avx2")
+inline void floatToInt16Avx2(const float* in, int16_t* out, size_t n) {
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    const __m256 upper = _mm256_set1_ps(32767.0f);
+    const __m256 lower = _mm256_set1_ps(-32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_loadu_ps(in + i);
+        __m256 b = _mm256_loadu_ps(in + i + 8);
+        a = _mm256_and_ps(a, _mm256_cmp_ps(a, a, _CMP_ORD_Q));
+        b = _mm256_and_ps(b, _mm256_cmp_ps(b, b, _CMP_ORD_Q));
+        a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(a, scale), lower), upper);
+        b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(b, scale), lower), upper);
+        // packs works per 128-bit lane; restore sample order afterwards
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    floatToInt16Scalar(in + i, out + i, n - i);
+}
+#endif
+
+#if defined(DSP_HAVE_NEON)
+inline void int16ToFloatNeon(const int16_t* in, float* out, size_t n) {
+    const float32x4_t scale = vdupq_n_f32(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    int16ToFloatScalar(in + i, out + i, n - i);
+}
+
+inline void floatToInt16Neon(const float* in, int16_t* out, size_t n) {
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vmulq_f32(vld1q_f32(in + i), scale);
+        float32x4_t b = vmulq_f32(vld1q_f32(in + i + 4), scale);
+#if defined(__aarch64__)
+        // Conversion saturates to int32 and maps NaN to 0; narrowing saturates to int16
+        int32x4_t ia = vcvtnq_s32_f32(a);
+        int32x4_t ib = vcvtnq_s32_f32(b);
+#else
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        const uint32x4_t sign = vdupq_n_u32(0x80000000u);
+        int32x4_t ia = vcvtq_s32_f32(vaddq_f32(a, vreinterpretq_f32_u32(
+            vorrq_u32(vandq_u32(vreinterpretq_u32_f32(a), sign), vreinterpretq_u32_f32(half)))));
+        int32x4_t ib = vcvtq_s32_f32(vaddq_f32(b, vreinterpretq_f32_u32(
+            vorrq_u32(vandq_u32(vreinterpretq_u32_f32(b), sign), vreinterpretq_u32_f32(half)))));
+#endif
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)));
+    }
+    floatToInt16Scalar(in + i, out + i, n - i);
+}
+#endif
+
+// Kernel pair for `level`; levels that are not compiled in fall back to scalar.
+inline SampleConverter sampleConverter(SimdLevel level) {
+    switch (level) {
+#if defined(DSP_HAVE_X86)
+    case SimdLevel::Avx2: return { int16ToFloatAvx2, floatToInt16Avx2, level };
+    case SimdLevel::Sse2: return { int16ToFloatSse2, floatToInt16Sse2, level };
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon: return { int16ToFloatNeon, floatToInt16Neon, level };
+#endif
+    default: return { int16ToFloatScalar, floatToInt16Scalar, SimdLevel::Scalar };
+    }
+}
+
+// Best converter for this machine, chosen on first use.
+inline const SampleConverter& defaultSampleConverter() {
+    static const SampleConverter converter = sampleConverter(detectSimdLevel());
+    return converter;
+}
+
+#endif // SAMPLECONVERT_H
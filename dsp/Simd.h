@@ -0,0 +1,92 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Instruction-set detection shared by the vectorized DSP kernels.
+//
+// Kernels for wider instruction sets are compiled with per-function
+// target attributes so the rest of the build keeps its baseline flags;
+// the best supported variant is picked once at runtime.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DSP_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DSP_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DSP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DSP_TARGET(isa)
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon
+};
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Sse2: return "sse2";
+    case SimdLevel::Avx2: return "avx2";
+    case SimdLevel::Neon: return "neon";
+    default: return "scalar";
+    }
+}
+
+// Whether `level` can run on this machine.
+inline bool simdLevelSupported(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return true;
+#if defined(DSP_HAVE_X86)
+#if defined(__GNUC__) || defined(__clang__)
+    case SimdLevel::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case SimdLevel::Avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+    case SimdLevel::Sse2:
+        return true;
+    case SimdLevel::Avx2: {
+        int info[4];
+        __cpuidex(info, 1, 0);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool fma = (info[2] & (1 << 12)) != 0;
+        if (!osxsave || !fma || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#endif
+#endif
+#if defined(DSP_HAVE_NEON)
+    case SimdLevel::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Widest instruction set available at runtime.
+inline SimdLevel detectSimdLevel() {
+    if (simdLevelSupported(SimdLevel::Avx2))
+        return SimdLevel::Avx2;
+    if (simdLevelSupported(SimdLevel::Sse2))
+        return SimdLevel::Sse2;
+    if (simdLevelSupported(SimdLevel::Neon))
+        return SimdLevel::Neon;
+    return SimdLevel::Scalar;
+}
+
+#endif // SIMD_H
@@ -0,0 +1,54 @@
+#ifndef SMOOTHEDVALUE_H
+#define SMOOTHEDVALUE_H
+
+#include <cmath>
+#include <cstddef>
+
+// Parameter that glides to new targets instead of jumping.
+//
+// Stages call advance() once per block: the value moves towards the
+// target by a one-pole step sized for the block length (so the glide time
+// does not depend on the block size), and the start and end values let
+// the stage ramp linearly across the block. Once within `epsilon` of the
+// target it snaps there and reports itself settled, so stages can skip
+// the ramp entirely in the steady state.
+class SmoothedValue {
+public:
+    explicit SmoothedValue(double value = 0.0, double timeConstantSeconds = 0.05,
+                           double sampleRate = 44100.0, double epsilon = 1e-6)
+        : current(value), goal(value), tolerance(epsilon), samplesPerTau(1.0)
+    {
+        setTimeConstant(timeConstantSeconds, sampleRate);
+    }
+
+    void setTimeConstant(double seconds, double sampleRate) {
+        samplesPerTau = seconds * sampleRate > 1.0 ? seconds * sampleRate : 1.0;
+    }
+
+    void setTarget(double value) { goal = value; }
+
+    // Jumps straight to `value`
+    void reset(double value) { current = goal = value; }
+
+    double target() const { return goal; }
+    double value() const { return current; }
+    bool settled() const { return current == goal; }
+
+    // Moves on by `n` samples and returns the value at the end of them
+    double advance(size_t n) {
+        if (current == goal)
+            return current;
+        current += (goal - current) * (1.0 - std::exp(-static_cast<double>(n) / samplesPerTau));
+        if (std::fabs(goal - current) <= tolerance * (std::fabs(goal) > 1.0 ? std::fabs(goal) : 1.0))
+            current = goal;
+        return current;
+    }
+
+private:
+    double current;
+    double goal;
+    double tolerance;
+    double samplesPerTau;
+};
+
+#endif // SMOOTHEDVALUE_H
@@ -0,0 +1,136 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "DspMath.h"
+
+// Lock-free single-producer/single-consumer ring buffer.
+//
+// Capacity is rounded up to a power of two so wrapping is a mask. The
+// read and write indices grow monotonically and live on their own cache
+// lines; each side also keeps a cached copy of the other side's index so
+// the shared line is only touched when the cached view runs out.
+// write() may only be called from one thread and read() from one other
+// thread. All storage is allocated up front in the constructor.
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRingBuffer elements are copied with memcpy");
+
+public:
+    static constexpr size_t CacheLineSize = 64;
+
+    explicit SpscRingBuffer(size_t minCapacity)
+        : size(nextPowerOfTwo(minCapacity)), mask(size - 1),
+          storage(new T[size])
+    {
+        writeIndex.store(0, std::memory_order_relaxed);
+        readIndex.store(0, std::memory_order_relaxed);
+        producer.cachedRead = 0;
+        consumer.cachedWrite = 0;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const { return size; }
+
+    // Producer side: copies up to count elements in, returns how many fit.
+    size_t write(const T* data, size_t count) {
+        const size_t w = writeIndex.load(std::memory_order_relaxed);
+        size_t free = size - (w - producer.cachedRead);
+        if (free < count) {
+            producer.cachedRead = readIndex.load(std::memory_order_acquire);
+            free = size - (w - producer.cachedRead);
+        }
+        if (count > free)
+            count = free;
+        if (count == 0)
+            return 0;
+
+        const size_t start = w & mask;
+        const size_t first = count < size - start ? count : size - start;
+        std::memcpy(storage.get() + start, data, first * sizeof(T));
+        std::memcpy(storage.get(), data + first, (count - first) * sizeof(T));
+
+        writeIndex.store(w + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: copies up to count elements out, returns how many were read.
+    size_t read(T* data, size_t count) {
+        const size_t r = readIndex.load(std::memory_order_relaxed);
+        size_t used = consumer.cachedWrite - r;
+        if (used < count) {
+            consumer.cachedWrite = writeIndex.load(std::memory_order_acquire);
+            used = consumer.cachedWrite - r;
+        }
+        if (count > used)
+            count = used;
+        if (count == 0)
+            return 0;
+
+        const size_t start = r & mask;
+        const size_t first = count < size - start ? count : size - start;
+        std::memcpy(data, storage.get() + start, first * sizeof(T));
+        std::memcpy(data + first, storage.get(), (count - first) * sizeof(T));
+
+        readIndex.store(r + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: drops up to count of the oldest elements without copying.
+    size_t discard(size_t count) {
+        const size_t r = readIndex.load(std::memory_order_relaxed);
+        consumer.cachedWrite = writeIndex.load(std::memory_order_acquire);
+        const size_t used = consumer.cachedWrite - r;
+        if (count > used)
+            count = used;
+        readIndex.store(r + count, std::memory_order_release);
+        return count;
+    }
+
+    // Snapshot of the fill level, from any thread. The read index is loaded
+    // first: the consumer only publishes an index the producer had already
+    // reached, so the write index seen after it is never behind it. Both
+    // sides may move between the two loads, so from a third thread the
+    // value can be off by what moved since, but it always lies within
+    // 0..capacity().
+    size_t availableToRead() const {
+        const size_t r = readIndex.load(std::memory_order_acquire);
+        const size_t used = writeIndex.load(std::memory_order_acquire) - r;
+        return used < size ? used : size;
+    }
+
+    size_t availableToWrite() const {
+        return size - availableToRead();
+    }
+
+    // Discards all contents. Only valid while neither side is running.
+    void reset() {
+        writeIndex.store(0, std::memory_order_relaxed);
+        readIndex.store(0, std::memory_order_relaxed);
+        producer.cachedRead = 0;
+        consumer.cachedWrite = 0;
+    }
+
+private:
+    struct alignas(CacheLineSize) ProducerState { size_t cachedRead; };
+    struct alignas(CacheLineSize) ConsumerState { size_t cachedWrite; };
+
+    const size_t size;
+    const size_t mask;
+    std::unique_ptr<T[]> storage;
+
+    alignas(CacheLineSize) std::atomic<size_t> writeIndex;
+    alignas(CacheLineSize) std::atomic<size_t> readIndex;
+    ProducerState producer;
+    ConsumerState consumer;
+};
+
+#endif // SPSCRINGBUFFER_H
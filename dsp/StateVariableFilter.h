@@ -0,0 +1,114 @@
+#ifndef STATEVARIABLEFILTER_H
+#define STATEVARIABLEFILTER_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "Biquad.h"
+#include "DspMath.h"
+#include "DspStage.h"
+#include "SmoothedValue.h"
+
+// Trapezoidal (zero-delay feedback) state-variable filter after Andrew
+// Simper's "Linear Trap Integrated SVF".
+//
+// It has the same magnitude responses as the biquad designs of the same
+// BiquadType, but its state is two integrator voltages rather than
+// transposed-form partial sums, so the cutoff can move every block (or
+// every sample) without the bursts a modulated biquad produces. The
+// cutoff glides like LowPassFilter's: the coefficients are recomputed
+// once per block towards a one-pole target while it moves.
+class StateVariableFilter : public DspStage {
+public:
+    StateVariableFilter(BiquadType type, double cutoffFrequency, double q, double sampleRate,
+                        double gainDb = 0.0)
+        : type(type), rate(sampleRate), quality(q), gain(gainDb),
+          cutoff(cutoffFrequency, 0.05, sampleRate), ic1eq(0.0f), ic2eq(0.0f)
+    {
+        updateCoefficients(cutoffFrequency);
+    }
+
+    void setCutoff(double cutoffFrequency) { cutoff.setTarget(cutoffFrequency); }
+    double cutoffFrequency() const { return cutoff.target(); }
+
+    // Takes effect immediately
+    void setResponse(BiquadType newType, double q, double gainDb = 0.0) {
+        type = newType;
+        quality = q;
+        gain = gainDb;
+        updateCoefficients(cutoff.value());
+    }
+
+    float processSample(float v0) {
+        float v3 = v0 - ic2eq;
+        float v1 = a1 * ic1eq + a2 * v3;
+        float v2 = ic2eq + a2 * ic1eq + a3 * v3;
+        ic1eq = 2.0f * v1 - ic1eq;
+        ic2eq = 2.0f * v2 - ic2eq;
+        return m0 * v0 + m1 * v1 + m2 * v2;
+    }
+
+    void process(const float* in, float* out, size_t n) override {
+        if (!cutoff.settled())
+            updateCoefficients(cutoff.advance(n));
+        for (size_t i = 0; i < n; ++i)
+            out[i] = processSample(in[i]);
+    }
+
+    void reset() override {
+        ic1eq = ic2eq = 0.0f;
+        cutoff.reset(cutoff.target());
+        updateCoefficients(cutoff.target());
+    }
+
+private:
+    void updateCoefficients(double frequency) {
+        double nyquist = rate * 0.5;
+        frequency = frequency < 1.0 ? 1.0 : (frequency > nyquist * 0.999 ? nyquist * 0.999 : frequency);
+        double q = quality < 0.01 ? 0.01 : quality;
+        double A = std::pow(10.0, gain / 40.0);
+        double g = std::tan(PI * frequency / rate);
+        double k = 1.0 / q;
+        double c0 = 0.0, c1 = 0.0, c2 = 0.0;
+
+        switch (type) {
+        case BiquadType::LowPass:   c2 = 1.0; break;
+        case BiquadType::HighPass:  c0 = 1.0; c1 = -k; c2 = -1.0; break;
+        case BiquadType::BandPass:  c1 = k; break;
+        case BiquadType::Notch:     c0 = 1.0; c1 = -k; break;
+        case BiquadType::AllPass:   c0 = 1.0; c1 = -2.0 * k; break;
+        case BiquadType::Peaking:
+            k = 1.0 / (q * A);
+            c0 = 1.0; c1 = k * (A * A - 1.0);
+            break;
+        case BiquadType::LowShelf:
+            g /= std::sqrt(A);
+            c0 = 1.0; c1 = k * (A - 1.0); c2 = A * A - 1.0;
+            break;
+        case BiquadType::HighShelf:
+            g *= std::sqrt(A);
+            c0 = A * A; c1 = k * (1.0 - A) * A; c2 = 1.0 - A * A;
+            break;
+        }
+
+        double d1 = 1.0 / (1.0 + g * (g + k));
+        a1 = static_cast<float>(d1);
+        a2 = static_cast<float>(g * d1);
+        a3 = static_cast<float>(g * g * d1);
+        m0 = static_cast<float>(c0);
+        m1 = static_cast<float>(c1);
+        m2 = static_cast<float>(c2);
+    }
+
+    BiquadType type;
+    double rate;
+    double quality;
+    double gain;
+    SmoothedValue cutoff;
+    float a1, a2, a3;
+    float m0, m1, m2;
+    float ic1eq;
+    float ic2eq;
+};
+
+#endif // STATEVARIABLEFILTER_H
@@ -0,0 +1,58 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free latest-value handoff from one writer thread to one reader.
+//
+// Three copies of T: the writer fills its private slot and publishes it
+// by swapping it with the shared slot; the reader swaps the shared slot
+// with its own whenever a new one has been published. Neither side ever
+// waits, the reader always sees a complete snapshot, and intermediate
+// values the reader was too slow to see are simply skipped.
+template <typename T>
+class TripleBuffer {
+public:
+    explicit TripleBuffer(const T& initial = T())
+        : copies{ initial, initial, initial }, shared(1), writeIndex(0), readIndex(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side
+    void write(const T& value) {
+        copies[writeIndex] = value;
+        int previous = shared.exchange(writeIndex | Fresh, std::memory_order_acq_rel);
+        writeIndex = previous & IndexMask;
+    }
+
+    // Reader side: picks up the newest published value, if any, and
+    // returns true when it changed
+    bool update() {
+        if (!(shared.load(std::memory_order_relaxed) & Fresh))
+            return false;
+        int previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & IndexMask;
+        return true;
+    }
+
+    // Reader side: the snapshot picked up by the last update()
+    const T& latest() const { return copies[readIndex]; }
+
+    // Reader side: update() then latest()
+    const T& read() {
+        update();
+        return latest();
+    }
+
+private:
+    static const int IndexMask = 3;
+    static const int Fresh = 4;
+
+    T copies[3];
+    alignas(64) std::atomic<int> shared;
+    alignas(64) int writeIndex;
+    alignas(64) int readIndex;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,108 @@
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+
+// One side of a simulated audio device
+struct VirtualStream {
+    size_t periodFrames = 1024; // Frames per callback
+    double ppm = 0.0;           // Clock error against the nominal rate
+    double jitterMs = 0.0;      // Callbacks run up to this late, uniformly
+    double sampleRate = 0.0;    // Nominal rate; 0 for the clock's default
+};
+
+// Deterministic timeline of capture and playback callbacks.
+//
+// Each side ticks on its own crystal: a capture callback is due when a
+// period has been recorded, a playback callback when the device needs the
+// next period, both at the side's nominal rate scaled by its ppm error.
+// Each callback is then delayed by a pseudo-random scheduling lateness in
+// [0, jitterMs] from a seeded generator, never overtaking the previous
+// callback on the same side. The same settings and seed always give the
+// same sequence, so underruns seen in a simulation can be replayed
+// exactly. Times are seconds since start.
+class VirtualClock {
+public:
+    enum class Side {
+        Capture,
+        Playback
+    };
+
+    struct Callback {
+        double time;
+        double lateness; // Seconds after the callback was due
+        Side side;
+        size_t frames;
+    };
+
+    VirtualClock(double sampleRate, const VirtualStream& capture, const VirtualStream& playback,
+                 uint32_t seed = 1)
+        : initialSeed(seed ? seed : 1)
+    {
+        sides[0].stream = capture;
+        sides[1].stream = playback;
+        for (SideState& side : sides)
+            side.rate = side.stream.sampleRate > 0.0 ? side.stream.sampleRate : sampleRate;
+        reset();
+    }
+
+    void reset() {
+        seed = initialSeed;
+        for (int i = 0; i < 2; ++i) {
+            sides[i].count = 0;
+            sides[i].last = 0.0;
+            schedule(i);
+        }
+    }
+
+    // The next callback, without consuming it; ties go to capture
+    const Callback& peek() const {
+        return sides[1].pending.time < sides[0].pending.time ? sides[1].pending : sides[0].pending;
+    }
+
+    Callback next() {
+        int i = sides[1].pending.time < sides[0].pending.time ? 1 : 0;
+        Callback callback = sides[i].pending;
+        sides[i].last = callback.time;
+        ++sides[i].count;
+        schedule(i);
+        return callback;
+    }
+
+private:
+    struct SideState {
+        VirtualStream stream;
+        double rate;
+        uint64_t count;
+        double last;
+        Callback pending;
+    };
+
+    // Capture is due once its period is recorded, playback when it starts
+    void schedule(int i) {
+        SideState& s = sides[i];
+        const double period = s.stream.periodFrames / (s.rate * (1.0 + s.stream.ppm * 1e-6));
+        const double due = (i == 0 ? s.count + 1 : s.count) * period;
+        double lateness = s.stream.jitterMs * 1e-3 * uniform();
+        double time = due + lateness;
+        if (time < s.last)
+            time = s.last;
+        s.pending = Callback{ time, time - due, i == 0 ? Side::Capture : Side::Playback,
+                              s.stream.periodFrames };
+    }
+
+    // xorshift32 in [0, 1)
+    double uniform() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed * (1.0 / 4294967296.0);
+    }
+
+    uint32_t initialSeed;
+    uint32_t seed;
+    SideState sides[2];
+};
+
+#endif // VIRTUALCLOCK_H
@@ -0,0 +1,346 @@
+#ifndef WSOLA_H
+#define WSOLA_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Correlation.h"
+#include "SampleConvert.h"
+#include "Simd.h"
+
+// Interleaved float FIFO that compacts in place instead of reallocating.
+// Storage only grows when a single write exceeds everything reserved.
+class FrameFifo {
+public:
+    FrameFifo() : channels(1), head(0), tail(0) {}
+
+    void setChannels(int channelCount) {
+        channels = channelCount;
+        clear();
+    }
+
+    void reserve(size_t frameCount) {
+        if (storage.size() < frameCount * channels)
+            storage.resize(frameCount * channels);
+    }
+
+    size_t frames() const { return (tail - head) / channels; }
+    const float* begin() const { return storage.data() + head; }
+
+    // Returns room for at least frameCount frames past the current end.
+    float* prepare(size_t frameCount) {
+        size_t needed = frameCount * channels;
+        if (tail + needed > storage.size()) {
+            if (head > 0) {
+                std::memmove(storage.data(), storage.data() + head, (tail - head) * sizeof(float));
+                tail -= head;
+                head = 0;
+            }
+            if (tail + needed > storage.size())
+                storage.resize(std::max(storage.size() * 2, tail + needed));
+        }
+        return storage.data() + tail;
+    }
+
+    void commit(size_t frameCount) { tail += frameCount * channels; }
+
+    void consume(size_t frameCount) {
+        head += std::min(frameCount * channels, tail - head);
+        if (head == tail)
+            head = tail = 0;
+    }
+
+    void dropBack(size_t frameCount) {
+        tail -= std::min(frameCount * channels, tail - head);
+    }
+
+    void clear() { head = tail = 0; }
+
+private:
+    std::vector<float> storage;
+    size_t channels;
+    size_t head;
+    size_t tail;
+};
+
+// Waveform-similarity overlap-add (WSOLA) tempo and pitch changer.
+//
+// Mirrors the SoundTouch calls the qtst build used (setPitch, setTempo,
+// putSamples, receiveSamples, numSamples, flush) so it can stand in for
+// it. Tempo is changed by cutting the input into overlapping sequences
+// and splicing each one at the offset, within a seek window, whose start
+// best correlates with the tail of the previous sequence. Pitch is the
+// same stretch by 1/pitch followed by a linear-interpolation resample by
+// pitch. The correlation search runs on the widest SIMD kernel the CPU
+// supports. Buffers are sized in configure(); steady-state processing
+// does not allocate.
+class Wsola {
+public:
+    Wsola()
+        : sampleRate(44100), channels(1), tempo(1.0), pitch(1.0),
+          sequenceMs(40.0), seekWindowMs(15.0), overlapMs(8.0),
+          kernel(dotEnergyKernel(detectSimdLevel()))
+    {
+        configure();
+    }
+
+    void setSampleRate(int rate) {
+        sampleRate = rate;
+        configure();
+    }
+
+    void setChannels(int channelCount) {
+        channels = std::max(1, channelCount);
+        configure();
+    }
+
+    // Playback speed without changing pitch (1.0 = unchanged)
+    void setTempo(double newTempo) { tempo = newTempo; }
+
+    // Pitch ratio without changing tempo (1.0 = unchanged, 0.5 = octave down)
+    void setPitch(double newPitch) { pitch = newPitch; }
+
+    // WSOLA timing in milliseconds; larger sequences suit lower voices
+    void setParameters(double sequence, double seekWindow, double overlap) {
+        sequenceMs = sequence;
+        seekWindowMs = seekWindow;
+        overlapMs = overlap;
+        configure();
+    }
+
+    void setSimdLevel(SimdLevel level) { kernel = dotEnergyKernel(level); }
+
+    void putSamples(const float* samples, size_t frameCount) {
+        float* dst = input.prepare(frameCount);
+        std::memcpy(dst, samples, frameCount * channels * sizeof(float));
+        input.commit(frameCount);
+        expectedOutput += frameCount / tempo;
+        process();
+    }
+
+    void putSamples(const int16_t* samples, size_t frameCount) {
+        defaultSampleConverter().toFloat(samples, input.prepare(frameCount), frameCount * channels);
+        input.commit(frameCount);
+        expectedOutput += frameCount / tempo;
+        process();
+    }
+
+    size_t receiveSamples(float* out, size_t maxFrames) {
+        size_t count = std::min(maxFrames, output.frames());
+        std::memcpy(out, output.begin(), count * channels * sizeof(float));
+        output.consume(count);
+        return count;
+    }
+
+    size_t receiveSamples(int16_t* out, size_t maxFrames) {
+        size_t count = std::min(maxFrames, output.frames());
+        defaultSampleConverter().toInt16(output.begin(), out, count * channels);
+        output.consume(count);
+        return count;
+    }
+
+    // Frames ready to be received
+    size_t numSamples() const { return output.frames(); }
+
+    // Frames put but not yet turned into output
+    size_t numUnprocessedSamples() const { return input.frames() + stretched.frames(); }
+
+    // Pushes the remaining input through with silence, then trims the
+    // output to the length the input implies.
+    void flush() {
+        const float silence[256 * 8] = {};
+        size_t guard = 0;
+        while (produced < expectedOutput && guard++ < 64) {
+            double expected = expectedOutput;
+            size_t frames = std::min<size_t>(256, sizeof(silence) / sizeof(float) / channels);
+            putSamples(silence, frames);
+            expectedOutput = expected;
+        }
+        size_t excess = produced > expectedOutput
+            ? static_cast<size_t>(produced - expectedOutput) : 0;
+        output.dropBack(excess);
+        resetState();
+    }
+
+    void clear() {
+        output.clear();
+        resetState();
+    }
+
+private:
+    void configure() {
+        sequenceFrames = std::max<size_t>(32, static_cast<size_t>(sequenceMs * 0.001 * sampleRate));
+        overlapFrames = std::max<size_t>(8, static_cast<size_t>(overlapMs * 0.001 * sampleRate));
+        overlapFrames = std::min(overlapFrames, sequenceFrames / 2);
+        seekFrames = std::max<size_t>(1, static_cast<size_t>(seekWindowMs * 0.001 * sampleRate));
+
+        input.setChannels(channels);
+        stretched.setChannels(channels);
+        output.setChannels(channels);
+        size_t reserveFrames = 4 * (sequenceFrames + seekFrames) + sampleRate / 2;
+        input.reserve(reserveFrames);
+        stretched.reserve(reserveFrames);
+        output.reserve(2 * reserveFrames);
+
+        midBuffer.assign(overlapFrames * channels, 0.0f);
+        reference.assign(overlapFrames * channels, 0.0f);
+        slope.resize(overlapFrames);
+        for (size_t i = 0; i < overlapFrames; ++i)
+            slope[i] = static_cast<float>(i * (overlapFrames - i)) / (overlapFrames * overlapFrames);
+
+        resetState();
+    }
+
+    void resetState() {
+        input.clear();
+        stretched.clear();
+        primed = false;
+        skipFraction = 0.0;
+        position = 0.0;
+        expectedOutput = 0.0;
+        produced = 0.0;
+    }
+
+    void process() {
+        stretch();
+        transpose();
+    }
+
+    // Tempo change by 1/pitch * tempo, input -> stretched
+    void stretch() {
+        const double stretchTempo = tempo / pitch;
+        if (std::fabs(stretchTempo - 1.0) < 1e-9 && !primed) {
+            size_t count = input.frames();
+            std::memcpy(stretched.prepare(count), input.begin(), count * channels * sizeof(float));
+            stretched.commit(count);
+            input.consume(count);
+            return;
+        }
+
+        const double nominalSkip = stretchTempo * (sequenceFrames - overlapFrames);
+        const size_t required = std::max(seekFrames + sequenceFrames,
+                                         static_cast<size_t>(nominalSkip) + 1);
+        const size_t bodyFrames = sequenceFrames - 2 * overlapFrames;
+        const size_t c = channels;
+
+        while (input.frames() >= required) {
+            const float* in = input.begin();
+            size_t offset = primed ? seekBestOverlap(in) : 0;
+            const float* segment = in + offset * c;
+
+            float* out = stretched.prepare(sequenceFrames - overlapFrames);
+            if (primed) {
+                for (size_t i = 0; i < overlapFrames; ++i) {
+                    float w = static_cast<float>(i) / overlapFrames;
+                    for (size_t ch = 0; ch < c; ++ch) {
+                        size_t k = i * c + ch;
+                        out[k] = midBuffer[k] + w * (segment[k] - midBuffer[k]);
+                    }
+                }
+            } else {
+                std::memcpy(out, segment, overlapFrames * c * sizeof(float));
+            }
+            std::memcpy(out + overlapFrames * c, segment + overlapFrames * c,
+                        bodyFrames * c * sizeof(float));
+            stretched.commit(sequenceFrames - overlapFrames);
+
+            std::memcpy(midBuffer.data(), segment + (sequenceFrames - overlapFrames) * c,
+                        overlapFrames * c * sizeof(float));
+            primed = true;
+
+            skipFraction += nominalSkip;
+            size_t skip = static_cast<size_t>(skipFraction);
+            skipFraction -= skip;
+            input.consume(skip);
+        }
+    }
+
+    // Offset within the seek window whose start best matches midBuffer
+    size_t seekBestOverlap(const float* in) {
+        const size_t c = channels;
+        for (size_t i = 0; i < overlapFrames; ++i) {
+            for (size_t ch = 0; ch < c; ++ch)
+                reference[i * c + ch] = midBuffer[i * c + ch] * slope[i];
+        }
+
+        size_t best = 0;
+        float bestScore = -1e30f;
+        const size_t length = overlapFrames * c;
+        for (size_t offset = 0; offset < seekFrames; ++offset) {
+            float dot, energy;
+            kernel(reference.data(), in + offset * c, length, &dot, &energy);
+            float score = dot / std::sqrt(energy + 1e-9f);
+            if (score > bestScore) {
+                bestScore = score;
+                best = offset;
+            }
+        }
+        return best;
+    }
+
+    // Resample by pitch, stretched -> output
+    void transpose() {
+        const size_t c = channels;
+        size_t available = stretched.frames();
+        if (std::fabs(pitch - 1.0) < 1e-9 && position == 0.0) {
+            std::memcpy(output.prepare(available), stretched.begin(), available * c * sizeof(float));
+            output.commit(available);
+            stretched.consume(available);
+            produced += available;
+            return;
+        }
+        if (available < 2)
+            return;
+
+        const float* src = stretched.begin();
+        size_t estimate = static_cast<size_t>((available - position) / pitch) + 2;
+        float* out = output.prepare(estimate);
+        size_t written = 0;
+        while (position + 1.0 < available && written < estimate) {
+            size_t index = static_cast<size_t>(position);
+            float frac = static_cast<float>(position - index);
+            const float* a = src + index * c;
+            for (size_t ch = 0; ch < c; ++ch)
+                out[written * c + ch] = a[ch] + frac * (a[ch + c] - a[ch]);
+            ++written;
+            position += pitch;
+        }
+        output.commit(written);
+        produced += written;
+
+        size_t consumed = std::min(static_cast<size_t>(position), available);
+        stretched.consume(consumed);
+        position -= consumed;
+    }
+
+    int sampleRate;
+    int channels;
+    double tempo;
+    double pitch;
+    double sequenceMs;
+    double seekWindowMs;
+    double overlapMs;
+    size_t sequenceFrames;
+    size_t overlapFrames;
+    size_t seekFrames;
+
+    DotEnergyKernel kernel;
+    FrameFifo input;
+    FrameFifo stretched;
+    FrameFifo output;
+    std::vector<float> midBuffer;
+    std::vector<float> reference;
+    std::vector<float> slope;
+
+    bool primed;
+    double skipFraction;
+    double position;       // Fractional read position for the resampler
+    double expectedOutput; // Output frames implied by the input so far
+    double produced;       // Output frames generated so far
+};
+
+#endif // WSOLA_H
@@ -1,224 +1,723 @@
 #include <QApplication>
+#include <QCoreApplication>
+#include <QCommandLineParser>
 #include <QWidget>
 #include <QAudioInput>
 #include <QAudioOutput>
 #include <QAudioFormat>
 #include <QIODevice>
 #include <QPushButton>
+#include <QCheckBox>
+#include <QFile>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QSlider>
+#include <QSpinBox>
 #include <QVBoxLayout>
 #include <QByteArray>
 #include <QBuffer>
 #include <QTimer>
-#include <cmath>
-#include <vector>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QTextStream>
+#include <QThread>
+
+#include "AudioEngine.h"
+#include "AudioProcessor.h"
+#include "BatchProcessor.h"
+#include "LatencyMeter.h"
+#include "OfflineRenderer.h"
+#include "VirtualAudioBackend.h"
+#include "WavFile.h"
+#include "dsp/AllocationHooks.h"
+
+#include <algorithm>
+#include <cstring>
 
-// Constants for pitch shifting
-const double PI = 3.14159265358979323846;
-const int SAMPLE_RATE = 44100; // 44.1 kHz
-const int CHANNELS = 1;        // Mono
-const int SAMPLE_SIZE = 16;    // 16 bits per sample
-
-// Simple Low-Pass Filter Implementation
-class LowPassFilter {
+// Main Application Window
+class VoiceChanger : public QWidget {
+    Q_OBJECT
 public:
-    LowPassFilter(double cutoffFrequency, double sampleRate) {
-        double RC = 1.0 / (2 * PI * cutoffFrequency);
-        alpha = 1.0 / (RC * sampleRate + 1.0);
-        prev = 0.0;
-    }
+    explicit VoiceChanger(const QString& chain = DEFAULT_CHAIN_SPEC,
+                          const AudioBackendOptions& backend = AudioBackendOptions(),
+                          QWidget* parent = nullptr)
+        : QWidget(parent), engine(chain, true, backend) {
+        // Set up UI
+        QVBoxLayout* layout = new QVBoxLayout(this);
+        QPushButton* startButton = new QPushButton("Start Voice Changer", this);
+        QPushButton* stopButton = new QPushButton("Stop Voice Changer", this);
+        QCheckBox* formantBox = new QCheckBox("Preserve formants (phase vocoder)", this);
+        QSpinBox* latencyBox = new QSpinBox(this);
+        latencyBox->setRange(MIN_TARGET_LATENCY_MS, MAX_TARGET_LATENCY_MS);
+        latencyBox->setSuffix(" ms");
+        latencyBox->setValue(settings.targetLatencyMs);
+
+        // Sweepable while running; the stages glide to each new value
+        QSlider* pitchSlider = new QSlider(Qt::Horizontal, this);
+        pitchSlider->setRange(50, 150); // Percent of the input pitch
+        pitchSlider->setValue(80);
+        pitchLabel = new QLabel(this);
+        QSlider* cutoffSlider = new QSlider(Qt::Horizontal, this);
+        cutoffSlider->setRange(100, 8000); // Hz
+        cutoffSlider->setValue(3400);
+        cutoffLabel = new QLabel(this);
+        QHBoxLayout* pitchRow = new QHBoxLayout;
+        pitchRow->addWidget(pitchSlider);
+        pitchRow->addWidget(pitchLabel);
+        QHBoxLayout* cutoffRow = new QHBoxLayout;
+        cutoffRow->addWidget(cutoffSlider);
+        cutoffRow->addWidget(cutoffLabel);
+
+        statsLabel = new QLabel(this);
+        callbackLabel = new QLabel(this);
+        QFormLayout* settingsForm = new QFormLayout;
+        settingsForm->addRow("Pitch", pitchRow);
+        settingsForm->addRow("Low-pass", cutoffRow);
+        settingsForm->addRow("Target latency", latencyBox);
+        layout->addWidget(startButton);
+        layout->addWidget(stopButton);
+        layout->addWidget(formantBox);
+        layout->addLayout(settingsForm);
+        layout->addWidget(statsLabel);
+        layout->addWidget(callbackLabel);
+        setLayout(layout);
 
-    double process(double input) {
-        double output = prev + (alpha * (input - prev));
-        prev = output;
-        return output;
-    }
+        // Poll the engine's counters; they are plain atomics
+        QTimer* statsTimer = new QTimer(this);
+        connect(statsTimer, &QTimer::timeout, this, &VoiceChanger::updateStats);
+        statsTimer->start(500);
+        updateStats();
 
-private:
-    double alpha;
-    double prev;
-};
+        // Connect Buttons
+        connect(startButton, &QPushButton::clicked, this, &VoiceChanger::startProcessing);
+        connect(stopButton, &QPushButton::clicked, this, &VoiceChanger::stopProcessing);
+        connect(formantBox, &QCheckBox::toggled, this, &VoiceChanger::setFormantPreservation);
+        connect(latencyBox, QOverload<int>::of(&QSpinBox::valueChanged),
+                this, &VoiceChanger::setTargetLatency);
+        connect(pitchSlider, &QSlider::valueChanged, this, &VoiceChanger::setPitch);
+        connect(cutoffSlider, &QSlider::valueChanged, this, &VoiceChanger::setCutoff);
+        // The chain's own settings (e.g. a preset's) hold until a slider moves
+        pitchLabel->setText(QString::asprintf("%.2fx", pitchSlider->value() / 100.0));
+        cutoffLabel->setText(QString::asprintf("%d Hz", cutoffSlider->value()));
+    }
 
-// Simple Pitch Shifting by Resampling (Not high quality)
-class PitchShifter {
-public:
-    PitchShifter(double pitchFactor) : factor(pitchFactor), phase(0.0) {}
-
-    // Simple resampling without windowing
-    double process(double input) {
-        buffer.push_back(input);
-        if (buffer.size() > static_cast<size_t>(1.0 / factor * SAMPLE_RATE)) {
-            double output = buffer.front();
-            buffer.erase(buffer.begin());
-            return output;
-        }
-        return 0.0; // Silence until buffer is filled
+private slots:
+    void startProcessing() {
+        engine.start();
     }
 
-private:
-    double factor; // Pitch factor (>1 higher pitch, <1 lower pitch)
-    double phase;
-    std::vector<double> buffer;
-};
+    void stopProcessing() {
+        engine.stop();
+    }
 
-// Custom QIODevice for audio processing
-class AudioProcessor : public QIODevice {
-    Q_OBJECT
-public:
-    AudioProcessor(QAudioFormat format, QObject* parent = nullptr)
-        : QIODevice(parent), format(format), filter(300.0, SAMPLE_RATE),
-          shifter(0.8) // Lower pitch by factor of 0.8
-    {
-        open(QIODevice::ReadWrite);
+    void setFormantPreservation(bool enabled) {
+        settings.pitchEngine = enabled ? AudioProcessor::PhaseVocoderPitch : AudioProcessor::GranularPitch;
+        settings.formants = enabled;
+        engine.setParameters(settings);
     }
 
-    // Start the device
-    void startProcessing() {
-        open(QIODevice::ReadWrite);
+    void setTargetLatency(int ms) {
+        settings.targetLatencyMs = ms;
+        engine.setParameters(settings);
     }
 
-    // Stop the device
-    void stopProcessing() {
-        close();
+    void setPitch(int percent) {
+        settings.pitchFactor = percent / 100.0f;
+        pitchLabel->setText(QString::asprintf("%.2fx", settings.pitchFactor));
+        engine.setParameters(settings);
     }
 
-    // Implement readData to provide processed audio to QAudioOutput
-    qint64 readData(char* data, qint64 maxlen) override {
-        if (outputBuffer.isEmpty())
-            return 0;
+    void setCutoff(int hz) {
+        settings.cutoffHz = static_cast<float>(hz);
+        cutoffLabel->setText(QString::asprintf("%d Hz", hz));
+        engine.setParameters(settings);
+    }
 
-        qint64 bytesToRead = qMin(maxlen, static_cast<qint64>(outputBuffer.size()));
-        memcpy(data, outputBuffer.constData(), bytesToRead);
-        outputBuffer.remove(0, bytesToRead);
-        return bytesToRead;
+    void updateStats() {
+        LatencyStats stats = engine.latencyStats();
+        statsLabel->setText(QString::asprintf("Buffered %.1f / %.1f ms + chain %.1f ms\n"
+                                              "Drift %+.0f ppm\n"
+                                              "Underruns %llu, overruns %llu, trims %llu",
+                                              stats.bufferedMs, stats.targetMs, stats.chainMs,
+                                              stats.driftPpm,
+                                              static_cast<unsigned long long>(stats.underruns),
+                                              static_cast<unsigned long long>(stats.overruns),
+                                              static_cast<unsigned long long>(stats.corrections)));
+
+        CallbackReport callbacks = engine.callbackReport();
+        callbackLabel->setText(QString::asprintf("Playback callback avg %.0f, p99 %.0f, max %.0f us\n"
+                                                 "Capture callback avg %.0f, p99 %.0f, max %.0f us",
+                                                 callbacks.playback.avgUs, callbacks.playback.p99Us,
+                                                 callbacks.playback.maxUs, callbacks.capture.avgUs,
+                                                 callbacks.capture.p99Us, callbacks.capture.maxUs));
     }
 
-    // Implement writeData to receive audio from QAudioInput
-    qint64 writeData(const char* data, qint64 len) override {
-        const qint16* samples = reinterpret_cast<const qint16*>(data);
-        int sampleCount = len / 2; // 16-bit audio
+private:
+    // The GUI's copy of the live settings; every change publishes all of it
+    ParameterSnapshot settings;
+    QLabel* pitchLabel;
+    QLabel* cutoffLabel;
+    QLabel* statsLabel;
+    QLabel* callbackLabel;
+
+    // Capture, DSP and playback run on the engine's own audio thread
+    AudioEngine engine;
+};
 
-        QByteArray processedData;
-        processedData.reserve(len);
+// Adds the effect chain options shared by every mode
+static void addChainOptions(QCommandLineParser& parser)
+{
+    parser.addOption(QCommandLineOption("chain", "Effect chain, e.g. \"pitch factor=0.8; lowpass cutoff=3400\".",
+                                        "spec", DEFAULT_CHAIN_SPEC));
+    parser.addOption(QCommandLineOption("chain-file", "Read the effect chain from a file, one stage per line.", "file"));
+    parser.addOption(QCommandLineOption("preset", "Use a named effect chain, e.g. vader (see --list-stages).", "name"));
+    parser.addOption(QCommandLineOption("list-stages", "List the available chain stages and presets and exit."));
+}
 
-        for (int i = 0; i < sampleCount; ++i) {
-            // Convert to double
-            double sample = samples[i] / 32768.0;
+// Resolves --chain/--chain-file/--preset and checks the description would build
+static bool readChainOption(const QCommandLineParser& parser, QString* chain)
+{
+    *chain = parser.value("chain");
+    if (parser.isSet("preset")) {
+        if (parser.isSet("chain") || parser.isSet("chain-file")) {
+            qCritical() << "--preset cannot be combined with --chain or --chain-file";
+            return false;
+        }
+        const ChainPreset* preset = findChainPreset(parser.value("preset").toStdString());
+        if (!preset) {
+            qCritical() << "Unknown preset" << parser.value("preset");
+            return false;
+        }
+        *chain = QString::fromUtf8(preset->spec);
+    }
+    if (parser.isSet("chain-file")) {
+        QFile file(parser.value("chain-file"));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qCritical() << "Cannot read" << file.fileName();
+            return false;
+        }
+        *chain = QString::fromUtf8(file.readAll());
+    }
 
-            // Apply pitch shifting
-            double pitchedSample = shifter.process(sample);
+    std::string error;
+    if (!EffectChain::check(chain->toStdString(), &error)) {
+        qCritical() << "Invalid effect chain:" << QString::fromStdString(error);
+        return false;
+    }
+    return true;
+}
 
-            // Apply low-pass filter
-            double filteredSample = filter.process(pitchedSample);
+static void listStages()
+{
+    QTextStream out(stdout);
+    for (const StageType& type : StageRegistry::instance().types())
+        out << QString::asprintf("%-12s %s\n%-12s settings: %s\n", type.name, type.description, "", type.keys);
+    out << "\nPresets (--preset):\n";
+    for (const ChainPreset& preset : CHAIN_PRESETS)
+        out << QString::asprintf("%-12s %s\n", preset.name, preset.description);
+}
 
-            // Convert back to 16-bit
-            qint16 outputSample = static_cast<qint16>(filteredSample * 32767.0);
-            processedData.append(reinterpret_cast<char*>(&outputSample), 2);
-        }
+// Adds the processing options shared by the file-based modes
+static void addProcessingOptions(QCommandLineParser& parser)
+{
+    addChainOptions(parser);
+    parser.addOption(QCommandLineOption("engine", "Override the pitch stage's engine: granular or vocoder.", "name"));
+    parser.addOption(QCommandLineOption("formants", "Preserve formants (vocoder engine only)."));
+    parser.addOption(QCommandLineOption("formant-shift", "Formant scaling with --formants.", "ratio", "1.0"));
+}
 
-        // Append processed data to output buffer
-        outputBuffer.append(processedData);
-        return len;
+static bool readProcessingOptions(const QCommandLineParser& parser, OfflineOptions* options)
+{
+    if (!readChainOption(parser, &options->chain))
+        return false;
+
+    QString engine = parser.value("engine");
+    if (engine == "vocoder") {
+        options->engine = AudioProcessor::PhaseVocoderPitch;
+    } else if (engine == "granular") {
+        options->engine = AudioProcessor::GranularPitch;
+    } else if (!engine.isEmpty()) {
+        qCritical() << "Unknown pitch engine" << engine;
+        return false;
     }
+    options->formants = parser.isSet("formants");
+    options->formantShift = parser.value("formant-shift").toDouble();
+    return true;
+}
 
-protected:
-    qint64 bytesAvailable() const override {
-        return QIODevice::bytesAvailable() + outputBuffer.size();
+// Headless mode: voiceChanger --offline -i in.wav -o out.wav
+static int runOffline(QCoreApplication& app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render a WAV file through the voice changer chain.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("offline", "Process a file instead of starting the GUI."));
+    parser.addOption(QCommandLineOption(QStringList() << "i" << "input", "Input WAV file.", "file"));
+    parser.addOption(QCommandLineOption(QStringList() << "o" << "output", "Output WAV file.", "file"));
+    addProcessingOptions(parser);
+    parser.process(app);
+
+    if (!parser.isSet("input") || !parser.isSet("output")) {
+        qCritical() << "--offline needs --input and --output";
+        return 2;
+    }
+    OfflineOptions options;
+    if (!readProcessingOptions(parser, &options))
+        return 2;
+
+    // Opening the output truncates it, so it must not be the input
+    QString source = QFileInfo(parser.value("input")).canonicalFilePath();
+    if (!source.isEmpty() && QFileInfo(parser.value("output")).canonicalFilePath() == source) {
+        qCritical() << "--output would overwrite --input" << parser.value("input");
+        return 2;
     }
 
-private:
-    QAudioFormat format;
-    LowPassFilter filter;
-    PitchShifter shifter;
-    QByteArray outputBuffer;
-};
+    OfflineRenderer renderer(options);
+    if (!renderer.render(parser.value("input"), parser.value("output"))) {
+        qCritical() << renderer.errorString();
+        return 1;
+    }
+    return 0;
+}
 
-// Main Application Window
-class VoiceChanger : public QWidget {
-    Q_OBJECT
-public:
-    VoiceChanger(QWidget* parent = nullptr) : QWidget(parent) {
-        // Set up UI
-        QVBoxLayout* layout = new QVBoxLayout(this);
-        QPushButton* startButton = new QPushButton("Start Voice Changer", this);
-        QPushButton* stopButton = new QPushButton("Stop Voice Changer", this);
-        layout->addWidget(startButton);
-        layout->addWidget(stopButton);
-        setLayout(layout);
+// Batch mode: voiceChanger --batch --output-dir out/ [--list files.txt] inputs...
+static int runBatch(QCoreApplication& app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render WAV files or directories through the voice changer chain in parallel.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("batch", "Process many files instead of starting the GUI."));
+    parser.addOption(QCommandLineOption("output-dir", "Directory for the rendered files.", "dir"));
+    parser.addOption(QCommandLineOption("list", "Text file with one input path per line.", "file"));
+    parser.addOption(QCommandLineOption("threads", "Worker threads (default: all cores).", "count",
+                                        QString::number(QThread::idealThreadCount())));
+    parser.addPositionalArgument("inputs", "WAV files or directories to process.", "[inputs...]");
+    addProcessingOptions(parser);
+    parser.process(app);
+
+    if (!parser.isSet("output-dir")) {
+        qCritical() << "--batch needs --output-dir";
+        return 2;
+    }
+    OfflineOptions options;
+    if (!readProcessingOptions(parser, &options))
+        return 2;
+
+    std::vector<BatchInput> inputs = BatchProcessor::collectInputs(parser.positionalArguments(),
+                                                                   parser.value("list"));
+    if (inputs.empty()) {
+        qCritical() << "No input files";
+        return 2;
+    }
 
-        // Setup Audio Format
-        QAudioFormat format;
-        format.setSampleRate(SAMPLE_RATE);
-        format.setChannelCount(CHANNELS);
-        format.setSampleSize(SAMPLE_SIZE);
-        format.setCodec("audio/pcm");
-        format.setByteOrder(QAudioFormat::LittleEndian);
-        format.setSampleType(QAudioFormat::SignedInt);
-
-        // Check if format is supported
-        QAudioDeviceInfo inputInfo = QAudioDeviceInfo::defaultInputDevice();
-        if (!inputInfo.isFormatSupported(format)) {
-            qWarning() << "Default format not supported, trying to use the nearest.";
-            format = inputInfo.nearestFormat(format);
-        }
+    BatchProcessor batch(options, parser.value("threads").toInt());
+    std::vector<BatchResult> results = batch.run(inputs, parser.value("output-dir"));
+    QTextStream out(stdout);
+    return batch.printReport(results, out) == 0 ? 0 : 1;
+}
 
-        QAudioDeviceInfo outputInfo = QAudioDeviceInfo::defaultOutputDevice();
-        if (!outputInfo.isFormatSupported(format)) {
-            qWarning() << "Default format not supported, trying to use the nearest.";
-            format = outputInfo.nearestFormat(format);
-        }
+// Latency mode: voiceChanger --measure-latency [--period 1024] [--chain ...]
+static int runMeasureLatency(QCoreApplication& app)
+{
+    LatencyMeterOptions defaults;
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure round-trip latency on a simulated loopback, without sound hardware.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("measure-latency", "Measure latency instead of starting the GUI."));
+    parser.addOption(QCommandLineOption("rate", "Sample rate in Hz.", "hz", QString::number(defaults.sampleRate)));
+    parser.addOption(QCommandLineOption("period", "Frames per device callback.", "frames",
+                                        QString::number(defaults.periodFrames)));
+    parser.addOption(QCommandLineOption("input-buffer", "Capture device buffer in frames.", "frames",
+                                        QString::number(defaults.inputBufferFrames)));
+    parser.addOption(QCommandLineOption("output-buffer", "Playback device buffer in frames.", "frames",
+                                        QString::number(defaults.outputBufferFrames)));
+    parser.addOption(QCommandLineOption("target-latency", "Jitter buffer target in ms.", "ms",
+                                        QString::number(defaults.targetLatencyMs)));
+    addChainOptions(parser);
+    parser.process(app);
+
+    LatencyMeterOptions options;
+    if (!readChainOption(parser, &options.chain))
+        return 2;
+    options.sampleRate = parser.value("rate").toInt();
+    options.periodFrames = parser.value("period").toInt();
+    options.inputBufferFrames = parser.value("input-buffer").toInt();
+    options.outputBufferFrames = parser.value("output-buffer").toInt();
+    options.targetLatencyMs = parser.value("target-latency").toInt();
+    if (options.sampleRate < 8000 || options.periodFrames < 1 || options.inputBufferFrames < 0
+        || options.outputBufferFrames < 0) {
+        qCritical() << "Invalid rate, period or buffer size";
+        return 2;
+    }
 
-        // Initialize Audio Processor
-        processor = new AudioProcessor(format, this);
+    LatencyMeter meter;
+    LatencyReport report;
+    if (!meter.measure(options, &report)) {
+        qCritical() << meter.errorString();
+        return 1;
+    }
+    QTextStream out(stdout);
+    LatencyMeter::print(report, out);
+    return 0;
+}
 
-        // Initialize Audio Input
-        audioInput = new QAudioInput(inputInfo, format, this);
-        audioInput->setBufferSize(4096);
+// Adds the audio device options shared by the live modes
+static void addBackendOptions(QCommandLineParser& parser, bool simulate)
+{
+    VirtualDeviceOptions defaults;
+    if (!simulate)
+        parser.addOption(QCommandLineOption("backend", "Audio backend: qt, virtual (simulated) or alsa (CONFIG+=alsa builds).",
+                                            "name", "qt"));
+    parser.addOption(QCommandLineOption("capture-period", "Virtual device: frames per capture callback.", "frames",
+                                        QString::number(defaults.capture.periodFrames)));
+    parser.addOption(QCommandLineOption("playback-period", "Virtual device: frames per playback callback.", "frames",
+                                        QString::number(defaults.playback.periodFrames)));
+    parser.addOption(QCommandLineOption("capture-rate", "Virtual device: capture sample rate, if not the playback's "
+                                        "(default: --virtual-input's rate).", "hz"));
+    parser.addOption(QCommandLineOption("capture-ppm", "Virtual device: capture clock error.", "ppm", "0"));
+    parser.addOption(QCommandLineOption("playback-ppm", "Virtual device: playback clock error.", "ppm", "0"));
+    parser.addOption(QCommandLineOption("jitter", "Virtual device: max callback lateness.", "ms", "0"));
+    parser.addOption(QCommandLineOption("seed", "Virtual device: scheduling jitter seed.", "n", "1"));
+    parser.addOption(QCommandLineOption("virtual-input", "Virtual device: WAV file to loop as the microphone.", "file"));
+    if (simulate)
+        return;
+
+    AlsaDeviceOptions alsa;
+    parser.addOption(QCommandLineOption("alsa-capture", "ALSA: capture PCM.", "pcm", alsa.captureDevice));
+    parser.addOption(QCommandLineOption("alsa-playback", "ALSA: playback PCM.", "pcm", alsa.playbackDevice));
+    parser.addOption(QCommandLineOption("alsa-period", "ALSA: frames per period (64-256).", "frames",
+                                        QString::number(alsa.periodFrames)));
+    parser.addOption(QCommandLineOption("alsa-periods", "ALSA: periods per buffer.", "count",
+                                        QString::number(alsa.periods)));
+}
 
-        // Initialize Audio Output
-        audioOutput = new QAudioOutput(outputInfo, format, this);
-        audioOutput->setBufferSize(4096);
+static bool readBackendOptions(const QCommandLineParser& parser, AudioBackendOptions* options, bool simulate)
+{
+    options->name = simulate ? QString("virtual") : parser.value("backend");
+    if (!audioBackendAvailable(options->name)) {
+        qCritical() << "Audio backend" << options->name << "is not available in this build";
+        return false;
+    }
 
-        // Connect Buttons
-        connect(startButton, &QPushButton::clicked, this, &VoiceChanger::startProcessing);
-        connect(stopButton, &QPushButton::clicked, this, &VoiceChanger::stopProcessing);
+    VirtualDeviceOptions& device = options->virtualDevice;
+    int capturePeriod = parser.value("capture-period").toInt();
+    int playbackPeriod = parser.value("playback-period").toInt();
+    if (capturePeriod < 1 || playbackPeriod < 1) {
+        qCritical() << "Invalid callback period";
+        return false;
+    }
+    device.capture.periodFrames = static_cast<size_t>(capturePeriod);
+    device.playback.periodFrames = static_cast<size_t>(playbackPeriod);
+    device.capture.ppm = parser.value("capture-ppm").toDouble();
+    device.playback.ppm = parser.value("playback-ppm").toDouble();
+    device.capture.jitterMs = device.playback.jitterMs = std::max(0.0, parser.value("jitter").toDouble());
+    device.seed = parser.value("seed").toUInt();
+
+    if (parser.isSet("virtual-input")) {
+        WavReader reader;
+        if (!reader.open(parser.value("virtual-input").toStdString())) {
+            qCritical() << QString::fromStdString(reader.errorString());
+            return false;
+        }
+        // The microphone runs at the file's rate; the engine resamples it
+        if (reader.sampleRate() != SAMPLE_RATE)
+            device.capture.sampleRate = reader.sampleRate();
+        int16_t chunk[4096];
+        while (size_t frames = reader.readMono(chunk, 4096))
+            device.input.insert(device.input.end(), chunk, chunk + frames);
     }
+    if (parser.isSet("capture-rate")) {
+        device.capture.sampleRate = parser.value("capture-rate").toDouble();
+        if (device.capture.sampleRate < 8000.0 || device.capture.sampleRate > 192000.0) {
+            qCritical() << "Invalid --capture-rate";
+            return false;
+        }
+    }
+    if (simulate)
+        return true;
+
+    AlsaDeviceOptions& alsa = options->alsaDevice;
+    alsa.captureDevice = parser.value("alsa-capture");
+    alsa.playbackDevice = parser.value("alsa-playback");
+    alsa.periodFrames = parser.value("alsa-period").toInt();
+    alsa.periods = parser.value("alsa-periods").toInt();
+    if (alsa.periodFrames < MIN_ALSA_PERIOD_FRAMES || alsa.periodFrames > MAX_ALSA_PERIOD_FRAMES) {
+        qCritical() << "Invalid --alsa-period, expected" << MIN_ALSA_PERIOD_FRAMES << "to"
+                    << MAX_ALSA_PERIOD_FRAMES << "frames";
+        return false;
+    }
+    if (alsa.periods < 2) {
+        qCritical() << "Invalid --alsa-periods, expected at least 2";
+        return false;
+    }
+    return true;
+}
 
-    ~VoiceChanger() {
-        stopProcessing();
+// Headless live mode: voiceChanger --headless --backend alsa --seconds 10
+// Runs the engine on a real (or ALSA null/file) device without the GUI and
+// prints the latency, callback and backend timing counters at the end.
+static int runHeadless(QCoreApplication& app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run the live audio path without the GUI.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("headless", "Run without the GUI."));
+    parser.addOption(QCommandLineOption("seconds", "How long to run.", "s", "10"));
+    parser.addOption(QCommandLineOption("target-latency", "Jitter buffer target in ms.", "ms", "40"));
+    addBackendOptions(parser, false);
+    addChainOptions(parser);
+    parser.process(app);
+
+    QString chain;
+    AudioBackendOptions backend;
+    if (!readChainOption(parser, &chain) || !readBackendOptions(parser, &backend, false))
+        return 2;
+    const double seconds = parser.value("seconds").toDouble();
+    if (!(seconds > 0.0)) {
+        qCritical() << "Invalid --seconds";
+        return 2;
     }
 
-private slots:
-    void startProcessing() {
-        if (!processor->isOpen()) {
-            processor->startProcessing();
+    AudioEngine engine(chain, true, backend);
+    ParameterSnapshot snapshot;
+    snapshot.targetLatencyMs = qBound(MIN_TARGET_LATENCY_MS, parser.value("target-latency").toInt(),
+                                      MAX_TARGET_LATENCY_MS);
+    engine.setParameters(snapshot);
+    engine.start();
+    QTimer::singleShot(static_cast<int>(seconds * 1000.0), &app, &QCoreApplication::quit);
+    app.exec();
+    engine.stop();
+
+    QTextStream out(stdout);
+    QString device = engine.backendReport();
+    if (!device.isEmpty())
+        out << device << "\n";
+    LatencyStats stats = engine.latencyStats();
+    out << QString::asprintf("Buffered %.1f / %.1f ms + chain %.1f ms + resampling %.1f ms, drift %+.0f ppm\n"
+                             "Underruns %llu, overruns %llu, trims %llu\n",
+                             stats.bufferedMs, stats.targetMs, stats.chainMs, stats.bridgeMs, stats.driftPpm,
+                             static_cast<unsigned long long>(stats.underruns),
+                             static_cast<unsigned long long>(stats.overruns),
+                             static_cast<unsigned long long>(stats.corrections));
+    CallbackReport callbacks = engine.callbackReport();
+    out << QString::asprintf("Playback callback avg %.0f, p99 %.0f, max %.0f us; "
+                             "capture avg %.0f, p99 %.0f, max %.0f us\n",
+                             callbacks.playback.avgUs, callbacks.playback.p99Us, callbacks.playback.maxUs,
+                             callbacks.capture.avgUs, callbacks.capture.p99Us, callbacks.capture.maxUs);
+    return 0;
+}
+
+// The GUI side of --simulate --flood-parameters: runs the engine on its
+// audio thread against the virtual device in real time for `seconds`,
+// while this thread stands in for a GUI whose controls never stop moving.
+// Every pass of its event loop publishes a new settings snapshot, sweeping
+// the pitch and cutoff sliders and toggling formant preservation (which
+// switches pitch engines) like VoiceChanger's slots do, reads the latency
+// stats as the status line does, and posts a burst of events so the loop
+// never goes idle. The jitter buffer target stays where `settings` put it.
+static int runParameterFlood(QCoreApplication& app, const QString& chain, AudioBackendOptions backend,
+                             ParameterSnapshot settings, double seconds, bool failOnUnderrun)
+{
+    backend.virtualDevice.realtime = true;
+    AudioEngine engine(chain, true, backend);
+    engine.setParameters(settings);
+    engine.start();
+
+    const int burst = 64;
+    quint64 published = 0;
+    QTimer flood;
+    QObject::connect(&flood, &QTimer::timeout, [&] {
+        settings.pitchFactor = 0.5f + static_cast<float>(published % 151) / 100.0f;
+        settings.cutoffHz = 200.0f + static_cast<float>(published * 37 % 7800);
+        if (published % 1000 == 0) {
+            settings.formants = (published / 1000) % 2 != 0;
+            settings.pitchEngine = settings.formants ? AudioProcessor::PhaseVocoderPitch
+                                                     : AudioProcessor::GranularPitch;
         }
+        engine.setParameters(settings);
+        ++published;
+        engine.latencyStats();
+        for (int i = 0; i < burst; ++i)
+            QCoreApplication::postEvent(&app, new QEvent(QEvent::User));
+    });
+    flood.start(0);
+    QTimer::singleShot(static_cast<int>(seconds * 1000.0), &app, &QCoreApplication::quit);
+    app.exec();
+    flood.stop();
+    engine.stop();
+
+    const quint64 xruns = engine.deviceXruns();
+    LatencyStats stats = engine.latencyStats();
+    CallbackReport callbacks = engine.callbackReport();
+    QTextStream out(stdout);
+    out << engine.backendReport() << "\n";
+    out << QString::asprintf("Jitter buffer: %llu underruns, %llu overruns, %llu trims, drift %+.0f ppm\n",
+                             static_cast<unsigned long long>(stats.underruns),
+                             static_cast<unsigned long long>(stats.overruns),
+                             static_cast<unsigned long long>(stats.corrections), stats.driftPpm);
+    out << QString::asprintf("Playback callback avg %.0f, p99 %.0f, max %.0f us; capture avg %.0f us\n",
+                             callbacks.playback.avgUs, callbacks.playback.p99Us, callbacks.playback.maxUs,
+                             callbacks.capture.avgUs);
+    out << QString::asprintf("Parameter flood: %llu snapshots and %llu events on the GUI thread in %.1f s, "
+                             "%llu callbacks touched the heap\n",
+                             static_cast<unsigned long long>(published),
+                             static_cast<unsigned long long>(published * burst), seconds,
+                             static_cast<unsigned long long>(callbacks.heapViolations));
+    out.flush();
+
+    if (failOnUnderrun && (stats.underruns || xruns))
+        return 1;
+    return 0;
+}
 
-        audioInput->start(processor);
-        audioOutput->start(processor);
-        qDebug() << "Voice Changer Started.";
+// Simulation mode: voiceChanger --simulate [--seconds 60] [--jitter 5] ...
+// Runs the live path on the virtual device as fast as possible and reports
+// what a real device with those callbacks would have produced. Identical
+// options give identical counters, so a run can gate CI. --flood-parameters
+// runs in real time instead (see runParameterFlood).
+static int runSimulation(QCoreApplication& app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run the live audio path on a simulated device, without sound hardware.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("simulate", "Simulate instead of starting the GUI."));
+    parser.addOption(QCommandLineOption("seconds", "Simulated audio to run.", "s", "10"));
+    parser.addOption(QCommandLineOption("target-latency", "Jitter buffer target in ms.", "ms", "40"));
+    parser.addOption(QCommandLineOption("fail-on-underrun", "Exit with 1 if playback ran dry after priming."));
+    parser.addOption(QCommandLineOption("flood-parameters", "Run in real time on the audio thread while this "
+                                        "thread publishes setting changes and floods its event loop, like a GUI "
+                                        "that never stops moving; --seconds is then wall-clock time."));
+    addBackendOptions(parser, true);
+    addChainOptions(parser);
+    parser.process(app);
+
+    QString chain;
+    AudioBackendOptions backend;
+    if (!readChainOption(parser, &chain) || !readBackendOptions(parser, &backend, true))
+        return 2;
+    backend.virtualDevice.realtime = false;
+    const double seconds = parser.value("seconds").toDouble();
+    if (!(seconds > 0.0)) {
+        qCritical() << "Invalid --seconds";
+        return 2;
     }
 
-    void stopProcessing() {
-        audioInput->stop();
-        audioOutput->stop();
-        processor->stopProcessing();
-        qDebug() << "Voice Changer Stopped.";
-    }
+    ParameterSnapshot snapshot;
+    snapshot.targetLatencyMs = qBound(MIN_TARGET_LATENCY_MS, parser.value("target-latency").toInt(),
+                                      MAX_TARGET_LATENCY_MS);
+    if (parser.isSet("flood-parameters"))
+        return runParameterFlood(app, chain, backend, snapshot, seconds, parser.isSet("fail-on-underrun"));
+
+    AudioParameters parameters;
+    parameters.write(snapshot);
+    SampleJitterBuffer jitter(JITTER_BUFFER_FRAMES, 0);
+    DriftCompensator compensator(&jitter, SAMPLE_RATE);
+    CallbackMonitors monitors;
+    AudioWorker worker(chain, &parameters, &jitter, &compensator, &monitors, false, backend);
+    worker.start();
+    VirtualAudioBackend* device = static_cast<VirtualAudioBackend*>(worker.audioBackend());
+    if (!device)
+        return 1;
+
+    QElapsedTimer wallClock;
+    wallClock.start();
+    device->run(seconds);
+    const double elapsed = wallClock.nsecsElapsed() * 1e-9;
+    worker.stop();
+
+    VirtualAudioBackend::Stats deviceStats = device->statistics();
+    SampleJitterBuffer::Stats jitterStats = jitter.stats();
+    CallbackStats::Summary playback = monitors.playback.summary();
+    CallbackStats::Summary capture = monitors.capture.summary();
+    const double periodUs = backend.virtualDevice.playback.periodFrames * 1e6 / worker.sampleRate();
+    QTextStream out(stdout);
+    out << QString::asprintf("Simulated %.1f s in %.2f s (%.0fx real time), seed %u\n", deviceStats.seconds,
+                             elapsed, deviceStats.seconds / std::max(elapsed, 1e-9), backend.virtualDevice.seed);
+    out << QString::asprintf("Callbacks: %llu capture, %llu playback, latest %.1f ms late\n",
+                             static_cast<unsigned long long>(deviceStats.captureCallbacks),
+                             static_cast<unsigned long long>(deviceStats.playbackCallbacks),
+                             deviceStats.maxLatenessMs);
+    out << QString::asprintf("Device: %llu capture overruns, %llu playback underruns\n",
+                             static_cast<unsigned long long>(deviceStats.deviceOverruns),
+                             static_cast<unsigned long long>(deviceStats.deviceUnderruns));
+    out << QString::asprintf("Jitter buffer: %llu underruns, %llu overruns, %llu trims, %llu frames padded\n",
+                             static_cast<unsigned long long>(jitterStats.underruns),
+                             static_cast<unsigned long long>(jitterStats.overruns),
+                             static_cast<unsigned long long>(jitterStats.corrections),
+                             static_cast<unsigned long long>(jitterStats.paddedFrames));
+    out << QString::asprintf("Drift correction %+.0f ppm\n", compensator.correctionPpm());
+    if (worker.captureRate() != worker.sampleRate())
+        out << QString::asprintf("Capture resampled from %d to %d Hz, %.1f ms delay\n", worker.captureRate(),
+                                 worker.sampleRate(), worker.bridgeLatency() * 1000.0 / worker.sampleRate());
+    out << QString::asprintf("Playback callback avg %.0f, p99 %.0f, max %.0f us; capture avg %.0f us\n",
+                             playback.avgUs, playback.p99Us, playback.maxUs, capture.avgUs);
+    out << QString::asprintf("CPU headroom: %.1f%% at p99, %.1f%% worst case, of a %.0f us period\n",
+                             100.0 * (1.0 - playback.p99Us / periodUs),
+                             100.0 * (1.0 - playback.maxUs / periodUs), periodUs);
+    worker.shutdown();
+
+    if (parser.isSet("fail-on-underrun") && (jitterStats.underruns || deviceStats.deviceUnderruns))
+        return 1;
+    return 0;
+}
 
-private:
-    QAudioInput* audioInput;
-    QAudioOutput* audioOutput;
-    AudioProcessor* processor;
-};
+static bool hasArgument(int argc, char* argv[], const char* name)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0)
+            return true;
+    }
+    return false;
+}
 
 int main(int argc, char *argv[])
 {
+    if (hasArgument(argc, argv, "--list-stages")) {
+        listStages();
+        return 0;
+    }
+
+    // File processing needs neither a display nor a sound card
+    if (hasArgument(argc, argv, "--offline")) {
+        QCoreApplication app(argc, argv);
+        return runOffline(app);
+    }
+    if (hasArgument(argc, argv, "--batch")) {
+        QCoreApplication app(argc, argv);
+        return runBatch(app);
+    }
+    if (hasArgument(argc, argv, "--measure-latency")) {
+        QCoreApplication app(argc, argv);
+        return runMeasureLatency(app);
+    }
+    if (hasArgument(argc, argv, "--simulate")) {
+        QCoreApplication app(argc, argv);
+        return runSimulation(app);
+    }
+    if (hasArgument(argc, argv, "--headless")) {
+        QCoreApplication app(argc, argv);
+        return runHeadless(app);
+    }
+
     QApplication app(argc, argv);
 
-    VoiceChanger window;
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Real-time voice changer.");
+    parser.addHelpOption();
+    addChainOptions(parser);
+    addBackendOptions(parser, false);
+    parser.process(app);
+    QString chain;
+    AudioBackendOptions backend;
+    if (!readChainOption(parser, &chain) || !readBackendOptions(parser, &backend, false))
+        return 2;
+
+    VoiceChanger window(chain, backend);
     window.setWindowTitle("Darth Vader Voice Changer");
-    window.resize(300, 100);
+    window.resize(320, 300);
     window.show();
 
     return app.exec();
@@ -6,24 +6,26 @@
 #include <QIODevice>
 #include <QPushButton>
 #include <QVBoxLayout>
-#include <QByteArray>
 #include <QDebug>
 
-#include <SoundTouch.h>
-using namespace soundtouch;
+#include "AllocationCounter.h"
+#include "AllocationHooks.h"
+#include "Wsola.h"
 
-// Custom QIODevice for audio processing with SoundTouch
+// Custom QIODevice for audio processing with the in-tree WSOLA stretcher
 class AudioProcessor : public QIODevice {
     Q_OBJECT
 public:
     AudioProcessor(QAudioFormat format, QObject* parent = nullptr)
-        : QIODevice(parent), format(format), soundTouch()
+        : QIODevice(parent), format(format), stretcher(),
+          readAllocations("AudioProcessor::readData"),
+          writeAllocations("AudioProcessor::writeData")
     {
-        // Configure SoundTouch
-        soundTouch.setSampleRate(format.sampleRate());
-        soundTouch.setChannels(format.channelCount());
-        soundTouch.setPitch(0.8f); // Lower pitch by factor
-        soundTouch.setTempo(1.0f); // Normal tempo
+        // Configure the stretcher (same calls as SoundTouch)
+        stretcher.setSampleRate(format.sampleRate());
+        stretcher.setChannels(format.channelCount());
+        stretcher.setPitch(0.8f); // Lower pitch by factor
+        stretcher.setTempo(1.0f); // Normal tempo
 
         open(QIODevice::ReadWrite);
     }
@@ -35,39 +37,39 @@ public:
 
     // Stop the device
     void stopProcessing() {
-        soundTouch.flush();
+        stretcher.flush();
         close();
+        readAllocations.report(stderr);
+        writeAllocations.report(stderr);
     }
 
-    // Implement readData to provide processed audio to QAudioOutput
+    // Implement readData to provide processed audio to QAudioOutput; the
+    // stretcher converts its output straight into Qt's buffer
     qint64 readData(char* data, qint64 maxlen) override {
-        int16_t buffer[4096];
-        int numSamples = soundTouch.receiveSamples(buffer, maxlen / (2 * format.channelCount()));
-
-        if (numSamples > 0) {
-            QByteArray processedData(reinterpret_cast<char*>(buffer), numSamples * 2 * format.channelCount());
-            qint64 bytesToRead = qMin(maxlen, static_cast<qint64>(processedData.size()));
-            memcpy(data, processedData.constData(), bytesToRead);
-            return bytesToRead;
-        }
-
-        return 0;
+        ALLOCATION_SCOPE(readAllocations);
+        qint64 frameBytes = 2 * format.channelCount();
+        size_t numFrames = stretcher.receiveSamples(reinterpret_cast<int16_t*>(data),
+                                                    static_cast<size_t>(maxlen / frameBytes));
+        return static_cast<qint64>(numFrames) * frameBytes;
     }
 
     // Implement writeData to receive audio from QAudioInput
     qint64 writeData(const char* data, qint64 len) override {
-        soundTouch.putSamples(reinterpret_cast<const SAMPLETYPE*>(data), len / (2 * format.channelCount()));
+        ALLOCATION_SCOPE(writeAllocations);
+        stretcher.putSamples(reinterpret_cast<const int16_t*>(data), len / (2 * format.channelCount()));
         return len;
     }
 
 protected:
     qint64 bytesAvailable() const override {
-        return QIODevice::bytesAvailable() + soundTouch.numSamples();
+        return QIODevice::bytesAvailable() + stretcher.numSamples();
     }
 
 private:
     QAudioFormat format;
-    SoundTouch soundTouch;
+    Wsola stretcher;
+    AllocationProbe readAllocations;
+    AllocationProbe writeAllocations;
 };
 
 // Main Application Window
@@ -5,12 +5,21 @@ TEMPLATE = app
 
 CONFIG += c++17
 
+# Debug builds guard the heap inside the audio callbacks: any malloc/free
+# there aborts (VOICECHANGER_ALLOCATION_GUARD=record only counts it)
+CONFIG(debug, debug|release): DEFINES += VOICECHANGER_COUNT_ALLOCATIONS
+
 SOURCES += main.cpp
 
-HEADERS +=
+HEADERS += ../dsp/AllocationCounter.h \
+           ../dsp/AllocationHooks.h \
+           ../dsp/Correlation.h \
+           ../dsp/SampleConvert.h \
+           ../dsp/Simd.h \
+           ../dsp/Wsola.h
 
-INCLUDEPATH += /Users/macbook2015/Desktop/brew/include/soundtouch
+INCLUDEPATH += ../dsp
 
 
-LIBS += -L/Users/macbook2015/Desktop/brew/lib -lsoundtouch
+LIBS +=
 
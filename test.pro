@@ -5,9 +5,64 @@ TEMPLATE = app
 
 CONFIG += c++17
 
+# Debug builds guard the heap inside the audio callbacks: any malloc/free
+# there aborts (VOICECHANGER_ALLOCATION_GUARD=record only counts it)
+CONFIG(debug, debug|release): DEFINES += VOICECHANGER_COUNT_ALLOCATIONS
+
+# Direct ALSA mmap backend (--backend alsa): qmake CONFIG+=alsa
+alsa {
+    DEFINES += VOICECHANGER_ALSA
+    LIBS += -lasound
+}
+
 SOURCES += main.cpp
 
-HEADERS +=
+HEADERS += AlsaAudioBackend.h \
+           AudioBackend.h \
+           AudioDevices.h \
+           AudioEngine.h \
+           AudioProcessor.h \
+           BatchProcessor.h \
+           LatencyMeter.h \
+           OfflineRenderer.h \
+           VirtualAudioBackend.h \
+           WavFile.h \
+           dsp/AllocationCounter.h \
+           dsp/AllocationHooks.h \
+           dsp/Biquad.h \
+           dsp/BreathGenerator.h \
+           dsp/CallbackStats.h \
+           dsp/Convolver.h \
+           dsp/Correlation.h \
+           dsp/DelayLine.h \
+           dsp/Distortion.h \
+           dsp/DriftCompensator.h \
+           dsp/DriftResampler.h \
+           dsp/DspMath.h \
+           dsp/DspStage.h \
+           dsp/EffectChain.h \
+           dsp/Fft.h \
+           dsp/FilterStage.h \
+           dsp/FormatConvert.h \
+           dsp/Gain.h \
+           dsp/HelmetResonator.h \
+           dsp/JitterBuffer.h \
+           dsp/LatencyProbe.h \
+           dsp/LivePath.h \
+           dsp/LowPassFilter.h \
+           dsp/PhaseVocoder.h \
+           dsp/PitchShifter.h \
+           dsp/PitchStage.h \
+           dsp/PolyphaseResampler.h \
+           dsp/Reverb.h \
+           dsp/RingModulator.h \
+           dsp/SampleConvert.h \
+           dsp/Simd.h \
+           dsp/SmoothedValue.h \
+           dsp/SpscRingBuffer.h \
+           dsp/StateVariableFilter.h \
+           dsp/TripleBuffer.h \
+           dsp/VirtualClock.h
 
 INCLUDEPATH += 
 